@@ -8,16 +8,37 @@
 #include <nanobench.h>
 #include <aho-corasick-cjgdev.hpp>
 #include <ac/ahocorasick.h>
+#include <ac/utils/decompress.h>
 
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 #include <fstream>
+#include <memory_resource>
+#include <random>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+#if defined(AC_WITH_ZLIB)
+#include <zlib.h>
+#endif
 
 size_t ac_nfa (std::string &text, AhoCorasick<automaton::NFA> & searcher)
 {
         return searcher.find_all (text).size();
 }
 
+size_t ac_contiguous_nfa (std::string &text, AhoCorasick<automaton::ContiguousNFA> &searcher)
+{
+        return searcher.find_all (text).size ();
+}
+
+size_t ac_lazy_dfa (std::string &text, AhoCorasick<automaton::LazyDFA<automaton::ContiguousNFA>> &searcher)
+{
+        return searcher.find_all (text).size ();
+}
+
 size_t ac_cjgdev (std::string &text, aho_corasick::trie &searcher)
 {
         return searcher.parse_text (text).size ();
@@ -135,5 +156,489 @@ int main (int argc, char **argv)
           auto res = ac_nfa (text, searcher);
           ankerl::nanobench::doNotOptimizeAway (res);
         });
+
+        AhoCorasick<automaton::ContiguousNFA> contiguous_searcher (patterns, MatchKind::STANDARD);
+        add_benchmark ("lfreist/aho-corasick (ContiguousNFA)", [&contiguous_searcher, &text] ()
+        {
+          auto res = ac_contiguous_nfa (text, contiguous_searcher);
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+
+        add_benchmark ("lfreist/aho-corasick (ContiguousNFA, for_each_match)", [&contiguous_searcher, &text] ()
+        {
+          size_t res = 0;
+          contiguous_searcher.for_each_match (text, [&res] (const Match &)
+          { ++res; });
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+
+        AhoCorasick<automaton::LazyDFA<automaton::ContiguousNFA>> lazy_dfa_searcher (patterns, MatchKind::STANDARD);
+        add_benchmark ("lfreist/aho-corasick (LazyDFA)", [&lazy_dfa_searcher, &text] ()
+        {
+          auto res = ac_lazy_dfa (text, lazy_dfa_searcher);
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+
+        // line mode: the line of every match, once by a newline scan after searching and once by find_lines
+        ankerl::nanobench::Bench line_bench;
+        line_bench.title ("Aho-Corasick Line Mode")
+                .unit ("byte")
+                .batch (text.size ())
+                .relative (true);
+        line_bench.run ("find_iter + newline scan", [&contiguous_searcher, &text] ()
+        {
+          size_t line_number = 1;
+          size_t scanned = 0;
+          size_t res = 0;
+          for (const auto &match : contiguous_searcher.find_iter (text))
+                  {
+                          for (; scanned < match.start; ++scanned)
+                                  {
+                                          line_number += text[scanned] == '\n';
+                                  }
+                          res += line_number;
+                  }
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+        line_bench.run ("find_lines", [&contiguous_searcher, &text] ()
+        {
+          size_t res = 0;
+          for (const auto &match : contiguous_searcher.find_lines (text))
+                  {
+                          res += match.line_number;
+                  }
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+        line_bench.run ("find_lines (first match per line)", [&contiguous_searcher, &text] ()
+        {
+          size_t res = 0;
+          for (const auto &match : contiguous_searcher.find_lines (text, true))
+                  {
+                          res += match.line_number;
+                  }
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+
+        // construction: the patterns above and a dictionary of all distinct ASCII words of the text
+        std::set<std::string> distinct_words;
+        std::istringstream words_stream (text);
+        for (std::string word; words_stream >> word;)
+                {
+                        if (std::all_of (word.begin (), word.end (), [] (char c)
+                        { return static_cast<unsigned char>(c) < 128; }))
+                                {
+                                        distinct_words.insert (word);
+                                }
+                }
+        std::vector<std::string> words (distinct_words.begin (), distinct_words.end ());
+
+        // pattern groups: the distinct words split into 64 groups, only one of them active
+        PatternSet grouped_words;
+        for (size_t i = 0; i < words.size (); ++i)
+                {
+                        grouped_words.add (words[i], static_cast<GroupID>(i % MAX_GROUPS));
+                }
+        AhoCorasick<automaton::ContiguousNFA> grouped_searcher (grouped_words, BuildConfig{});
+        ankerl::nanobench::Bench group_bench;
+        group_bench.title ("Aho-Corasick Pattern Groups (" + std::to_string (words.size ()) + " words, 64 groups)")
+                .unit ("byte")
+                .batch (text.size ())
+                .relative (true);
+        group_bench.run ("all groups, filtered afterwards", [&grouped_searcher, &grouped_words, &text] ()
+        {
+          size_t res = 0;
+          grouped_searcher.for_each_match (text, [&res, &grouped_words] (const Match &match)
+          { res += grouped_words.group (match.pattern) == 0; });
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+        group_bench.run ("group mask", [&grouped_searcher, &text] ()
+        {
+          size_t res = 0;
+          grouped_searcher.for_each_match (text, [&res] (const Match &)
+          { ++res; }, GroupMask{1});
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+
+        // whole words: e.g. "hat" must not match within "that"
+        AhoCorasick<automaton::ContiguousNFA> word_searcher (patterns, BuildConfig{});
+        auto whole_word_searcher = AhoCorasickBuilder ().whole_words (true).build<automaton::ContiguousNFA> (patterns);
+        WordBoundary boundary ("");
+        ankerl::nanobench::Bench word_bench;
+        word_bench.title ("Aho-Corasick Whole Words").unit ("byte").batch (text.size ()).relative (true);
+        word_bench.run ("all matches, filtered afterwards", [&word_searcher, &boundary, &text] ()
+        {
+          size_t res = 0;
+          word_searcher.for_each_match (text, [&res, &boundary, &text] (const Match &match)
+          { res += boundary.allows (text, match.start, match.end); });
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+        word_bench.run ("whole_words", [&whole_word_searcher, &text] ()
+        {
+          size_t res = 0;
+          whole_word_searcher.for_each_match (text, [&res] (const Match &)
+          { ++res; });
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+
+        // anchored lookups: the longest pattern that is a prefix of every word, once by an unanchored search and once
+        //  by an anchored one
+        AhoCorasick<automaton::ContiguousNFA> longest_searcher (patterns, MatchKind::LEFTMOST_LONGEST);
+        ankerl::nanobench::Bench prefix_bench;
+        prefix_bench.title ("Aho-Corasick Longest Prefix (" + std::to_string (words.size ()) + " words)")
+                .unit ("word")
+                .batch (words.size ())
+                .relative (true);
+        prefix_bench.run ("find_iter, match at 0", [&longest_searcher, &words] ()
+        {
+          size_t res = 0;
+          for (const auto &word : words)
+                  {
+                          for (const auto &match : longest_searcher.find_iter (word))
+                                  {
+                                          res += match.start == 0 ? match.end : 0;
+                                          break;
+                                  }
+                  }
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+        prefix_bench.run ("longest_prefix", [&longest_searcher, &words] ()
+        {
+          size_t res = 0;
+          for (const auto &word : words)
+                  {
+                          auto match = longest_searcher.longest_prefix (word);
+                          res += match ? match->end : 0;
+                  }
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+
+        // memory resources: building the word dictionary in an arena, searching its tables backed by huge pages
+        ankerl::nanobench::Bench arena_bench;
+        arena_bench.title ("Aho-Corasick Construction in an Arena (" + std::to_string (words.size ()) + " words)")
+                .unit ("pattern")
+                .batch (words.size ())
+                .relative (true);
+        arena_bench.run ("NFA, default resource", [&words] ()
+        {
+          automaton::NFA nfa (words, BuildConfig{});
+          ankerl::nanobench::doNotOptimizeAway (nfa.start_state ());
+        });
+        arena_bench.run ("NFA, monotonic_buffer_resource", [&words] ()
+        {
+          std::pmr::monotonic_buffer_resource arena;
+          BuildConfig config;
+          config.memory_resource = &arena;
+          automaton::NFA nfa (words, config);
+          ankerl::nanobench::doNotOptimizeAway (nfa.start_state ());
+        });
+        auto huge_searcher = AhoCorasickBuilder ().huge_pages (true).build<automaton::NFA> (words);
+        auto small_searcher = AhoCorasickBuilder ().build<automaton::NFA> (words);
+        ankerl::nanobench::Bench huge_bench;
+        huge_bench.title ("Aho-Corasick Huge Pages (NFA, " + std::to_string (words.size ()) + " words)")
+                .unit ("byte")
+                .batch (text.size ())
+                .relative (true);
+        for (auto *searcher : {&small_searcher, &huge_searcher})
+                {
+                        huge_bench.run (searcher == &huge_searcher ? "huge pages" : "default resource",
+                                        [searcher, &text] ()
+                                        {
+                                          size_t res = 0;
+                                          searcher->for_each_match (text, [&res] (const Match &)
+                                          { ++res; });
+                                          ankerl::nanobench::doNotOptimizeAway (res);
+                                        });
+                }
+
+        // interleaved search: the states of the word dictionary do not fit into the cache
+        ankerl::nanobench::Bench interleaved_bench;
+        interleaved_bench.title ("Aho-Corasick Interleaved Search (NFA, " + std::to_string (words.size ()) + " words)")
+                .unit ("byte")
+                .batch (text.size ())
+                .relative (true);
+        interleaved_bench.run ("for_each_match", [&small_searcher, &text] ()
+        {
+          size_t res = 0;
+          small_searcher.for_each_match (text, [&res] (const Match &)
+          { ++res; });
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+        interleaved_bench.run ("for_each_match_interleaved<4>", [&small_searcher, &text] ()
+        {
+          size_t res = 0;
+          small_searcher.for_each_match_interleaved<4> (text, [&res] (const Match &)
+          { ++res; });
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+        interleaved_bench.run ("for_each_match_interleaved<8>", [&small_searcher, &text] ()
+        {
+          size_t res = 0;
+          small_searcher.for_each_match_interleaved<8> (text, [&res] (const Match &)
+          { ++res; });
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+
+        // histogram: match counts by pattern instead of the matches
+        ankerl::nanobench::Bench histogram_bench;
+        histogram_bench.title ("Aho-Corasick Match Histogram (NFA, " + std::to_string (words.size ()) + " words)")
+                .unit ("byte")
+                .batch (text.size ())
+                .relative (true);
+        histogram_bench.run ("find_all + unordered_map", [&small_searcher, &text] ()
+        {
+          std::unordered_map<std::string, size_t> counts;
+          for (const auto &result : small_searcher.find_all (text))
+                  {
+                          ++counts[result.match];
+                  }
+          ankerl::nanobench::doNotOptimizeAway (counts);
+        });
+        histogram_bench.run ("match_histogram", [&small_searcher, &text] ()
+        {
+          auto counts = small_searcher.match_histogram (text);
+          ankerl::nanobench::doNotOptimizeAway (counts);
+        });
+        histogram_bench.run ("match_histogram, all threads", [&small_searcher, &text] ()
+        {
+          auto counts = small_searcher.match_histogram (text, 0);
+          ankerl::nanobench::doNotOptimizeAway (counts);
+        });
+
+        // budgeted search: the cost of splitting a search into calls of 64 KiB
+        ankerl::nanobench::Bench budget_bench;
+        budget_bench.title ("Aho-Corasick Budgeted Search (NFA, " + std::to_string (words.size ()) + " words)")
+                .unit ("byte")
+                .batch (text.size ())
+                .relative (true);
+        budget_bench.run ("for_each_match", [&small_searcher, &text] ()
+        {
+          size_t res = 0;
+          small_searcher.for_each_match (text, [&res] (const Match &)
+          { ++res; });
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+        budget_bench.run ("find_budgeted, 64 KiB per call", [&small_searcher, &text] ()
+        {
+          size_t res = 0;
+          SearchCursor cursor;
+          SearchBudget budget;
+          budget.max_bytes = size_t{1} << 16;
+          while (!cursor.done ())
+            {
+              res += small_searcher.find_budgeted (text, cursor, budget).size ();
+            }
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+
+        // result cache: 20000 records of 200 bytes, each of 2000 distinct ones repeats 10 times
+        std::vector<std::string_view> records;
+        for (size_t i = 0; i < 20000; ++i)
+                {
+                        records.push_back (std::string_view (text).substr ((i * 7919 % 2000) * 200, 200));
+                }
+        ResultCache result_cache;
+        ankerl::nanobench::Bench cache_bench;
+        cache_bench.title ("Aho-Corasick Result Cache (NFA, " + std::to_string (words.size ()) + " words)")
+                .unit ("record")
+                .batch (records.size ())
+                .relative (true);
+        cache_bench.run ("find_matches", [&small_searcher, &records] ()
+        {
+          size_t res = 0;
+          for (auto record : records)
+            {
+              res += small_searcher.find_matches (record).size ();
+            }
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+        cache_bench.run ("find_cached", [&small_searcher, &records, &result_cache] ()
+        {
+          size_t res = 0;
+          for (auto record : records)
+            {
+              res += small_searcher.find_cached (record, result_cache).size ();
+            }
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+
+        // state layout: the states visited most by the first quarter of the text stored first
+        auto layout_builder = AhoCorasickBuilder ().prefilter (false);
+        auto bfs_searcher = layout_builder.build<automaton::ContiguousNFA> (words);
+        std::vector<std::string_view> layout_samples {std::string_view (text).substr (0, text.size () / 4)};
+        StateLayout layout = bfs_searcher.automaton ().profile (layout_samples);
+        auto profiled_searcher = layout_builder.state_layout (&layout).build<automaton::ContiguousNFA> (words);
+        ankerl::nanobench::Bench layout_bench;
+        layout_bench.title ("Aho-Corasick State Layout (ContiguousNFA, " + std::to_string (words.size ()) + " words)")
+                .unit ("byte")
+                .batch (text.size ())
+                .relative (true);
+        for (auto *searcher : {&bfs_searcher, &profiled_searcher})
+                {
+                        layout_bench.run (searcher == &bfs_searcher ? "breadth first" : "profiled",
+                                          [searcher, &text] ()
+                                          {
+                                            size_t res = 0;
+                                            searcher->for_each_match (text, [&res] (const Match &)
+                                            { ++res; });
+                                            ankerl::nanobench::doNotOptimizeAway (res);
+                                          });
+                }
+
+        // long patterns: every 2048th 16 byte slice of the text, for which windows are shifted (see Prefilter)
+        std::vector<std::string> signatures;
+        for (size_t pos = 0; pos + 16 <= text.size (); pos += 2048)
+                {
+                        signatures.push_back (text.substr (pos, 16));
+                }
+        ankerl::nanobench::Bench skip_bench;
+        skip_bench.title ("Aho-Corasick Long Patterns (" + std::to_string (signatures.size ()) + " x 16 bytes)")
+                .unit ("byte")
+                .batch (text.size ())
+                .relative (true);
+        for (bool prefilter : {false, true})
+                {
+                        auto searcher = AhoCorasickBuilder ().prefilter (prefilter).build (signatures);
+                        skip_bench.run (prefilter ? "shifted window" : "no prefilter", [&searcher, &text] ()
+                        {
+                          size_t res = 0;
+                          searcher.for_each_match (text, [&res] (const Match &)
+                          { ++res; });
+                          ankerl::nanobench::doNotOptimizeAway (res);
+                        });
+                }
+
+        // KB long signatures: every 64th 2 KB slice of the text, inserted fully vs. by their first 32 bytes
+        std::vector<std::string> kb_signatures;
+        for (size_t pos = 0; pos + 2048 <= text.size (); pos += 64 * 2048)
+                {
+                        kb_signatures.push_back (text.substr (pos, 2048));
+                }
+        ankerl::nanobench::Bench anchor_bench;
+        anchor_bench.title ("Aho-Corasick Long Pattern Anchors (" + std::to_string (kb_signatures.size ())
+                            + " x 2 KB, construction and search)")
+                .unit ("byte")
+                .batch (text.size ())
+                .relative (true);
+        for (size_t threshold : {size_t{0}, size_t{32}})
+                {
+                        anchor_bench.run (threshold == 0 ? "full patterns" : "32 byte anchors",
+                                          [threshold, &kb_signatures, &text] ()
+                                          {
+                                            auto searcher = AhoCorasickBuilder ().prefilter (false)
+                                                .long_pattern_threshold (threshold).build (kb_signatures);
+                                            size_t res = 0;
+                                            searcher.for_each_match (text, [&res] (const Match &)
+                                            { ++res; });
+                                            ankerl::nanobench::doNotOptimizeAway (res);
+                                          });
+                }
+
+        // small alphabet: 16-mers of a random DNA sequence, read one byte or two bytes per lookup by a lazy DFA
+        std::mt19937 dna_rng (42);
+        std::string dna (text.size (), 'A');
+        for (auto &c : dna)
+                {
+                        c = "ACGT"[dna_rng () % 4];
+                }
+        std::vector<std::string> kmers;
+        for (size_t i = 0; i < 64; ++i)
+                {
+                        kmers.push_back (dna.substr (dna_rng () % (dna.size () - 16), 16));
+                }
+        ankerl::nanobench::Bench pair_bench;
+        pair_bench.title ("Aho-Corasick Pair Transitions (LazyDFA, " + std::to_string (kmers.size ()) + " DNA 16-mers)")
+                .unit ("byte")
+                .batch (dna.size ())
+                .relative (true);
+        for (size_t pair_classes : {size_t{0}, size_t{20}})
+                {
+                        auto searcher = AhoCorasickBuilder ().prefilter (false).dfa_pair_classes (pair_classes)
+                                .build<automaton::LazyDFA<automaton::ContiguousNFA>> (kmers);
+                        pair_bench.run (pair_classes == 0 ? "one byte per lookup" : "two bytes per lookup",
+                                        [&searcher, &dna] ()
+                                        {
+                                          size_t res = 0;
+                                          searcher.for_each_match (dna, [&res] (const Match &)
+                                          { ++res; });
+                                          ankerl::nanobench::doNotOptimizeAway (res);
+                                        });
+                }
+
+#if defined(AC_WITH_ZLIB)
+        // compressed input: decompressing into a buffer before searching vs. searching the chunks while the next ones
+        //  are decompressed by another thread
+        const std::string compressed_path = "files/harry_potter_1.txt.gz";
+        constexpr size_t copies = 16;
+        {
+                gzFile file = gzopen (compressed_path.c_str (), "wb");
+                for (size_t i = 0; i < copies; ++i)
+                        {
+                                gzwrite (file, text.data (), static_cast<unsigned>(text.size ()));
+                        }
+                gzclose (file);
+        }
+        ankerl::nanobench::Bench compressed_bench;
+        compressed_bench.title ("Aho-Corasick Compressed Input (NFA, " + std::to_string (words.size ())
+                                + " words, gzip)")
+                .unit ("byte")
+                .batch (copies * text.size ())
+                .relative (true);
+        compressed_bench.run ("decompress, then find_iter", [&small_searcher, &compressed_path] ()
+        {
+          DecompressingReader reader (compressed_path);
+          std::string input;
+          while (auto chunk = reader.next ())
+            {
+              input.append (*chunk);
+            }
+          size_t res = 0;
+          for (const auto &match : small_searcher.find_iter (input))
+            {
+              res += match.end;
+            }
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+        compressed_bench.run ("find_iter_chunks while decompressing", [&small_searcher, &compressed_path] ()
+        {
+          DecompressingReader reader (compressed_path);
+          size_t res = 0;
+          for (const auto &match : small_searcher.find_iter_chunks (reader.chunks ()))
+            {
+              res += match.end;
+            }
+          ankerl::nanobench::doNotOptimizeAway (res);
+        });
+#endif
+
+        for (auto *dictionary : {&patterns, &words})
+                {
+                        ankerl::nanobench::Bench build_bench;
+                        build_bench.title ("Aho-Corasick Construction (" + std::to_string (dictionary->size ())
+                                           + " patterns)")
+                                .unit ("pattern")
+                                .batch (dictionary->size ())
+                                .relative (true);
+                        build_bench.run ("lfreist/aho-corasick (NFA)", [dictionary] ()
+                        {
+                          automaton::NFA nfa (*dictionary, MatchKind::STANDARD, false);
+                          ankerl::nanobench::doNotOptimizeAway (nfa.start_state ());
+                        });
+                        build_bench.run ("lfreist/aho-corasick (ContiguousNFA)", [dictionary] ()
+                        {
+                          automaton::ContiguousNFA nfa (*dictionary, MatchKind::STANDARD, false);
+                          ankerl::nanobench::doNotOptimizeAway (nfa.start_state ());
+                        });
+                        build_bench.run ("cjgdev/aho-corasick", [dictionary] ()
+                        {
+                          aho_corasick::trie trie;
+                          for (auto &pattern : *dictionary)
+                                  {
+                                          trie.insert (pattern);
+                                  }
+                          // the failure transitions are computed lazily by the first search
+                          auto res = trie.parse_text ("").size ();
+                          ankerl::nanobench::doNotOptimizeAway (res);
+                        });
+                }
         return 0;
 }
\ No newline at end of file
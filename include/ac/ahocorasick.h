@@ -9,15 +9,24 @@
 #define _AHOCORASICK_H_
 
 #include <ac/search.h>
+#include <ac/find.h>
 #include <ac/nfa/nfa.h>
+#include <ac/nfa/contiguous_nfa.h>
+#include <ac/dfa/lazy_dfa.h>
+#include <ac/dynamic_automaton.h>
+#include <ac/utils/generator.h>
+#include <ac/utils/pattern_set.h>
+#include <ac/utils/prefilter.h>
+#include <ac/utils/result_cache.h>
+#include <ac/utils/word_boundary.h>
 
 #include <vector>
+#include <memory_resource>
+#include <optional>
+#include <span>
 #include <string>
-
-enum AutomatonType {
-  DFA,
-  NFA
-};
+#include <string_view>
+#include <ostream>
 
 struct Result {
   const std::string match;
@@ -27,17 +36,318 @@ struct Result {
 
 std::ostream &operator<<(std::ostream &os, Result const &result);
 
+std::ostream &operator<<(std::ostream &os, AutomatonType type);
+
+/**
+ * @brief Aho-Corasick searcher.
+ *
+ * automaton_type is the engine used for searching, e.g. automaton::NFA, automaton::ContiguousNFA or
+ *  automaton::LazyDFA. An engine provides
+ *  a state_type and the methods start_state (), next_state (state, c), is_dead (state), is_match (state),
+ *  matches (state) and pattern_len (pattern). Anchored searches use next_state_anchored (state, c), a lazy DFA runs
+ *  them on its NFA. Interleaved searches use prefetch (state, c). automaton::Dynamic chooses one of these engines at
+ *  runtime.
+ *
+ * If BuildConfig::whole_words is set, all searches only report matches that are whole words (see WordBoundary). The
+ *  boundaries are checked while searching: no match is reported that is not a whole word, and no search starts within
+ *  a word. For the leftmost match kinds, the leftmost whole-word match is reported.
+ *
+ * Searching a lazy DFA (automaton::LazyDFA, or AutomatonType::LAZY_DFA) updates its cache, although the search methods
+ *  are const. Such a searcher must not be searched by multiple threads at once; its match_histogram counts on the
+ *  calling thread, count_segment_matches and ReplicatedSearcher refuse it.
+ */
 template <typename automaton_type>
 class AhoCorasick {
  public:
-  AhoCorasick(std::vector<std::string> patterns, MatchKind match_kind);
+  /// minimum length of the segments counted in parallel by match_histogram
+  static constexpr size_t MIN_PARALLEL_SEGMENT_LEN{size_t{1} << 20};
+
+  AhoCorasick(const PatternSet &patterns, MatchKind match_kind);
+  AhoCorasick(PatternSet patterns, const BuildConfig &config);
 
   std::vector<Result> find_all(std::string input);
 
+  /**
+   * @brief Get all matches within input (see for_each_match), allocated from resource, e.g. an arena that is reset
+   *  after every search.
+   * @param input
+   * @param resource
+   * @return
+   */
+  std::pmr::vector<Match> find_matches(std::string_view input,
+                                       std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+
+  /**
+   * @brief Call callback (match) for every match within input: all overlapping matches for MatchKind::STANDARD, the
+   *  non-overlapping leftmost ones otherwise. If callback returns a bool, returning false stops the search. The
+   *  callback is inlined into the search loop, so counting or filtering matches this way costs neither an
+   *  allocation nor an indirect call per match.
+   *
+   * @code
+   * size_t count = 0;
+   * searcher.for_each_match (input, [&count] (const Match &match) { return ++count < 10; });
+   * @endcode
+   * @param input
+   * @param callback
+   * @param groups only report matches of patterns of these groups (see PatternSet::add and
+   *  detail::for_each_match)
+   */
+  template <typename Callback>
+  void for_each_match(std::string_view input, Callback &&callback, GroupMask groups = ALL_GROUPS) const
+  {
+    if (_long_patterns.empty()) {
+      detail::for_each_match(_automaton, _prefilter, _words, _match_kind, input, callback, groups);
+      return;
+    }
+    detail::confirm_long_matches(_long_patterns, _patterns, input, callback, [&](auto &confirming) {
+      detail::for_each_match(_automaton, _prefilter, _words, _match_kind, input, confirming, groups);
+    });
+  }
+
+  /**
+   * @brief Same as for_each_match, but for MatchKind::STANDARD, large inputs are split into num_cursors segments that
+   *  are searched in lockstep on the calling thread, which hides the memory latency of automata that do not fit into
+   *  the cache (see detail::for_each_match_interleaved). The matches are reported in the same order.
+   * @param input
+   * @param callback
+   * @param groups
+   */
+  template <size_t num_cursors = 4, typename Callback>
+  void for_each_match_interleaved(std::string_view input, Callback &&callback, GroupMask groups = ALL_GROUPS) const
+  {
+    if (_long_patterns.empty()) {
+      detail::for_each_match_interleaved<num_cursors>(_automaton, _prefilter, _words, _match_kind, _max_pattern_len,
+                                                      input, callback, groups);
+      return;
+    }
+    detail::confirm_long_matches(_long_patterns, _patterns, input, callback, [&](auto &confirming) {
+      detail::for_each_match_interleaved<num_cursors>(_automaton, _prefilter, _words, _match_kind, _max_pattern_len,
+                                                      input, confirming, groups);
+    });
+  }
+
+  /**
+   * @brief Add the number of matches of every pattern within input (see for_each_match) to counts[pattern], e.g. to
+   *  accumulate a histogram over many inputs. The search only increments counters, no match is stored.
+   * @param input
+   * @param counts one counter per pattern, a std::invalid_argument is thrown if there are fewer
+   * @param groups only count matches of patterns of these groups
+   */
+  void count_matches(std::string_view input, std::span<size_t> counts, GroupMask groups = ALL_GROUPS) const;
+
+  /**
+   * @brief Add the matches ending within the segment (begin, end] of input, or [0, end] if begin is 0, to counts. Only
+   *  the bytes of input that the matches ending there and whole-word matching depend on are searched, so that the
+   *  segments of an input can be counted independently, e.g. by different threads, and add up to count_matches
+   *  (input). Only for MatchKind::STANDARD and engines that may be searched by multiple threads at once (not lazy
+   *  DFAs), a std::invalid_argument is thrown otherwise.
+   * @param input
+   * @param begin
+   * @param end
+   * @param counts one counter per pattern
+   * @param groups only count matches of patterns of these groups
+   */
+  void count_segment_matches(std::string_view input, size_t begin, size_t end, std::span<size_t> counts,
+                             GroupMask groups = ALL_GROUPS) const;
+
+  /**
+   * @brief Get the number of matches of every pattern within input, indexed by pattern ID (see count_matches).
+   *
+   * For MatchKind::STANDARD, inputs of 2 MiB and more are split into segments that are counted on up to num_threads
+   *  threads, each into a histogram of its own. The histograms are summed up once all segments are counted. The
+   *  leftmost match kinds, where a match depends on the matches before, and lazy DFAs, which must not be searched by
+   *  multiple threads at once, are counted on the calling thread.
+   * @param input
+   * @param num_threads 0 means one per hardware thread
+   * @param groups only count matches of patterns of these groups
+   * @return
+   */
+  [[nodiscard]]
+  std::vector<size_t> match_histogram(std::string_view input, size_t num_threads = 1,
+                                      GroupMask groups = ALL_GROUPS) const;
+
+  /**
+   * @brief Continue the search of input at cursor until budget is used up or input is done, e.g. to interleave a long
+   *  search with latency-sensitive work on the same thread. The matches are the ones for_each_match (input) reports
+   *  from cursor on, in the same order. All calls for a cursor must pass the same input and groups.
+   *
+   * No automaton state is kept between calls: for MatchKind::STANDARD, a call searches the max_pattern_len - 1 bytes
+   *  before cursor again, for the leftmost match kinds the input from the start of a match that could still be
+   *  extended by the bytes following the budget. Every call searches at least one byte, max_pattern_len + 1 bytes for
+   *  the leftmost match kinds, so that it makes progress even if the deadline has passed already.
+   * @param input
+   * @param cursor advanced to where the next call continues
+   * @param budget
+   * @param groups only report matches of patterns of these groups
+   * @param resource
+   * @return the matches found by this call
+   */
+  std::pmr::vector<Match> find_budgeted(std::string_view input, SearchCursor &cursor, const SearchBudget &budget,
+                                        GroupMask groups = ALL_GROUPS,
+                                        std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+
+  /**
+   * @brief Same as find_matches (input) with groups, but the matches of inputs that are not longer than
+   *  cache.max_input_len () are looked up in cache first and stored there after searching, e.g. for records that
+   *  repeat frequently. A cache can be shared by several searchers (see id) and threads.
+   * @param input
+   * @param cache
+   * @param groups only report matches of patterns of these groups
+   * @return
+   */
+  std::vector<Match> find_cached(std::string_view input, ResultCache &cache, GroupMask groups = ALL_GROUPS) const;
+
+  /**
+   * @brief Get the matches of input one at a time. Each match is computed when the generator is advanced to it, so
+   *  stopping early skips the rest of the search. input and the searcher must outlive the generator.
+   * @param input
+   * @param groups only report matches of patterns of these groups (see for_each_match)
+   * @return
+   */
+  Generator<Match> find_iter(std::string_view input, GroupMask groups = ALL_GROUPS) const;
+
+  /**
+   * @brief Get the matches of input by line (see LineMatch), e.g. for searching logs. The lines are determined only
+   *  around the matches: the input skipped in between is not inspected byte by byte, but its newlines are counted in
+   *  bulk. input and the searcher must outlive the generator.
+   * @param input
+   * @param first_match_per_line if true, only the first match found within a line is reported and the search
+   *  continues at the next line
+   * @return
+   */
+  Generator<LineMatch> find_lines(std::string_view input, bool first_match_per_line = false) const;
+
+  /**
+   * @brief Search input that arrives in chunks, e.g. from an asynchronous reader. The next chunk is awaited only once
+   *  all matches that end in the chunks before are yielded. Matches may span chunk boundaries, their offsets are
+   *  relative to the start of the first chunk. A chunk must stay valid until the next one is requested, the searcher
+   *  until the generator is destroyed.
+   *
+   * For leftmost match kinds, the input following the last match is buffered until it is known that no match that
+   *  could still be extended by the next chunk starts within it. Whole-word matching (BuildConfig::whole_words) is not
+   *  supported: a std::invalid_argument is thrown if it is enabled.
+   * @param chunks
+   * @param groups only report matches of patterns of these groups (see for_each_match)
+   * @return
+   */
+  AsyncGenerator<Match> find_iter_async(AsyncGenerator<std::string_view> chunks, GroupMask groups = ALL_GROUPS) const;
+
+  /**
+   * @brief Same as find_iter_async, but for chunks that are produced synchronously, e.g. by a DecompressingReader that
+   *  decompresses the input on another thread. The search runs on the thread advancing the returned generator.
+   * @param chunks
+   * @param groups only report matches of patterns of these groups
+   * @return
+   */
+  Generator<Match> find_iter_chunks(Generator<std::string_view> chunks, GroupMask groups = ALL_GROUPS) const;
+
+  /**
+   * @brief Find a match that starts at the first byte of input. Only the transitions of the trie are followed, so the
+   *  search ends as soon as no pattern starts with the input read so far. For MatchKind::STANDARD, the shortest match
+   *  is reported, for the leftmost match kinds the match preferred by the match kind.
+   * @param input
+   * @return
+   */
+  [[nodiscard]]
+  std::optional<Match> find_anchored(std::string_view input) const;
+
+  /**
+   * @brief Find the longest pattern that is a prefix of input, e.g. for routing or tokenizing. Ties are broken by the
+   *  lowest pattern ID. For MatchKind::LEFTMOST_FIRST without whole words, patterns that have a prefix added before
+   *  them are never matched and thus not considered.
+   * @param input
+   * @return
+   */
+  [[nodiscard]]
+  std::optional<Match> longest_prefix(std::string_view input) const;
+
+  [[nodiscard]]
+  const automaton_type &automaton() const;
+
+  /**
+   * @brief Get the ID that identifies this searcher in a ResultCache. IDs are unique within the process, they are never
+   *  reused for another searcher.
+   */
+  [[nodiscard]]
+  uint64_t id() const;
+
  private:
-  std::vector<std::string> _patterns;
+  uint64_t _id;
+  PatternSet _patterns;
   MatchKind _match_kind;
+  /// the patterns the automaton only contains by their anchors, see BuildConfig::long_pattern_threshold
+  LongPatterns _long_patterns;
   automaton_type _automaton;
+  Prefilter _prefilter{};
+  WordBoundary _words{};
+  size_t _max_pattern_len{0};
+};
+
+/**
+ * @brief Builder for AhoCorasick searchers.
+ *
+ * By default, the engine is chosen automatically from the patterns (AutomatonType::AUTO). The chosen engine can be
+ *  queried using searcher.automaton ().type ().
+ *
+ * Patterns can be passed as any range of strings or string views (see PatternSet). A build that exceeds one of the
+ *  configured limits fails with a std::length_error.
+ *
+ * @code
+ * auto searcher = AhoCorasickBuilder ().match_kind (MatchKind::LEFTMOST_FIRST).memory_budget (64 << 20).build (patterns);
+ * std::cout << searcher.automaton ().type () << std::endl;
+ * @endcode
+ */
+class AhoCorasickBuilder {
+ public:
+  AhoCorasickBuilder &match_kind(MatchKind match_kind);
+  AhoCorasickBuilder &ascii_case_insensitive(bool yes);
+  AhoCorasickBuilder &automaton_type(AutomatonType type);
+  /// see BuildConfig::memory_budget
+  AhoCorasickBuilder &memory_budget(size_t bytes);
+  /// see BuildConfig::prefilter
+  AhoCorasickBuilder &prefilter(bool yes);
+  /// see BuildConfig::byte_classes
+  AhoCorasickBuilder &byte_classes(bool yes);
+  /// see BuildConfig::dfa_state_limit
+  AhoCorasickBuilder &dfa_state_limit(size_t states);
+  /// see BuildConfig::dfa_cache_size
+  AhoCorasickBuilder &dfa_cache_size(size_t bytes);
+  /// see BuildConfig::dfa_pair_classes
+  AhoCorasickBuilder &dfa_pair_classes(size_t classes);
+  /// see BuildConfig::memory_limit
+  AhoCorasickBuilder &memory_limit(size_t bytes);
+  /// see BuildConfig::build_threads
+  AhoCorasickBuilder &build_threads(size_t num_threads);
+  /// see BuildConfig::whole_words
+  AhoCorasickBuilder &whole_words(bool yes);
+  /// see BuildConfig::word_chars
+  AhoCorasickBuilder &word_chars(std::string chars);
+  /// see BuildConfig::memory_resource
+  AhoCorasickBuilder &memory_resource(std::pmr::memory_resource *resource);
+  /// see BuildConfig::huge_pages
+  AhoCorasickBuilder &huge_pages(bool yes);
+  /// see BuildConfig::state_layout
+  AhoCorasickBuilder &state_layout(const StateLayout *layout);
+  /// see BuildConfig::long_pattern_threshold
+  AhoCorasickBuilder &long_pattern_threshold(size_t bytes);
+
+  [[nodiscard]]
+  const BuildConfig &config() const;
+
+  /**
+   * @brief Build a searcher for patterns. Choose a static automaton_type (e.g. automaton::NFA) to avoid the runtime
+   *  dispatch of automaton::Dynamic. In this case, the automaton type set on the builder is ignored.
+   * @param patterns
+   * @return
+   */
+  template <typename automaton_type = automaton::Dynamic>
+  AhoCorasick<automaton_type> build(PatternSet patterns) const
+  {
+    return AhoCorasick<automaton_type>(std::move(patterns), _config);
+  }
+
+ private:
+  BuildConfig _config{};
 };
 
 #endif //_AHOCORASICK_H_
@@ -0,0 +1,237 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _LAZY_DFA_H_
+#define _LAZY_DFA_H_
+
+#include <vector>
+#include <cstdint>
+#include <span>
+#include <limits>
+#include <memory_resource>
+#include <unordered_map>
+
+#include <ac/search.h>
+#include <ac/nfa/nfa.h>
+#include <ac/nfa/contiguous_nfa.h>
+#include <ac/utils/charset.h>
+#include <ac/utils/pattern_set.h>
+
+namespace automaton
+{
+
+/**
+ * @brief An Aho-Corasick DFA that is computed lazily from an NFA while searching.
+ *
+ * Every DFA state stands for one state of the NFA. Its transitions are unknown when the state is created and are
+ *  computed from the NFA (following failure transitions) the first time a search takes them. Afterwards, a transition
+ *  is a single table lookup, as in a fully determinized DFA. Only the states a search actually visits take up memory.
+ *
+ * The DFA states are stored in a table of fixed capacity (BuildConfig::dfa_cache_size, at most
+ *  BuildConfig::dfa_state_limit states). If it is full, all states
+ *  except the start and the dead state are dropped and the search continues, computing states again as needed. Since
+ *  each transition is computed by the NFA, the results are always the same as searching with the NFA.
+ *
+ * For small alphabets, e.g. DNA, a DFA state also caches transitions over pairs of bytes (see next_state_pair), so
+ *  that a search takes one lookup per two bytes. They are computed from the transitions over single bytes, and a pair
+ *  whose first byte leads to a match state is read byte by byte.
+ *
+ * Searching changes the cache, so a LazyDFA must not be searched by multiple threads at once.
+ *
+ * nfa_type is the engine the DFA is computed from, automaton::NFA or automaton::ContiguousNFA.
+ */
+template<typename nfa_type = NFA>
+class LazyDFA {
+ public:
+  using state_type = uint32_t;
+
+  /// number of states the cache holds at least: the start state, the dead state and the state a search moves to
+  static constexpr size_t MIN_STATES{3};
+
+  /**
+   * @brief Constructing a lazy DFA and the NFA it is computed from.
+   * @param patterns
+   * @param match_kind
+   * @param ascii_i_case
+   */
+  LazyDFA (const PatternSet &patterns, MatchKind match_kind, bool ascii_i_case);
+
+  /**
+   * @brief Constructing a lazy DFA and the NFA it is computed from. config.dfa_cache_size bytes are allocated for
+   *  DFA states. If config.byte_classes is false, each DFA state has a transition for all 256 bytes. If there are at
+   *  most config.dfa_pair_classes byte classes, each DFA state also has a transition for every pair of them (see
+   *  has_pair_transitions). Throws a std::length_error if config.dfa_state_limit is below MIN_STATES.
+   * @param patterns
+   * @param config
+   */
+  LazyDFA (const PatternSet &patterns, const BuildConfig &config);
+  LazyDFA (const LazyDFA &) = delete;
+  LazyDFA &operator= (const LazyDFA &) = delete;
+
+  [[nodiscard]]
+  state_type start_state () const;
+
+  /**
+   * @brief Get the state reached from state by reading c. If the transition was not taken before, it is computed from
+   *  the NFA. This may clear the cache, which invalidates all states except the returned one, the start state and
+   *  the dead state.
+   * @param state
+   * @param c
+   * @return
+   */
+  [[nodiscard]]
+  state_type next_state (state_type state, unsigned char c) const
+  {
+          state_type next = _table[state * _stride + _classes[c]];
+          if (next != UNKNOWN)
+                  {
+                          return next;
+                  }
+          return compute_next_state (state, c);
+  }
+
+  /**
+   * @brief Read the two bytes a and b from state with a single lookup (see has_pair_transitions). A match ending after
+   *  a would be skipped, so if the state reached by a is a match state, only a is read. Like next_state, this may
+   *  clear the cache.
+   * @param state set to the state reached
+   * @param a
+   * @param b
+   * @return the number of bytes read, 1 or 2
+   */
+  size_t next_state_pair (state_type &state, unsigned char a, unsigned char b) const
+  {
+          state_type next = _pair_table[state * _pair_stride + _classes[a] * _stride + _classes[b]];
+          if (next < SPLIT)
+                  {
+                          state = next;
+                          return 2;
+                  }
+          if (next == SPLIT)
+                  {
+                          state = next_state (state, a);
+                          return 1;
+                  }
+          return compute_next_state_pair (state, a, b);
+  }
+
+  /**
+   * @brief Check if the DFA caches transitions over pairs of bytes, i.e. if it has at most
+   *  BuildConfig::dfa_pair_classes byte classes and its cache can hold all states with them. Otherwise,
+   *  next_state_pair must not be used.
+   * @return
+   */
+  [[nodiscard]]
+  bool has_pair_transitions () const
+  {
+          return _pair_stride != 0;
+  }
+
+  [[nodiscard]]
+  bool is_dead (state_type state) const
+  {
+          return state == DEAD;
+  }
+
+  [[nodiscard]]
+  bool is_match (state_type state) const
+  {
+          return _is_match[state];
+  }
+
+  /**
+   * @brief Get the IDs of all patterns matching in state. For leftmost match kinds, the first ID is the preferred one.
+   * @param state
+   * @return
+   */
+  [[nodiscard]]
+  std::span<const PatternID> matches (state_type state) const;
+
+  [[nodiscard]]
+  size_t pattern_len (PatternID pattern) const;
+
+  [[nodiscard]]
+  GroupID pattern_group (PatternID pattern) const;
+
+  /// see NFA::match_groups
+  [[nodiscard]]
+  GroupMask match_groups (state_type state) const;
+
+  /// see NFA::reachable_groups
+  [[nodiscard]]
+  GroupMask reachable_groups (state_type state) const;
+
+  /// see NFA::prune
+  [[nodiscard]]
+  state_type prune (state_type state, GroupMask groups) const;
+
+  /**
+   * @brief Get the NFA the DFA is computed from.
+   * @return
+   */
+  [[nodiscard]]
+  const nfa_type &nfa () const;
+
+  /**
+   * @brief Get the number of DFA states currently cached, including the start and the dead state.
+   * @return
+   */
+  [[nodiscard]]
+  size_t num_cached_states () const;
+
+  /**
+   * @brief Get how often the cache was cleared because it was full.
+   * @return
+   */
+  [[nodiscard]]
+  size_t num_cache_clears () const;
+
+ private:
+  /// Marks a transition that was not computed yet
+  static constexpr state_type UNKNOWN{std::numeric_limits<state_type>::max ()};
+  /// Marks a pair transition whose first byte leads to a match state
+  static constexpr state_type SPLIT{UNKNOWN - 1};
+  /// The dead state is the first state of the table, the start state the second one
+  static constexpr state_type DEAD{0};
+  static constexpr state_type START{1};
+
+  state_type compute_next_state (state_type state, unsigned char c) const;
+
+  size_t compute_next_state_pair (state_type &state, unsigned char a, unsigned char b) const;
+
+  /// Get the DFA state for nfa_state, adding it if it is not cached
+  state_type add_state (typename nfa_type::state_type nfa_state) const;
+
+  /// Drop all states except the start and the dead state
+  void clear_cache () const;
+
+  nfa_type _nfa;
+  /// byte class of every byte
+  CodePoint _classes[256]{0};
+  /// a byte of every byte class, used for computing transitions from the NFA
+  unsigned char _representatives[256]{0};
+  /// number of byte classes, i.e. the number of transitions of a DFA state
+  size_t _stride{0};
+  /// number of pair transitions of a DFA state, _stride * _stride, or 0 if there are none
+  size_t _pair_stride{0};
+  /// maximum number of DFA states, including the start and the dead state
+  size_t _capacity{0};
+  /// transitions of all cached DFA states, _stride per state. Allocated from table_resource (config).
+  mutable std::pmr::vector<state_type> _table;
+  /// transitions over pairs of bytes of all cached DFA states, _pair_stride per state, indexed by the byte class of
+  ///  the first byte * _stride + the byte class of the second one
+  mutable std::pmr::vector<state_type> _pair_table;
+  /// NFA state of every cached DFA state
+  mutable std::pmr::vector<typename nfa_type::state_type> _nfa_states;
+  mutable std::pmr::vector<uint8_t> _is_match;
+  mutable std::pmr::unordered_map<typename nfa_type::state_type, state_type> _dfa_states;
+  mutable size_t _num_cache_clears{0};
+};
+
+}  // namespace automaton
+
+#endif //_LAZY_DFA_H_
@@ -0,0 +1,128 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ * 
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _DYNAMIC_AUTOMATON_H_
+#define _DYNAMIC_AUTOMATON_H_
+
+#include <ac/search.h>
+#include <ac/nfa/nfa.h>
+#include <ac/nfa/contiguous_nfa.h>
+#include <ac/dfa/lazy_dfa.h>
+#include <ac/utils/pattern_set.h>
+
+#include <vector>
+#include <string>
+#include <variant>
+
+namespace automaton
+{
+
+/**
+ * @brief Properties of a pattern set that are relevant for choosing an engine.
+ */
+struct PatternStats {
+  size_t num_patterns{0};
+  size_t total_len{0};
+  size_t min_len{0};
+  size_t max_len{0};
+  /// number of trie states (excluding the start state), i.e. the number of distinct non-empty pattern prefixes
+  size_t trie_size{0};
+  /// number of trie states without a transition, i.e. the number of distinct non-empty patterns that are not a prefix
+  ///  of another pattern
+  size_t trie_leaves{0};
+  /// CharSet::size () of the patterns
+  uint16_t alphabet_size{0};
+  /// true if no pattern contains a char >= 128
+  bool ascii{true};
+  /// see PatternSet::has_groups
+  bool groups{false};
+};
+
+/**
+ * @brief Collect the PatternStats of patterns. The trie size is computed exactly by sorting the patterns and summing
+ *  up the lengths that are not shared with the preceding pattern.
+ * @param patterns
+ * @param ascii_i_case
+ * @return
+ */
+PatternStats analyze_patterns (const PatternSet &patterns, bool ascii_i_case);
+
+/**
+ * @brief Estimated number of bytes an NFA for patterns with the given stats takes up. Its rows have one column per
+ *  byte class if byte_classes is set (see BuildConfig::byte_classes) and 128 columns otherwise.
+ */
+size_t estimate_nfa_size (const PatternStats &stats, bool byte_classes);
+
+/**
+ * @brief Estimated number of bytes a ContiguousNFA for patterns with the given stats takes up.
+ */
+size_t estimate_contiguous_nfa_size (const PatternStats &stats);
+
+/**
+ * @brief Choose the engine for AutomatonType::AUTO.
+ *
+ * The NFA is the fastest engine (one direct lookup per byte in the common case), but needs a transition row per inner
+ *  trie state and only supports ASCII patterns. It is chosen as long as its estimated size fits into
+ *  config.memory_budget and config.memory_limit, estimating a row with one column per byte class of the patterns if
+ *  config.byte_classes is set and with 128 columns otherwise. Otherwise the ContiguousNFA is chosen. Both engines
+ *  support all match kinds, so the match kind does not influence the choice between them. The LazyDFA is never chosen,
+ *  since searching changes its cache and thus it cannot be searched by multiple threads at once.
+ * @param stats
+ * @param config
+ * @return
+ */
+AutomatonType select_automaton_type (const PatternStats &stats, const BuildConfig &config);
+
+/**
+ * @brief Estimated number of bytes an engine of the given type takes up for patterns with the given stats. For
+ *  AutomatonType::LAZY_DFA, the cache (BuildConfig::dfa_cache_size) is not included.
+ */
+size_t estimate_size (AutomatonType type, const PatternStats &stats, bool byte_classes);
+
+/**
+ * @brief An automaton whose engine is chosen at runtime, either explicitly through BuildConfig::automaton_type or
+ *  automatically (AutomatonType::AUTO).
+ *
+ * Searching dispatches once per search to the chosen engine (see visit), not once per byte.
+ */
+class Dynamic {
+ public:
+  using variant_type = std::variant<NFA, ContiguousNFA, LazyDFA<ContiguousNFA>>;
+
+  /**
+   * @brief Choose and build the engine. If config.memory_limit is set, the build fails with a std::length_error before
+   *  anything is allocated if the estimated size of the chosen engine exceeds the limit.
+   * @param patterns
+   * @param config
+   */
+  Dynamic (const PatternSet &patterns, const BuildConfig &config);
+  Dynamic (const PatternSet &patterns, MatchKind match_kind, bool ascii_i_case);
+
+  /**
+   * @brief Get the type of the engine that was chosen.
+   * @return
+   */
+  [[nodiscard]]
+  AutomatonType type () const;
+
+  /**
+   * @brief Call f with the chosen engine.
+   */
+  template<typename F>
+  decltype (auto) visit (F &&f) const
+  {
+          return std::visit (std::forward<F> (f), _automaton);
+  }
+
+ private:
+  AutomatonType _type;
+  variant_type _automaton;
+};
+
+}  // namespace automaton
+
+#endif //_DYNAMIC_AUTOMATON_H_
@@ -0,0 +1,783 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _FIND_H_
+#define _FIND_H_
+
+#include <ac/search.h>
+#include <ac/dynamic_automaton.h>
+#include <ac/utils/long_patterns.h>
+#include <ac/utils/prefilter.h>
+#include <ac/utils/word_boundary.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * The search loops shared by all search methods of AhoCorasick. They are templates in a header, so that a callback
+ *  passed to AhoCorasick::for_each_match is inlined into the loop.
+ */
+namespace detail {
+
+/**
+ * @brief Pass match to callback.
+ * @return false if the search should stop: callback returned false. Callbacks returning void never stop a search.
+ */
+template<typename Callback>
+bool emit (Callback &callback, const Match &match)
+{
+        if constexpr (std::is_void_v<std::invoke_result_t<Callback &, const Match &>>)
+                {
+                        callback (match);
+                        return true;
+                }
+        else
+                {
+                        return static_cast<bool>(callback (match));
+                }
+}
+
+/// Tell whether pattern belongs to one of groups
+template<typename automaton_type>
+bool in_groups (const automaton_type &automaton, PatternID pattern, GroupMask groups)
+{
+        return groups == ALL_GROUPS || ((groups >> automaton.pattern_group (pattern)) & 1) != 0;
+}
+
+/**
+ * @brief Get the pattern reported for a leftmost match ending in state: the preferred pattern of groups if one of
+ *  them matches, the preferred pattern otherwise.
+ */
+template<typename automaton_type>
+PatternID preferred_pattern (const automaton_type &automaton, typename automaton_type::state_type state,
+                             GroupMask groups)
+{
+        auto matches = automaton.matches (state);
+        if (groups != ALL_GROUPS && (automaton.match_groups (state) & groups) != 0)
+                {
+                        for (auto id : matches)
+                                {
+                                        if (in_groups (automaton, id, groups))
+                                                {
+                                                        return id;
+                                                }
+                                }
+                }
+        return matches[0];
+}
+
+/// Tell whether automaton may be searched by multiple threads at once
+template<typename automaton_type>
+bool is_thread_safe (const automaton_type &automaton)
+{
+        return true;
+}
+
+/// Searching a lazy DFA changes its cache
+template<typename nfa_type>
+bool is_thread_safe (const automaton::LazyDFA<nfa_type> &automaton)
+{
+        return false;
+}
+
+inline bool is_thread_safe (const automaton::Dynamic &automaton)
+{
+        return automaton.type () != AutomatonType::LAZY_DFA;
+}
+
+/**
+ * @brief Tell whether a search in the start state may skip the positions within a word, where no whole-word match can
+ *  start. Not if an empty pattern matches in the start state: it would also end there.
+ */
+template<typename automaton_type>
+bool skips_words (const automaton_type &automaton, const WordBoundary &words)
+{
+        return words.enabled () && !automaton.is_match (automaton.start_state ());
+}
+
+/// Tell whether automaton is a lazy DFA, which may read two bytes per transition (see for_each_match_pairs)
+template<typename automaton_type>
+inline constexpr bool is_lazy_dfa{false};
+
+template<typename nfa_type>
+inline constexpr bool is_lazy_dfa<automaton::LazyDFA<nfa_type>>{true};
+
+/**
+ * @brief Find the leftmost match starting at or after at.
+ *
+ * The search stops as soon as the dead state is reached, which for leftmost match kinds is the case when no match
+ *  starting left of (or at) the last match found can follow anymore. Positions within a word are skipped in the start
+ *  state (see skips_words), but the match found is not checked for word boundaries (see find_leftmost_word).
+ * @param exhausted set to true if the end of input was reached before the dead state, i.e. if more input could
+ *  still change the result
+ * @param groups if the match is one of several patterns (equal up to the ASCII case), one of groups is preferred
+ * @return true if a match was found. pattern and end are set accordingly.
+ */
+template<typename automaton_type>
+bool find_leftmost (const automaton_type &automaton, const Prefilter &prefilter, const WordBoundary &words,
+                    std::string_view input, size_t at, PatternID &pattern, size_t &end, bool &exhausted,
+                    GroupMask groups = ALL_GROUPS)
+{
+        exhausted = false;
+        const auto start = automaton.start_state ();
+        const bool skip_words = skips_words (automaton, words);
+        auto state = start;
+        bool found = false;
+        if (automaton.is_match (state))
+                {
+                        pattern = preferred_pattern (automaton, state, groups);
+                        end = at;
+                        found = true;
+                }
+        for (size_t index = at; index < input.size (); ++index)
+                {
+                        if (state == start)
+                                {
+                                        if (prefilter.enabled ())
+                                                {
+                                                        index = prefilter.find_candidate (input, index);
+                                                        if (index == input.size ())
+                                                                {
+                                                                        break;
+                                                                }
+                                                }
+                                        if (skip_words && !words.allows_start (input, index))
+                                                {
+                                                        index = words.next_start (input, index) - 1;
+                                                        continue;
+                                                }
+                                }
+                        state = automaton.next_state (state, input[index]);
+                        if (automaton.is_dead (state))
+                                {
+                                        return found;
+                                }
+                        if (automaton.is_match (state))
+                                {
+                                        pattern = preferred_pattern (automaton, state, groups);
+                                        end = index + 1;
+                                        found = true;
+                                }
+                }
+        exhausted = true;
+        return found;
+}
+
+/// The match find_anchored reports if several patterns start at the same position
+enum class AnchoredMatch {
+  SHORTEST,
+  LONGEST,
+  /// the one of the lowest pattern ID, as for MatchKind::LEFTMOST_FIRST
+  FIRST
+};
+
+/**
+ * @brief Search for a match starting at input[at]. Only the transitions of the trie are followed, without failure
+ *  transitions, until the dead state is reached. Matches not followed by a word boundary are ignored (see
+ *  WordBoundary), the start is not checked.
+ *
+ * Match states may also hold suffix matches copied from their failure states, only the patterns as long as the input
+ *  read so far start at at.
+ * @param preferred the match reported among those starting at at
+ * @param exhausted set to true if the end of input was reached before the dead state
+ * @param groups if the match is one of several patterns (equal up to the ASCII case), one of groups is preferred
+ */
+template<typename automaton_type>
+std::optional<Match> find_anchored (const automaton_type &automaton, const WordBoundary &words,
+                                    std::string_view input, size_t at, AnchoredMatch preferred, bool &exhausted,
+                                    GroupMask groups = ALL_GROUPS)
+{
+        exhausted = false;
+        std::optional<Match> found;
+        // the lowest ID of the patterns equal to the one found
+        PatternID found_first = 0;
+        // patterns of groups are preferred, then lower IDs
+        auto rank = [&automaton, groups] (PatternID id)
+        {
+          return std::pair (!in_groups (automaton, id, groups), id);
+        };
+        auto state = automaton.start_state ();
+        for (size_t index = at;; ++index)
+                {
+                        if (automaton.is_match (state) && words.allows_end (input, index))
+                                {
+                                        std::optional<Match> match;
+                                        PatternID first = 0;
+                                        for (auto id : automaton.matches (state))
+                                                {
+                                                        if (automaton.pattern_len (id) != index - at)
+                                                                {
+                                                                        continue;
+                                                                }
+                                                        first = match ? std::min (first, id) : id;
+                                                        if (!match || rank (id) < rank (match->pattern))
+                                                                {
+                                                                        match = Match{id, at, index};
+                                                                }
+                                                }
+                                        if (match
+                                            && (!found || preferred != AnchoredMatch::FIRST || first < found_first))
+                                                {
+                                                        found = match;
+                                                        found_first = first;
+                                                        if (preferred == AnchoredMatch::SHORTEST)
+                                                                {
+                                                                        return found;
+                                                                }
+                                                }
+                                }
+                        if (index == input.size ())
+                                {
+                                        exhausted = true;
+                                        return found;
+                                }
+                        state = automaton.next_state_anchored (state, input[index]);
+                        if (automaton.is_dead (state))
+                                {
+                                        return found;
+                                }
+                }
+}
+
+template<typename nfa_type>
+std::optional<Match> find_anchored (const automaton::LazyDFA<nfa_type> &automaton, const WordBoundary &words,
+                                    std::string_view input, size_t at, AnchoredMatch preferred, bool &exhausted,
+                                    GroupMask groups = ALL_GROUPS)
+{
+        // an anchored search visits a single path of the trie, caching DFA states for it does not pay off
+        return find_anchored (automaton.nfa (), words, input, at, preferred, exhausted, groups);
+}
+
+inline std::optional<Match> find_anchored (const automaton::Dynamic &automaton, const WordBoundary &words,
+                                           std::string_view input, size_t at, AnchoredMatch preferred,
+                                           bool &exhausted, GroupMask groups = ALL_GROUPS)
+{
+        return automaton.visit ([&] (const auto &engine)
+        {
+          return find_anchored (engine, words, input, at, preferred, exhausted, groups);
+        });
+}
+
+/**
+ * @brief Find the leftmost match starting at or after at that is a whole word (see WordBoundary), i.e. the result of
+ *  find_leftmost if words is disabled.
+ *
+ * If the match found by find_leftmost is no whole word, the match preferred by match_kind among the whole-word
+ *  matches starting at the same position is reported instead (see find_anchored). If there is none, the search
+ *  continues at the next position: no match starts in between. With whole words, a LEFTMOST_FIRST trie keeps the
+ *  patterns shadowed by a prefix (see NFA::_skip_shadowed), so the match found is always resolved this way.
+ * @param exhausted set by the last find_leftmost: a search continued by more input must not rely on it
+ */
+template<typename automaton_type>
+bool find_leftmost_word (const automaton_type &automaton, const Prefilter &prefilter, const WordBoundary &words,
+                         MatchKind match_kind, std::string_view input, size_t at, PatternID &pattern, size_t &end,
+                         bool &exhausted, GroupMask groups = ALL_GROUPS)
+{
+        const bool first = match_kind == MatchKind::LEFTMOST_FIRST;
+        const AnchoredMatch preferred = first ? AnchoredMatch::FIRST : AnchoredMatch::LONGEST;
+        while (at <= input.size ()
+               && find_leftmost (automaton, prefilter, words, input, at, pattern, end, exhausted, groups))
+                {
+                        size_t start = end - automaton.pattern_len (pattern);
+                        if (!words.enabled () || (!first && words.allows (input, start, end)))
+                                {
+                                        return true;
+                                }
+                        if (words.allows_start (input, start))
+                                {
+                                        bool anchored_exhausted;
+                                        auto match = find_anchored (automaton, words, input, start, preferred,
+                                                                    anchored_exhausted, groups);
+                                        if (match)
+                                                {
+                                                        pattern = match->pattern;
+                                                        end = match->end;
+                                                        return true;
+                                                }
+                                }
+                        at = start + 1;
+                }
+        return false;
+}
+
+/**
+ * @brief Find the next leftmost match of a pattern of groups starting at or after at (see find_leftmost_word) and
+ *  advance at behind it. The matches of patterns not in groups are skipped (see for_each_match).
+ */
+template<typename automaton_type>
+std::optional<Match> next_leftmost_match (const automaton_type &automaton, const Prefilter &prefilter,
+                                          const WordBoundary &words, MatchKind match_kind, std::string_view input,
+                                          size_t &at, GroupMask groups = ALL_GROUPS)
+{
+        PatternID pattern;
+        size_t end;
+        bool exhausted;
+        while (find_leftmost_word (automaton, prefilter, words, match_kind, input, at, pattern, end, exhausted,
+                                   groups))
+                {
+                        size_t start = end - automaton.pattern_len (pattern);
+                        // an empty match would otherwise be found over and over again
+                        at = end == start ? end + 1 : end;
+                        if (in_groups (automaton, pattern, groups))
+                                {
+                                        return Match{pattern, start, end};
+                                }
+                }
+        return std::nullopt;
+}
+
+/**
+ * @brief A MatchKind::STANDARD search that stops at every position where matches of patterns of groups end, so that
+ *  they can be reported one at a time, e.g. by a generator. for_each_match runs it with the callback inlined.
+ *
+ * @code
+ * StandardSearch search (automaton, prefilter, words, input, groups);
+ * while (search.next ())
+ *   for (auto id : search.matches ())
+ *     if (search.reports (id))
+ *       report (search.match (id));
+ * @endcode
+ */
+template<typename automaton_type>
+class StandardSearch {
+ public:
+  using state_type = typename automaton_type::state_type;
+
+  /**
+   * @brief Start a search of input. The matches of the start state (empty patterns) are the first ones reported.
+   */
+  StandardSearch (const automaton_type &automaton, const Prefilter &prefilter, const WordBoundary &words,
+                  std::string_view input, GroupMask groups)
+          : _automaton (automaton), _prefilter (prefilter), _words (words), _input (input), _groups (groups),
+            _start (automaton.start_state ()), _state (_start), _skip_words (skips_words (automaton, words))
+  {}
+
+  /**
+   * @brief Continue the search with input, e.g. the next chunk of an input searched in chunks, in the state reached
+   *  at the end of the input before. Positions are relative to the start of input from now on.
+   */
+  void resume (std::string_view input)
+  {
+          _input = input;
+          _end = 0;
+  }
+
+  /**
+   * @brief Advance to the next position at which patterns of groups may end (see matches and reports), the start
+   *  position first.
+   * @return false if the end of input was reached
+   */
+  bool next ()
+  {
+          if (_at_start)
+                  {
+                          _at_start = false;
+                          if (_automaton.is_match (_state) && _words.allows_end (_input, _end))
+                                  {
+                                          return true;
+                                  }
+                  }
+          while (_end < _input.size ())
+                  {
+                          if (_groups != ALL_GROUPS && (_automaton.reachable_groups (_state) & _groups) == 0)
+                                  {
+                                          _state = _automaton.prune (_state, _groups);
+                                  }
+                          if (_state == _start)
+                                  {
+                                          if (_prefilter.enabled ())
+                                                  {
+                                                          _end = _prefilter.find_candidate (_input, _end);
+                                                          if (_end == _input.size ())
+                                                                  {
+                                                                          break;
+                                                                  }
+                                                  }
+                                          if (_skip_words && !_words.allows_start (_input, _end))
+                                                  {
+                                                          _end = _words.next_start (_input, _end);
+                                                          continue;
+                                                  }
+                                  }
+                          _state = _automaton.next_state (_state, _input[_end++]);
+                          if (_automaton.is_match (_state)
+                              && (_groups == ALL_GROUPS || (_automaton.match_groups (_state) & _groups) != 0)
+                              && _words.allows_end (_input, _end))
+                                  {
+                                          return true;
+                                  }
+                  }
+          return false;
+  }
+
+  /**
+   * @brief Get the patterns matching at the current position. Only those for which reports is true are matches.
+   */
+  [[nodiscard]]
+  std::span<const PatternID> matches () const
+  {
+          return _automaton.matches (_state);
+  }
+
+  /**
+   * @brief Tell whether pattern, one of matches (), is a match: it belongs to groups and is a whole word.
+   */
+  [[nodiscard]]
+  bool reports (PatternID pattern) const
+  {
+          return in_groups (_automaton, pattern, _groups)
+                 && _words.allows_start (_input, _end - _automaton.pattern_len (pattern));
+  }
+
+  /**
+   * @brief Get the match of pattern, one of matches (), ending at the current position.
+   */
+  [[nodiscard]]
+  Match match (PatternID pattern) const
+  {
+          return Match{pattern, _end - _automaton.pattern_len (pattern), _end};
+  }
+
+  /**
+   * @brief Get the number of bytes of input read so far, i.e. the end of matches ().
+   */
+  [[nodiscard]]
+  size_t end () const
+  {
+          return _end;
+  }
+
+  [[nodiscard]]
+  state_type state () const
+  {
+          return _state;
+  }
+
+  /**
+   * @brief Continue the search at position at of input in the start state: no match starting before at is reported,
+   *  the matches of the start state (empty patterns) at at are.
+   */
+  void restart (size_t at)
+  {
+          _end = at;
+          _state = _start;
+          _at_start = at <= _input.size ();
+  }
+
+ private:
+  const automaton_type &_automaton;
+  const Prefilter &_prefilter;
+  const WordBoundary &_words;
+  std::string_view _input;
+  GroupMask _groups;
+  state_type _start;
+  state_type _state;
+  bool _skip_words;
+  /// the matches of the start state at _end were not reported yet
+  bool _at_start{true};
+  size_t _end{0};
+};
+
+/**
+ * @brief The MatchKind::STANDARD search of for_each_match for a lazy DFA with pair transitions, for all groups and
+ *  without whole words: two bytes are read per lookup (see LazyDFA::next_state_pair). Matches ending between the two
+ *  bytes are not missed, since a pair is only read at once if its first byte does not lead to a match state.
+ */
+template<typename nfa_type, typename Callback>
+void for_each_match_pairs (const automaton::LazyDFA<nfa_type> &automaton, const Prefilter &prefilter,
+                           std::string_view input, Callback &callback)
+{
+        const auto start = automaton.start_state ();
+        auto state = start;
+        for (auto id : automaton.matches (state))
+                {
+                        if (!emit (callback, Match{id, 0, 0}))
+                                {
+                                        return;
+                                }
+                }
+        size_t index = 0;
+        while (index < input.size ())
+                {
+                        if (state == start && prefilter.enabled ())
+                                {
+                                        index = prefilter.find_candidate (input, index);
+                                        if (index == input.size ())
+                                                {
+                                                        break;
+                                                }
+                                }
+                        if (index + 1 < input.size ())
+                                {
+                                        index += automaton.next_state_pair (state, input[index], input[index + 1]);
+                                }
+                        else
+                                {
+                                        state = automaton.next_state (state, input[index]);
+                                        ++index;
+                                }
+                        if (automaton.is_match (state))
+                                {
+                                        for (auto id : automaton.matches (state))
+                                                {
+                                                        size_t len = automaton.pattern_len (id);
+                                                        if (!emit (callback, Match{id, index - len, index}))
+                                                                {
+                                                                        return;
+                                                                }
+                                                }
+                                }
+                }
+}
+
+/**
+ * @brief Call callback (match) for every match of a pattern of groups within input until it returns false (see emit).
+ *  If words is enabled, only whole-word matches are reported.
+ *
+ * For MatchKind::STANDARD all (overlapping) matches are reported. Whenever no pattern of groups can be matched from
+ *  the current state anymore, the search falls back to a shallower state (see NFA::prune), e.g. to the start state,
+ *  where the prefilter applies again.
+ *
+ * For the leftmost match kinds, the non-overlapping leftmost matches of all patterns are determined and those of
+ *  patterns not in groups are dropped (a pattern of groups that equals the dropped one, up to the ASCII case, is
+ *  reported instead). Thus a match of another group still hides the matches overlapping it.
+ */
+template<typename automaton_type, typename Callback>
+void for_each_match (const automaton_type &automaton, const Prefilter &prefilter, const WordBoundary &words,
+                     MatchKind match_kind, std::string_view input, Callback &callback, GroupMask groups = ALL_GROUPS)
+{
+        if constexpr (is_lazy_dfa<automaton_type>)
+                {
+                        if (match_kind == MatchKind::STANDARD && groups == ALL_GROUPS && !words.enabled ()
+                            && automaton.has_pair_transitions ())
+                                {
+                                        for_each_match_pairs (automaton, prefilter, input, callback);
+                                        return;
+                                }
+                }
+        if (match_kind == MatchKind::STANDARD)
+                {
+                        StandardSearch search (automaton, prefilter, words, input, groups);
+                        while (search.next ())
+                                {
+                                        for (auto id : search.matches ())
+                                                {
+                                                        if (search.reports (id) && !emit (callback, search.match (id)))
+                                                                {
+                                                                        return;
+                                                                }
+                                                }
+                                }
+                        return;
+                }
+        size_t at = 0;
+        while (auto match = next_leftmost_match (automaton, prefilter, words, match_kind, input, at, groups))
+                {
+                        if (!emit (callback, *match))
+                                {
+                                        return;
+                                }
+                }
+}
+
+template<typename Callback>
+void for_each_match (const automaton::Dynamic &automaton, const Prefilter &prefilter, const WordBoundary &words,
+                     MatchKind match_kind, std::string_view input, Callback &callback, GroupMask groups = ALL_GROUPS)
+{
+        automaton.visit ([&] (const auto &engine)
+        {
+          for_each_match (engine, prefilter, words, match_kind, input, callback, groups);
+        });
+}
+
+/**
+ * @brief Call search (confirming) with a callback confirming that turns the matches of an automaton built from
+ *  LongPatterns::anchors into the matches of patterns (see LongMatchQueue) and passes them on to callback, ordered by
+ *  their ends like the matches of a search of patterns. callback can stop the search (see emit).
+ */
+template<typename Callback, typename Search>
+void confirm_long_matches (const LongPatterns &long_patterns, const PatternSet &patterns, std::string_view input,
+                           Callback &callback, Search &&search)
+{
+        LongMatchQueue queue (long_patterns, patterns, input);
+        bool stopped = false;
+        auto confirming = [&queue, &callback, &stopped] (const Match &match)
+        {
+          if (!queue.push (match))
+            {
+              return true;
+            }
+          while (auto confirmed = queue.pop (match.end))
+            {
+              if (!emit (callback, *confirmed))
+                {
+                  stopped = true;
+                  return false;
+                }
+            }
+          stopped = !emit (callback, match);
+          return !stopped;
+        };
+        search (confirming);
+        for (auto confirmed = queue.pop (); !stopped && confirmed; confirmed = queue.pop ())
+                {
+                        stopped = !emit (callback, *confirmed);
+                }
+}
+
+/// Minimum length of the segments searched by for_each_match_interleaved
+constexpr size_t MIN_SEGMENT_LEN{4096};
+
+/**
+ * @brief Same as for_each_match, but for MatchKind::STANDARD, input is split into num_cursors segments that are
+ *  searched in lockstep: one byte of every segment per round. The states of the segments are independent of each
+ *  other, so the CPU can wait for the transitions of all of them at once instead of for one after the other, and the
+ *  transition for the next byte of a segment is prefetched (see NFA::prefetch) while the other segments are advanced.
+ *  This pays off if the automaton does not fit into the cache, i.e. if the search is bound by memory latency.
+ *
+ * The search of a segment starts max_pattern_len - 1 bytes before it, so that its state is the same as for a search
+ *  of the whole input as soon as the segment starts. Matches are reported in the same order as by for_each_match: the
+ *  ones of the first segment right away, the others once all segments are searched. The prefilter is not used, the
+ *  groups only filter the matches.
+ *
+ * For the leftmost match kinds, where a match depends on the matches before, and for inputs too short to be split
+ *  into segments of MIN_SEGMENT_LEN (and 4 * max_pattern_len) bytes, for_each_match is used instead.
+ */
+template<size_t num_cursors, typename automaton_type, typename Callback>
+void for_each_match_interleaved (const automaton_type &automaton, const Prefilter &prefilter,
+                                 const WordBoundary &words, MatchKind match_kind, size_t max_pattern_len,
+                                 std::string_view input, Callback &callback, GroupMask groups = ALL_GROUPS)
+{
+        static_assert (num_cursors > 0);
+        const size_t segment_len = (input.size () + num_cursors - 1) / num_cursors;
+        if (match_kind != MatchKind::STANDARD || num_cursors == 1 || segment_len < MIN_SEGMENT_LEN
+            || segment_len < 4 * max_pattern_len)
+                {
+                        for_each_match (automaton, prefilter, words, match_kind, input, callback, groups);
+                        return;
+                }
+        const auto start = automaton.start_state ();
+        for (auto id : automaton.matches (start))
+                {
+                        if (in_groups (automaton, id, groups) && words.allows (input, 0, 0)
+                            && !emit (callback, Match{id, 0, 0}))
+                                {
+                                        return;
+                                }
+                }
+        std::array<typename automaton_type::state_type, num_cursors> states;
+        // next position to read, first position whose matches are reported, end of the segment
+        std::array<size_t, num_cursors> pos, segment_start, segment_end;
+        // matches of the segments except for the first one, which are reported right away
+        std::array<std::vector<Match>, num_cursors> found;
+        // a match ending in a segment may start up to max_pattern_len - 1 bytes before it
+        const size_t overlap = max_pattern_len > 0 ? max_pattern_len - 1 : 0;
+        size_t lockstep_len = input.size ();
+        for (size_t k = 0; k < num_cursors; ++k)
+                {
+                        states[k] = start;
+                        segment_start[k] = std::min (k * segment_len, input.size ());
+                        segment_end[k] = std::min (segment_start[k] + segment_len, input.size ());
+                        pos[k] = segment_start[k] - std::min (segment_start[k], overlap);
+                        lockstep_len = std::min (lockstep_len, segment_end[k] - pos[k]);
+                }
+        // advance cursor k by one byte, false if the search is stopped
+        auto step = [&] (size_t k)
+        {
+          size_t index = pos[k]++;
+          auto state = automaton.next_state (states[k], input[index]);
+          states[k] = state;
+          if (index + 1 < segment_end[k])
+            {
+              automaton.prefetch (state, input[index + 1]);
+            }
+          if (!automaton.is_match (state) || index < segment_start[k] || !words.allows_end (input, index + 1))
+            {
+              return true;
+            }
+          for (auto id : automaton.matches (state))
+            {
+              size_t end = index + 1;
+              Match match{id, end - automaton.pattern_len (id), end};
+              if (!in_groups (automaton, id, groups) || !words.allows_start (input, match.start))
+                {
+                  continue;
+                }
+              if (k > 0)
+                {
+                  found[k].push_back (match);
+                }
+              else if (!emit (callback, match))
+                {
+                  return false;
+                }
+            }
+          return true;
+        };
+        for (size_t i = 0; i < lockstep_len; ++i)
+                {
+                        for (size_t k = 0; k < num_cursors; ++k)
+                                {
+                                        if (!step (k))
+                                                {
+                                                        return;
+                                                }
+                                }
+                }
+        for (size_t k = 0; k < num_cursors; ++k)
+                {
+                        while (pos[k] < segment_end[k])
+                                {
+                                        if (!step (k))
+                                                {
+                                                        return;
+                                                }
+                                }
+                        for (const auto &match : found[k])
+                                {
+                                        if (!emit (callback, match))
+                                                {
+                                                        return;
+                                                }
+                                }
+                }
+}
+
+/**
+ * @brief A lazy DFA may clear its cache on any transition, which invalidates the states of all other segments: it is
+ *  searched by for_each_match.
+ */
+template<size_t num_cursors, typename nfa_type, typename Callback>
+void for_each_match_interleaved (const automaton::LazyDFA<nfa_type> &automaton, const Prefilter &prefilter,
+                                 const WordBoundary &words, MatchKind match_kind, size_t max_pattern_len,
+                                 std::string_view input, Callback &callback, GroupMask groups = ALL_GROUPS)
+{
+        for_each_match (automaton, prefilter, words, match_kind, input, callback, groups);
+}
+
+template<size_t num_cursors, typename Callback>
+void for_each_match_interleaved (const automaton::Dynamic &automaton, const Prefilter &prefilter,
+                                 const WordBoundary &words, MatchKind match_kind, size_t max_pattern_len,
+                                 std::string_view input, Callback &callback, GroupMask groups = ALL_GROUPS)
+{
+        automaton.visit ([&] (const auto &engine)
+        {
+          for_each_match_interleaved<num_cursors> (engine, prefilter, words, match_kind, max_pattern_len, input,
+                                                   callback, groups);
+        });
+}
+
+}  // namespace detail
+
+#endif //_FIND_H_
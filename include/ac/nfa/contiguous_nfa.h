@@ -0,0 +1,223 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ * 
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _CONTIGUOUS_NFA_H_
+#define _CONTIGUOUS_NFA_H_
+
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <span>
+#include <limits>
+#include <algorithm>
+#include <memory_resource>
+
+#include <ac/search.h>
+#include <ac/utils/charset.h>
+#include <ac/utils/pattern_set.h>
+#include <ac/utils/state_layout.h>
+
+namespace automaton
+{
+
+/**
+ * @brief An Aho-Corasick NFA that stores all of its states in one contiguous buffer.
+ *
+ * A state is identified by its offset into the buffer. Each state consists of a small header (transition kind,
+ *  failure transition, match list) followed by its transitions. States close to the start state are stored as dense
+ *  rows indexed by code point, all other states store their transitions sparse: the sorted code points packed four
+ *  per word followed by the target states. Since most states of large dictionaries have only one or two children,
+ *  such a state takes up five to seven words instead of a full transition table.
+ *
+ * Transitions are defined over the code points of the CharSet of the patterns, so chars that do not appear in any
+ *  pattern share a single code point. If the patterns have groups, the header of every state additionally holds the
+ *  masks returned by reachable_groups and match_groups.
+ *
+ * States are stored in breadth first order, so that the (dense) states close to the start state are adjacent, unless
+ *  config.state_layout sets another order, e.g. one computed by profile that packs the states visited most frequently
+ *  by a sample of the input together.
+ *
+ * The construction and the automaton allocate from memory_resource (config), except for the buffer of the states,
+ *  which is allocated from table_resource (config).
+ */
+class ContiguousNFA {
+ public:
+  using state_type = uint32_t;
+
+  /**
+   * @brief Constructing a contiguous Aho-Corasick NFA.
+   * @param patterns
+   * @param match_kind
+   * @param ascii_i_case
+   * @param dense_depth states with a depth less than dense_depth are stored as dense rows
+   */
+  ContiguousNFA (const PatternSet &patterns, MatchKind match_kind, bool ascii_i_case, size_t dense_depth = 2);
+
+  /**
+   * @brief Constructing a contiguous Aho-Corasick NFA. If config.byte_classes is false, transitions are defined over
+   *  all 256 bytes. Throws a std::length_error as soon as config.memory_limit is exceeded, a std::invalid_argument if
+   *  config.state_layout was computed for other patterns or options (see StateLayout::fingerprint) or does not match
+   *  the states.
+   * @param patterns
+   * @param config
+   * @param dense_depth states with a depth less than dense_depth are stored as dense rows
+   */
+  ContiguousNFA (const PatternSet &patterns, const BuildConfig &config, size_t dense_depth = 2);
+
+  [[nodiscard]]
+  state_type start_state () const;
+
+  /**
+   * @brief Get the dead state. A leftmost search ends as soon as it is reached, it only leads to itself.
+   * @return
+   */
+  [[nodiscard]]
+  state_type dead_state () const;
+
+  /**
+   * @brief Get the state reached from state by reading c. Failure transitions are followed until a state with a
+   *  transition for c is found.
+   * @param state
+   * @param c
+   * @return
+   */
+  [[nodiscard]]
+  state_type next_state (state_type state, unsigned char c) const;
+
+  /**
+   * @brief Get the state reached from state by reading c during an anchored search, i.e. a search for matches
+   *  starting at the first byte read. Only transitions of the trie are followed: neither failure transitions nor the
+   *  loop of the start state, a missing transition leads to the dead state.
+   * @param state the start state or a state reached by anchored transitions
+   * @param c
+   * @return
+   */
+  [[nodiscard]]
+  state_type next_state_anchored (state_type state, unsigned char c) const;
+
+  /**
+   * @brief Hint the CPU to load the header of state and, if state is dense, its transition for c, e.g. while other
+   *  searches are advanced (see detail::for_each_match_interleaved). Inline, so that it costs two instructions.
+   * @param state
+   * @param c
+   */
+  void prefetch (state_type state, unsigned char c) const
+  {
+          __builtin_prefetch (_repr.data () + state);
+          // the transitions of a sparse state follow its header, those of a dense state may be a few lines further
+          size_t row = std::min<size_t> (state + _header_size + _code_points[c], _repr.size () - 1);
+          __builtin_prefetch (_repr.data () + row);
+  }
+
+  [[nodiscard]]
+  bool is_dead (state_type state) const;
+
+  [[nodiscard]]
+  bool is_match (state_type state) const;
+
+  /**
+   * @brief Get the IDs of all patterns matching in state. For leftmost match kinds, the first ID is the preferred one.
+   * @param state
+   * @return
+   */
+  [[nodiscard]]
+  std::span<const PatternID> matches (state_type state) const;
+
+  [[nodiscard]]
+  size_t pattern_len (PatternID pattern) const;
+
+  [[nodiscard]]
+  GroupID pattern_group (PatternID pattern) const;
+
+  /// see NFA::match_groups
+  [[nodiscard]]
+  GroupMask match_groups (state_type state) const;
+
+  /// see NFA::reachable_groups
+  [[nodiscard]]
+  GroupMask reachable_groups (state_type state) const;
+
+  /// see NFA::prune
+  [[nodiscard]]
+  state_type prune (state_type state, GroupMask groups) const;
+
+  /**
+   * @brief Get the number of states including the start and the dead state.
+   * @return
+   */
+  [[nodiscard]]
+  size_t num_states () const;
+
+  /**
+   * @brief Get the number of bytes allocated for states, transitions and matches.
+   * @return
+   */
+  [[nodiscard]]
+  size_t memory_usage () const;
+
+  /**
+   * @brief Search samples of the input, count how often every state is visited (including the states the failure
+   *  transitions pass) and get the layout storing the states by descending visit count. States that are not visited
+   *  keep their current order at the end. For the leftmost match kinds, the search restarts at the start state
+   *  whenever it reaches the dead state.
+   *
+   * Building the automaton again with the layout (see BuildConfig::state_layout) packs the states a search spends
+   *  most of its time in into a few cache lines and pages, e.g. for large dictionaries whose states do not fit into
+   *  the caches. The layout can be saved (see StateLayout::save) to reuse it for later builds.
+   * @param samples
+   * @return
+   */
+  [[nodiscard]]
+  StateLayout profile (std::span<const std::string_view> samples) const;
+
+  /**
+   * @brief Get the layout the states are stored in, empty if breadth first.
+   */
+  [[nodiscard]]
+  const StateLayout &layout () const;
+
+ private:
+  /// Get the target of the transition of state for code_point, FAIL if state has none.
+  [[nodiscard]]
+  state_type transition (state_type state, CodePoint code_point) const;
+
+  /// Marks a missing transition
+  static constexpr state_type FAIL{std::numeric_limits<state_type>::max ()};
+  /// Transition kind of states stored as dense rows
+  static constexpr uint32_t DENSE{0xFF};
+  /// Number of header words preceding the transitions of a state
+  static constexpr size_t HEADER_SIZE{3};
+  /// Number of header words added if patterns have groups: [reachable groups (2 words) | match groups (2 words)]
+  static constexpr size_t GROUPS_HEADER_SIZE{4};
+
+  MatchKind _match_kind;
+  CharSet _char_set;
+  /// code point of every char, precomputed from _char_set
+  CodePoint _code_points[256]{0};
+  /// number of code points, i.e. the size of a dense row
+  size_t _alphabet_len{0};
+  state_type _dead_state{0};
+  state_type _start_state{0};
+  size_t _num_states{0};
+  /// HEADER_SIZE, plus GROUPS_HEADER_SIZE if the patterns have groups
+  size_t _header_size{HEADER_SIZE};
+  /// all states: [kind | fail | match offset | groups... | transitions...]
+  std::pmr::vector<uint32_t> _repr;
+  /// match lists referenced by states: [count | pattern ids...]. Offset 0 is the empty list.
+  std::pmr::vector<PatternID> _matches;
+  std::pmr::vector<size_t> _pattern_lens;
+  std::pmr::vector<GroupID> _pattern_groups;
+  StateLayout _layout;
+  /// StateLayout::fingerprint of the patterns and the config this automaton was built from
+  uint64_t _fingerprint{0};
+  size_t _min_pattern_len{std::numeric_limits<size_t>::max ()};
+  size_t _max_pattern_len{0};
+};
+
+}  // namespace automaton
+
+#endif //_CONTIGUOUS_NFA_H_
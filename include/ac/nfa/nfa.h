@@ -12,13 +12,14 @@
 #include <utility>
 #include <cstdint>
 #include <string>
-#include <set>
-#include <unordered_map>
+#include <span>
 #include <limits>
+#include <memory_resource>
 
 #include <ac/search.h>
 #include <ac/utils/charset.h>
 #include <ac/utils/prefilter.h>
+#include <ac/utils/pattern_set.h>
 
 namespace automaton
 {
@@ -26,13 +27,33 @@ namespace automaton
 class NFA;
 
 /**
- * @brief
+ * @brief A state of an NFA. States are allocator-aware: the states of an NFA allocate their matches from the resource
+ *  of the NFA.
  */
 struct State {
-  State *transitions[128]{nullptr};
-  std::set<const std::string *> matches{};
+  using allocator_type = std::pmr::polymorphic_allocator<>;
+
+  State () = default;
+  explicit State (const allocator_type &allocator);
+  State (const State &other, const allocator_type &allocator);
+  State (State &&other, const allocator_type &allocator);
+  State (const State &) = default;
+  State (State &&) = default;
+  State &operator= (const State &) = default;
+  State &operator= (State &&) = default;
+
+  /// transitions by column (see NFA::_code_points): a row of NFA::_rows, shared by all leaves
+  State **transitions{nullptr};
+  /// IDs of the patterns matching when this state is reached, ordered by ID
+  std::pmr::vector<PatternID> matches{};
   State *failed{nullptr};
   size_t depth{0};
+  /// false if the state has a transition to a deeper state
+  bool leaf{true};
+  /// groups of matches
+  GroupMask match_groups{0};
+  /// groups of the patterns whose path passes this state, i.e. that can still match without a failure transition
+  GroupMask reachable_groups{0};
 
   [[nodiscard]]
   bool is_match () const;
@@ -46,46 +67,197 @@ struct State {
  */
 class NFA {
  public:
+  using state_type = const State *;
+
   /**
    * @brief Constructing an Aho-Corasick NFA.
    * @param patterns
    * @param match_kind
    * @param ascii_i_case
    */
-  NFA (const std::vector<std::string> &patterns, MatchKind match_kind, bool ascii_i_case);
-  ~NFA ();
+  NFA (const PatternSet &patterns, MatchKind match_kind, bool ascii_i_case);
+
+  /**
+   * @brief Constructing an Aho-Corasick NFA. Throws a std::length_error as soon as config.memory_limit is exceeded.
+   *
+   * With config.build_threads other than 1, the subtries of patterns starting with different bytes are built in
+   *  parallel and the failure transitions are computed level by level, splitting large levels across the threads.
+   *  The result is the same as for a single threaded build.
+   * @param patterns
+   * @param config
+   */
+  NFA (const PatternSet &patterns, const BuildConfig &config);
+  NFA (const NFA &) = delete;
+  NFA &operator= (const NFA &) = delete;
+
+  [[nodiscard]]
+  state_type start_state () const;
+
+  /**
+   * @brief Get the dead state. A leftmost search ends as soon as it is reached, it only leads to itself.
+   * @return
+   */
+  [[nodiscard]]
+  state_type dead_state () const;
+
+  /**
+   * @brief Get the state reached from state by reading c. Failure transitions are followed until a state with a
+   *  transition for c is found.
+   * @param state
+   * @param c
+   * @return
+   */
+  [[nodiscard]]
+  state_type next_state (state_type state, unsigned char c) const;
+
+  /**
+   * @brief Get the state reached from state by reading c during an anchored search, i.e. a search for matches
+   *  starting at the first byte read. Only transitions of the trie are followed: neither failure transitions nor the
+   *  loop of the start state, a missing transition leads to the dead state.
+   * @param state the start state or a state reached by anchored transitions
+   * @param c
+   * @return
+   */
+  [[nodiscard]]
+  state_type next_state_anchored (state_type state, unsigned char c) const;
+
+  /**
+   * @brief Hint the CPU to load the transition of state for c, e.g. while other searches are advanced (see
+   *  detail::for_each_match_interleaved). Inline, so that it costs a single instruction.
+   * @param state
+   * @param c
+   */
+  void prefetch (state_type state, unsigned char c) const
+  {
+          __builtin_prefetch (&state->transitions[_code_points[c]]);
+  }
+
+  [[nodiscard]]
+  bool is_dead (state_type state) const;
+
+  [[nodiscard]]
+  bool is_match (state_type state) const;
+
+  /**
+   * @brief Get the IDs of all patterns matching in state. For leftmost match kinds, the first ID is the preferred one.
+   * @param state
+   * @return
+   */
+  [[nodiscard]]
+  std::span<const PatternID> matches (state_type state) const;
+
+  [[nodiscard]]
+  size_t pattern_len (PatternID pattern) const;
+
+  [[nodiscard]]
+  GroupID pattern_group (PatternID pattern) const;
+
+  /**
+   * @brief Get the number of transition rows: one for the start state, the dead state and every trie state with a
+   *  transition, and a single one shared by all leaves of the trie.
+   * @return
+   */
+  [[nodiscard]]
+  size_t num_rows () const;
+
+  /**
+   * @brief Get the width of a transition row: the number of distinct code points of the patterns if byte classes are
+   *  used, 128 otherwise.
+   * @return
+   */
+  [[nodiscard]]
+  size_t num_columns () const;
+
+  /**
+   * @brief Get the number of states including the start and the dead state.
+   * @return
+   */
+  [[nodiscard]]
+  size_t num_states () const;
+
+  /**
+   * @brief Get the groups of the patterns matching in state.
+   * @param state
+   * @return
+   */
+  [[nodiscard]]
+  GroupMask match_groups (state_type state) const;
+
+  /**
+   * @brief Get the groups of the patterns that can still be matched from state without following a failure
+   *  transition. All groups for the start state.
+   * @param state
+   * @return
+   */
+  [[nodiscard]]
+  GroupMask reachable_groups (state_type state) const;
+
+  /**
+   * @brief Follow the failure transitions of state until a state is reached from which a pattern of groups can still
+   *  be matched, or the start state (e.g. if groups is empty). A search for these groups only can continue in the
+   *  returned state without missing a match.
+   * @param state
+   * @param groups
+   * @return
+   */
+  [[nodiscard]]
+  state_type prune (state_type state, GroupMask groups) const;
 
   // private:
-  void build_trie (const std::vector<std::string> &patterns);
+  /**
+   * @brief Build the trie. The patterns are sorted, so that a pattern shares its prefix with the previous one and
+   *  the trie can be built in one pass without looking up transitions. All states are allocated at once.
+   * @param patterns
+   */
+  void build_trie (const PatternSet &patterns);
+  /**
+   * @brief Insert patterns sorted by (case folded) pattern and ID into the trie. Different calls must not insert
+   *  patterns with the same first byte.
+   * @param patterns
+   * @param ids
+   * @param first_empty the lowest ID of an empty pattern, no pattern after it is inserted if _skip_shadowed
+   * @param first_state the states created are first_state, first_state + 1, ... If nullptr, the states are only
+   *  counted.
+   * @param first_row a state gets the next row, starting at first_row, when its first transition is added
+   * @param num_rows set to the number of rows taken
+   * @return the number of states created
+   */
+  size_t insert_sorted (const PatternSet &patterns, std::span<const PatternID> ids, PatternID first_empty,
+                        State *first_state, State **first_row, size_t &num_rows);
   void add_failure_transitions ();
   void init_start_state ();
   void add_start_state_loop ();
   void close_start_state_loop_for_leftmost ();
   void add_dead_state_loop ();
 
-  /**
-   * @brief Add a state the the NFA.
-   *
-   * Make sure, that and _start_state are successfully initialized before calling this function.
-   * Both are initialized within the constructor and thus calling this function should be safe.
-   * @param depth
-   * @return
-   */
-  State *add_state (size_t depth);
-
-  static void copy_matches (State *src, State *dst);
+  /// Merge the matches of src into dst. Both are ordered by ID and disjoint.
+  static void copy_matches (const State *src, State *dst);
 
   MatchKind _match_kind;
+  /// For LEFTMOST_FIRST, patterns that a prefix added before them always shadows are not inserted. Not with whole
+  ///  words: the prefix may be no whole word where the pattern is.
+  bool _skip_shadowed{false};
   /// The charset of the given pattern. It is constructed during NFA compiling
   CharSet _char_set;
-  State *_start_state{new State};
-  State *_dead_state{new State};
-  /// The order of regular states
-  std::vector<State *> _states{};
-  std::vector<size_t> _pattern_lens{};
+  /// column of every char, precomputed from _char_set (or the case folded char, if byte classes are not used)
+  CodePoint _code_points[256]{0};
+  /// number of columns of a row
+  size_t _num_columns{128};
+  bool _byte_classes{true};
+  /// all states: the start state, the dead state and the trie states. Allocated from table_resource (config).
+  std::pmr::vector<State> _states;
+  /// the transition rows, _num_columns entries each: the row shared by all leaves (all nullptr), the rows of the
+  ///  start and the dead state, and one per trie state with a transition. Allocated from table_resource (config).
+  std::pmr::vector<State *> _rows;
+  State *_start_state{nullptr};
+  State *_dead_state{nullptr};
+  std::pmr::vector<size_t> _pattern_lens;
+  std::pmr::vector<GroupID> _pattern_groups;
   size_t _min_pattern_len{std::numeric_limits<size_t>::max ()};
   size_t _max_pattern_len{0};
   bool _ignore_case{false};
+  size_t _memory_limit{std::numeric_limits<size_t>::max ()};
+  size_t _num_threads{1};
 };
 
 }  // namespace automaton
@@ -0,0 +1,75 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _REPLICATED_SEARCHER_H_
+#define _REPLICATED_SEARCHER_H_
+
+#include <ac/ahocorasick.h>
+#include <ac/utils/numa.h>
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief An AhoCorasick searcher replicated once per NUMA node, so that threads look up transitions in memory of their
+ *  own node instead of paying the cross-node latency on every byte.
+ *
+ * Every replica is built by a thread bound to its node, so that its memory is allocated there on first touch (engines
+ *  cannot be copied, an NFA's states point into each other). A search thread uses local (), the replica of the node it
+ *  runs on. If config.memory_resource is set, it is used by all replicas and thus decides where their memory is.
+ *
+ * The threads of a node share its replica, so engines that must not be searched by multiple threads at once are
+ *  refused: lazy DFAs do not compile, and a std::invalid_argument is thrown for AutomatonType::LAZY_DFA.
+ *
+ * @code
+ * ReplicatedSearcher<automaton::ContiguousNFA> searcher (patterns, BuildConfig{}, NumaTopology::detect ());
+ * auto counts = searcher.match_histogram (input, 0);
+ * @endcode
+ */
+template <typename automaton_type>
+class ReplicatedSearcher {
+  static_assert(!detail::is_lazy_dfa<automaton_type>, "a lazy DFA must not be shared by the threads of a node");
+
+ public:
+  ReplicatedSearcher(const PatternSet &patterns, const BuildConfig &config,
+                     NumaTopology topology = NumaTopology::detect());
+
+  [[nodiscard]]
+  const NumaTopology &topology() const;
+
+  [[nodiscard]]
+  const AhoCorasick<automaton_type> &replica(size_t node) const;
+
+  /**
+   * @brief Get the replica of the node the calling thread runs on (see NumaTopology::current_node).
+   */
+  [[nodiscard]]
+  const AhoCorasick<automaton_type> &local() const;
+
+  /**
+   * @brief Same as AhoCorasick::match_histogram, but the segments are counted by threads bound to the node that holds
+   *  their input pages (see NumaTopology::node_of), using the replica of that node. Segments whose node is not known
+   *  are distributed round robin. A thread that has counted all segments of its node helps with those of the others.
+   * @param input
+   * @param num_threads total number of threads, at least one per node. 0 means one per hardware thread.
+   * @param groups only count matches of patterns of these groups
+   * @return
+   */
+  [[nodiscard]]
+  std::vector<size_t> match_histogram(std::string_view input, size_t num_threads = 0,
+                                      GroupMask groups = ALL_GROUPS) const;
+
+ private:
+  NumaTopology _topology;
+  MatchKind _match_kind;
+  size_t _num_patterns;
+  /// replica by node
+  std::vector<std::unique_ptr<AhoCorasick<automaton_type>>> _replicas;
+};
+
+#endif //_REPLICATED_SEARCHER_H_
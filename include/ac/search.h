@@ -8,10 +8,161 @@
 #ifndef _SEARCH_H_
 #define _SEARCH_H_
 
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <string>
+
+class StateLayout;
+
 enum MatchKind {
   STANDARD,
   LEFTMOST_FIRST,
   LEFTMOST_LONGEST
 };
 
+enum AutomatonType {
+  NFA,
+  CONTIGUOUS_NFA,
+  /// DFA computed lazily from a ContiguousNFA while searching (see automaton::LazyDFA)
+  LAZY_DFA,
+  /// choose an engine at build time (see automaton::select_automaton_type)
+  AUTO
+};
+
+/**
+ * @brief Options used for constructing an automaton. Usually set through AhoCorasickBuilder.
+ */
+struct BuildConfig {
+  MatchKind match_kind{MatchKind::STANDARD};
+  bool ascii_case_insensitive{false};
+  AutomatonType automaton_type{AutomatonType::AUTO};
+  /// AutomatonType::AUTO prefers faster engines only as long as their estimated size does not exceed this budget
+  size_t memory_budget{size_t{256} << 20};
+  /// skip input that cannot start a match while searching (see Prefilter)
+  bool prefilter{true};
+  /// let engines that support it define transitions over the CharSet of the patterns instead of over all 256 bytes
+  bool byte_classes{true};
+  /// maximum number of states a DFA engine may hold at once. A lazy DFA clears its cache when reaching it, even if
+  ///  dfa_cache_size is not used up. Building a lazy DFA fails with a std::length_error if this is below
+  ///  LazyDFA::MIN_STATES.
+  size_t dfa_state_limit{size_t{1} << 20};
+  /// number of bytes a lazy DFA may use for caching states before its cache is cleared
+  size_t dfa_cache_size{size_t{2} << 20};
+  /// a lazy DFA with at most this many byte classes (e.g. DNA, digits or hex digits) also caches transitions over two
+  ///  bytes at once, halving the number of dependent lookups of MatchKind::STANDARD searches without whole_words and
+  ///  groups (see LazyDFA::next_state_pair). Each state then takes classes * classes more transitions, so this is only
+  ///  done if dfa_cache_size suffices for all states. 0 disables it.
+  size_t dfa_pair_classes{20};
+  /// hard limit of the automaton size in bytes. Exceeding it makes the construction fail with a std::length_error.
+  size_t memory_limit{std::numeric_limits<size_t>::max ()};
+  /// number of threads used for building engines that support parallel construction. 0 means one per hardware thread.
+  size_t build_threads{1};
+  /// only report matches that are whole words, i.e. neither preceded nor followed by a word character
+  bool whole_words{false};
+  /// the bytes words consist of if whole_words is set, ASCII letters, digits and '_' if empty
+  std::string word_chars{};
+  /// resource the engines allocate their data from (see memory_resource), the default resource if nullptr. E.g. a
+  ///  std::pmr::monotonic_buffer_resource constructs an automaton in an arena. It must outlive the automaton and it
+  ///  must be thread safe unless build_threads is 1.
+  std::pmr::memory_resource *memory_resource{nullptr};
+  /// allocate the transition tables of the engines from huge_page_resource () (see HugePageResource)
+  bool huge_pages{false};
+  /// order to store the states of ContiguousNFA engines in (see ContiguousNFA::profile), breadth first if nullptr. It
+  ///  must have been computed for the same patterns and options, otherwise the construction fails with a
+  ///  std::invalid_argument. It only needs to outlive the construction.
+  const StateLayout *state_layout{nullptr};
+  /// patterns longer than this are added to the automaton only by their first long_pattern_threshold bytes, matches
+  ///  of which are confirmed against the input (see LongPatterns), e.g. for binary signatures of several KB. 0 adds all
+  ///  patterns completely. Only used for MatchKind::STANDARD without whole_words. If a pattern is long, find_lines,
+  ///  find_iter_async, find_iter_chunks, find_anchored and longest_prefix throw a std::invalid_argument.
+  size_t long_pattern_threshold{0};
+};
+
+/// Index of a pattern in the list of patterns an automaton was built from
+using PatternID = uint32_t;
+
+/// Group a pattern belongs to, e.g. a rule set. Groups are numbered from 0 to MAX_GROUPS - 1.
+using GroupID = uint8_t;
+
+/// Set of groups: bit g is set if group g is contained
+using GroupMask = uint64_t;
+
+constexpr size_t MAX_GROUPS{64};
+constexpr GroupMask ALL_GROUPS{~GroupMask{0}};
+
+/**
+ * @brief A match of a pattern at the half-open byte range [start, end) of the searched input.
+ */
+struct Match {
+  PatternID pattern;
+  size_t start;
+  size_t end;
+
+  bool operator== (const Match &) const = default;
+};
+
+/**
+ * @brief A match reported by line: the line containing the start of a match of pattern.
+ */
+struct LineMatch {
+  PatternID pattern;
+  /// 1-based number of the line
+  size_t line_number;
+  /// [line_start, line_end) is the line without its terminating '\n'
+  size_t line_start;
+  size_t line_end;
+
+  bool operator== (const LineMatch &) const = default;
+};
+
+/**
+ * @brief Limits of a single call of AhoCorasick::find_budgeted: the search returns as soon as either is reached.
+ */
+struct SearchBudget {
+  /// number of bytes searched between two reads of the clock
+  static constexpr size_t CHECK_INTERVAL{size_t{1} << 16};
+
+  /// maximum number of bytes to search
+  size_t max_bytes{std::numeric_limits<size_t>::max ()};
+  /// point in time to return at. It is checked every CHECK_INTERVAL bytes, so it is exceeded by up to their search
+  ///  time.
+  std::chrono::steady_clock::time_point deadline{std::chrono::steady_clock::time_point::max ()};
+};
+
+/**
+ * @brief Position of a search that is split into several calls of AhoCorasick::find_budgeted. A default constructed
+ *  cursor is at the start of the input. The cursor only holds offsets, so it can be copied and kept as long as the
+ *  input, e.g. across calls that search other inputs with the same searcher.
+ */
+class SearchCursor {
+ public:
+  /**
+   * @brief Get the number of bytes of the input that are done: all matches ending there (MatchKind::STANDARD) or
+   *  starting before (leftmost match kinds) were reported.
+   */
+  [[nodiscard]]
+  size_t offset () const
+  {
+          return _offset;
+  }
+
+  /**
+   * @brief Check if the whole input was searched.
+   */
+  [[nodiscard]]
+  bool done () const
+  {
+          return _done;
+  }
+
+ private:
+  template<typename automaton_type> friend class AhoCorasick;
+
+  size_t _offset{0};
+  bool _done{false};
+};
+
 #endif //_SEARCH_H_
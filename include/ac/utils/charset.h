@@ -37,21 +37,22 @@ class CharSet {
   unsigned char get_char (CodePoint code_point) const;
 
   /**
-   * @brief Get the size of the charset.
+   * @brief Get the size of the charset, i.e. the number of distinct code points. Code point 0 is shared by all chars
+   *  that were never added.
    * @return
    */
   [[nodiscard]]
-  uint8_t size () const;
+  uint16_t size () const;
 
   /**
-   * @brief Add a char to the charset
+   * @brief Add a char to the charset. Adding a char that is already part of the charset is a no-op.
    * @param c
    */
   void add_char (unsigned char c);
 
  private:
   /// size of the charset
-  uint8_t _size {1};
+  uint16_t _size {1};
   /// used for mapping a char to a code point of the charset
   CodePoint _mapping[256] {0};
   /// used for mapping a code point of the charset to a char
@@ -0,0 +1,138 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _DECOMPRESS_H_
+#define _DECOMPRESS_H_
+
+#include <ac/utils/generator.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+enum class Compression {
+  NONE,
+  GZIP,
+  ZSTD
+};
+
+/**
+ * @brief Detect the compression of data by its magic bytes. Data that is neither gzip nor zstd compressed is NONE.
+ * @param head the first (at least 4) bytes of the data
+ * @return
+ */
+Compression detect_compression (std::string_view head);
+
+/**
+ * @brief Check if the library was built with support for compression (zlib for GZIP, libzstd for ZSTD).
+ */
+bool compression_supported (Compression compression);
+
+namespace detail {
+
+class Decoder;
+
+}  // namespace detail
+
+/**
+ * @brief Reads a file and decompresses it on a separate thread, so that the decompressed data can be searched while
+ *  the next part is decompressed.
+ *
+ * The decompressing thread fills a ring of num_buffers reusable buffers, the consumer takes them in order using next ()
+ *  and hands a buffer back by requesting the next one. The data is searched in place, it is never copied into a
+ *  buffer holding the whole file, so offsets of matches found by AhoCorasick::find_iter_chunks are positions within
+ *  the decompressed data. Whether and how the file is compressed is detected from its magic bytes, uncompressed files
+ *  are only read ahead. Concatenated gzip members and zstd frames are decompressed as a single stream.
+ *
+ * @code
+ * DecompressingReader reader ("access.log.gz");
+ * for (const auto &match : searcher.find_iter_chunks (reader.chunks ())) { ... }
+ * @endcode
+ */
+class DecompressingReader {
+ public:
+  static constexpr size_t DEFAULT_BUFFER_SIZE{size_t{1} << 20};
+  static constexpr size_t DEFAULT_NUM_BUFFERS{4};
+
+  /**
+   * @brief Open path and start decompressing it. A std::runtime_error is thrown if path cannot be opened or the library
+   *  was built without support for its compression.
+   * @param path
+   * @param buffer_size size of every buffer of the ring, i.e. the maximum size of a chunk
+   * @param num_buffers number of buffers of the ring, at least 2, so that decompressing and searching overlap
+   */
+  explicit DecompressingReader (const std::filesystem::path &path, size_t buffer_size = DEFAULT_BUFFER_SIZE,
+                                size_t num_buffers = DEFAULT_NUM_BUFFERS);
+  DecompressingReader (const DecompressingReader &) = delete;
+  DecompressingReader &operator= (const DecompressingReader &) = delete;
+
+  /**
+   * @brief Stop decompressing and wait for the decompressing thread to finish.
+   */
+  ~DecompressingReader ();
+
+  [[nodiscard]]
+  Compression compression () const;
+
+  /**
+   * @brief Get the next chunk of the decompressed data, waiting for it to be decompressed if necessary. The previous
+   *  chunk is handed back to the decompressing thread and must not be used anymore. If decompressing failed (e.g.
+   *  because the data is corrupt or truncated), the error is rethrown once all chunks before it were taken.
+   * @return the next chunk, nothing at the end of the data
+   */
+  std::optional<std::string_view> next ();
+
+  /**
+   * @brief Get the remaining chunks (see next) as a generator, e.g. for AhoCorasick::find_iter_chunks.
+   * @return
+   */
+  Generator<std::string_view> chunks ();
+
+ private:
+  /// Run by the decompressing thread: fill buffers until the end of the file is reached or stop is requested
+  void produce ();
+
+  /// Wait for a buffer not held by the consumer. Returns nullptr if stop is requested.
+  std::string *acquire ();
+
+  /// Fill buffer with the next decompressed bytes. Less than buffer.size () bytes are filled only at the end of data.
+  size_t fill (std::span<char> buffer);
+
+  std::ifstream _file;
+  std::string _path;
+  Compression _compression{Compression::NONE};
+  std::unique_ptr<detail::Decoder> _decoder;
+  /// compressed input read from _file, _pending is the part of it not decompressed yet
+  std::string _input;
+  std::string_view _pending;
+  bool _end_of_file{false};
+  std::vector<std::string> _buffers;
+  /// number of bytes filled in every buffer
+  std::vector<size_t> _lengths;
+  /// number of buffers filled by the decompressing thread, taken by the consumer and handed back by the consumer
+  size_t _produced{0};
+  size_t _consumed{0};
+  size_t _released{0};
+  bool _done{false};
+  bool _stop{false};
+  std::exception_ptr _exception{nullptr};
+  std::mutex _mutex;
+  std::condition_variable _changed;
+  std::thread _thread;
+};
+
+#endif //_DECOMPRESS_H_
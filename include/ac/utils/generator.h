@@ -0,0 +1,330 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _GENERATOR_H_
+#define _GENERATOR_H_
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <utility>
+
+/**
+ * @brief A lazily evaluated sequence of values produced by a coroutine using co_yield.
+ *
+ * The coroutine runs until its next co_yield whenever the iterator is advanced, so nothing is computed before the
+ *  first value is requested and nothing after the consumer stops iterating. An exception thrown by the coroutine is
+ *  rethrown by begin () or operator++.
+ *
+ * @code
+ * Generator<int> count (int n)
+ * {
+ *   for (int i = 0; i < n; ++i) co_yield i;
+ * }
+ * for (int i : count (3)) { ... }
+ * @endcode
+ */
+template<typename T>
+class Generator {
+ public:
+  struct promise_type {
+    std::optional<T> value{};
+    std::exception_ptr exception{nullptr};
+
+    Generator get_return_object ()
+    {
+            return Generator (std::coroutine_handle<promise_type>::from_promise (*this));
+    }
+
+    std::suspend_always initial_suspend () noexcept
+    {
+            return {};
+    }
+
+    std::suspend_always final_suspend () noexcept
+    {
+            return {};
+    }
+
+    std::suspend_always yield_value (T v)
+    {
+            value = std::move (v);
+            return {};
+    }
+
+    void return_void ()
+    {}
+
+    void unhandled_exception ()
+    {
+            exception = std::current_exception ();
+    }
+  };
+
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+
+    iterator () = default;
+    explicit iterator (std::coroutine_handle<promise_type> handle) : _handle (handle)
+    {}
+
+    const T &operator* () const
+    {
+            return *_handle.promise ().value;
+    }
+
+    const T *operator-> () const
+    {
+            return &*_handle.promise ().value;
+    }
+
+    iterator &operator++ ()
+    {
+            resume (_handle);
+            return *this;
+    }
+
+    void operator++ (int)
+    {
+            ++*this;
+    }
+
+    bool operator== (std::default_sentinel_t) const
+    {
+            return _handle == nullptr || _handle.done ();
+    }
+
+   private:
+    std::coroutine_handle<promise_type> _handle{nullptr};
+  };
+
+  Generator () = default;
+
+  Generator (Generator &&other) noexcept : _handle (std::exchange (other._handle, nullptr))
+  {}
+
+  Generator &operator= (Generator &&other) noexcept
+  {
+          if (this != &other)
+                  {
+                          destroy ();
+                          _handle = std::exchange (other._handle, nullptr);
+                  }
+          return *this;
+  }
+
+  Generator (const Generator &) = delete;
+  Generator &operator= (const Generator &) = delete;
+
+  ~Generator ()
+  {
+          destroy ();
+  }
+
+  /**
+   * @brief Run the coroutine until it yields its first value. Must be called once only.
+   * @return
+   */
+  iterator begin ()
+  {
+          if (_handle != nullptr)
+                  {
+                          resume (_handle);
+                  }
+          return iterator (_handle);
+  }
+
+  std::default_sentinel_t end () const
+  {
+          return {};
+  }
+
+ private:
+  explicit Generator (std::coroutine_handle<promise_type> handle) : _handle (handle)
+  {}
+
+  static void resume (std::coroutine_handle<promise_type> handle)
+  {
+          handle.promise ().value.reset ();
+          handle.resume ();
+          if (handle.promise ().exception)
+                  {
+                          std::rethrow_exception (std::exchange (handle.promise ().exception, nullptr));
+                  }
+  }
+
+  void destroy ()
+  {
+          if (_handle != nullptr)
+                  {
+                          _handle.destroy ();
+                          _handle = nullptr;
+                  }
+  }
+
+  std::coroutine_handle<promise_type> _handle{nullptr};
+};
+
+/**
+ * @brief A lazily evaluated sequence of values produced by a coroutine that may co_await between two co_yields.
+ *
+ * The values are pulled by a consumer coroutine with co_await next (), which resumes the generator until it yields
+ *  the next value (std::optional holding it) or returns (std::nullopt). While the generator itself waits for
+ *  something it awaits (e.g. an async read), the consumer stays suspended and is resumed as soon as the value is
+ *  ready, on the thread that resumed the generator. No executor is involved.
+ *
+ * @code
+ * AsyncGenerator<std::string_view> read_chunks (Socket &socket)
+ * {
+ *   while (auto chunk = co_await socket.async_read ()) co_yield *chunk;
+ * }
+ * ...
+ * while (auto value = co_await generator.next ()) { ... }
+ * @endcode
+ */
+template<typename T>
+class AsyncGenerator {
+ public:
+  struct promise_type;
+  using handle_type = std::coroutine_handle<promise_type>;
+
+  /// Suspends the generator and continues the consumer waiting in next ()
+  struct YieldAwaiter {
+    bool await_ready () noexcept
+    {
+            return false;
+    }
+
+    std::coroutine_handle<> await_suspend (handle_type handle) noexcept
+    {
+            return handle.promise ().consumer;
+    }
+
+    void await_resume () noexcept
+    {}
+  };
+
+  struct promise_type {
+    std::optional<T> value{};
+    std::exception_ptr exception{nullptr};
+    std::coroutine_handle<> consumer{std::noop_coroutine ()};
+
+    AsyncGenerator get_return_object ()
+    {
+            return AsyncGenerator (handle_type::from_promise (*this));
+    }
+
+    std::suspend_always initial_suspend () noexcept
+    {
+            return {};
+    }
+
+    YieldAwaiter final_suspend () noexcept
+    {
+            return {};
+    }
+
+    YieldAwaiter yield_value (T v)
+    {
+            value = std::move (v);
+            return {};
+    }
+
+    void return_void ()
+    {}
+
+    void unhandled_exception ()
+    {
+            exception = std::current_exception ();
+    }
+  };
+
+  /// Resumes the generator until it yields or returns
+  struct NextAwaiter {
+    handle_type handle;
+
+    bool await_ready () noexcept
+    {
+            return handle == nullptr || handle.done ();
+    }
+
+    std::coroutine_handle<> await_suspend (std::coroutine_handle<> consumer) noexcept
+    {
+            handle.promise ().consumer = consumer;
+            handle.promise ().value.reset ();
+            return handle;
+    }
+
+    std::optional<T> await_resume ()
+    {
+            if (handle == nullptr)
+                    {
+                            return std::nullopt;
+                    }
+            if (handle.promise ().exception)
+                    {
+                            std::rethrow_exception (std::exchange (handle.promise ().exception, nullptr));
+                    }
+            return std::exchange (handle.promise ().value, std::nullopt);
+    }
+  };
+
+  AsyncGenerator () = default;
+
+  AsyncGenerator (AsyncGenerator &&other) noexcept : _handle (std::exchange (other._handle, nullptr))
+  {}
+
+  AsyncGenerator &operator= (AsyncGenerator &&other) noexcept
+  {
+          if (this != &other)
+                  {
+                          destroy ();
+                          _handle = std::exchange (other._handle, nullptr);
+                  }
+          return *this;
+  }
+
+  AsyncGenerator (const AsyncGenerator &) = delete;
+  AsyncGenerator &operator= (const AsyncGenerator &) = delete;
+
+  ~AsyncGenerator ()
+  {
+          destroy ();
+  }
+
+  /**
+   * @brief Get the next value: co_await next () yields std::nullopt once the generator returned. Only one next () may
+   *  be awaited at a time.
+   * @return
+   */
+  NextAwaiter next ()
+  {
+          return NextAwaiter{_handle};
+  }
+
+ private:
+  explicit AsyncGenerator (handle_type handle) : _handle (handle)
+  {}
+
+  void destroy ()
+  {
+          if (_handle != nullptr)
+                  {
+                          _handle.destroy ();
+                          _handle = nullptr;
+                  }
+  }
+
+  handle_type _handle{nullptr};
+};
+
+#endif //_GENERATOR_H_
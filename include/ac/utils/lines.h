@@ -0,0 +1,58 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _LINES_H_
+#define _LINES_H_
+
+#include <cstddef>
+#include <string_view>
+
+/**
+ * @brief Count the '\n' bytes within input. Uses SSE2 (or AVX2) if available.
+ * @param input
+ * @return
+ */
+size_t count_newlines (std::string_view input);
+
+/**
+ * @brief Finds the line containing a position of an input, without looking at the input in between two lookups
+ *  more than once.
+ *
+ * Line numbers are maintained lazily: the newlines between the line of the previous lookup and the new position are
+ *  counted in bulk (see count_newlines) only when a lookup leaves the current line. Positions may be looked up in any
+ *  order, but lookups close to each other (e.g. matches in the order they are found) are cheap.
+ */
+class LineLocator {
+ public:
+  explicit LineLocator (std::string_view input);
+
+  /**
+   * @brief Move to the line containing pos.
+   * @param pos position within [0, input.size ()]
+   */
+  void locate (size_t pos);
+
+  /// 1-based number of the current line
+  [[nodiscard]]
+  size_t line_number () const;
+
+  /// position of the first byte of the current line
+  [[nodiscard]]
+  size_t line_start () const;
+
+  /// position of the '\n' terminating the current line, or input.size () for the last line
+  [[nodiscard]]
+  size_t line_end () const;
+
+ private:
+  std::string_view _input;
+  size_t _line_number{1};
+  size_t _line_start{0};
+  size_t _line_end;
+};
+
+#endif //_LINES_H_
@@ -0,0 +1,123 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _LONG_PATTERNS_H_
+#define _LONG_PATTERNS_H_
+
+#include <ac/search.h>
+#include <ac/utils/pattern_set.h>
+
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Patterns longer than a threshold, e.g. binary signatures of several KB, that an automaton only contains by
+ *  their first threshold bytes, their anchor (see BuildConfig::long_pattern_threshold). Otherwise, every byte of such
+ *  a pattern would take a state with a transition row of its own.
+ *
+ * A match of an anchor is a candidate that is confirmed against the input by comparing the rest of the pattern, i.e.
+ *  the bytes following the anchor, with memcmp (or byte by byte if ascii_case_insensitive). The comparison stops at
+ *  the first differing byte, so rejecting a candidate usually takes a few bytes only.
+ */
+class LongPatterns {
+ public:
+  LongPatterns () = default;
+
+  /**
+   * @param patterns
+   * @param threshold patterns longer than this are long. 0 means that no pattern is long.
+   * @param ascii_case_insensitive
+   */
+  LongPatterns (const PatternSet &patterns, size_t threshold, bool ascii_case_insensitive);
+
+  /**
+   * @brief Check if there is no long pattern.
+   */
+  [[nodiscard]]
+  bool empty () const;
+
+  [[nodiscard]]
+  size_t threshold () const;
+
+  [[nodiscard]]
+  bool is_long (PatternID pattern) const;
+
+  /**
+   * @brief Get patterns with every long pattern cut to its anchor. IDs and groups are kept.
+   * @param patterns the patterns passed to the constructor
+   * @return
+   */
+  [[nodiscard]]
+  PatternSet anchors (const PatternSet &patterns) const;
+
+  /**
+   * @brief Check if the long pattern occurs in input at start. Its anchor must match there, only the following bytes
+   *  are compared.
+   * @param input
+   * @param start
+   * @param bytes the long pattern
+   * @return
+   */
+  [[nodiscard]]
+  bool confirm (std::string_view input, size_t start, std::string_view bytes) const;
+
+  [[nodiscard]]
+  size_t memory_usage () const;
+
+ private:
+  size_t _threshold{0};
+  bool _ignore_case{false};
+  size_t _num_long{0};
+  std::vector<bool> _long;
+};
+
+/**
+ * @brief Turns the matches of an automaton built from LongPatterns::anchors into the matches of the patterns: anchor
+ *  matches are confirmed and, since a long pattern ends after its anchor, queued until all matches ending before it
+ *  were reported. Matches of other patterns pass through unchanged.
+ *
+ * @code
+ * if (queue.push (match)) { while (auto m = queue.pop (match.end)) report (*m); report (match); }
+ * // at the end of the input
+ * while (auto m = queue.pop ()) report (*m);
+ * @endcode
+ */
+class LongMatchQueue {
+ public:
+  LongMatchQueue (const LongPatterns &long_patterns, const PatternSet &patterns, std::string_view input);
+
+  /**
+   * @brief Add a match of the automaton. A confirmed anchor match is queued as the match of its pattern, an
+   *  unconfirmed one is dropped.
+   * @return true if match is not an anchor match and is to be reported (after the queued matches ending before it)
+   */
+  bool push (const Match &match);
+
+  /**
+   * @brief Remove the queued match that ends first if it ends at or before end.
+   */
+  std::optional<Match> pop (size_t end = std::numeric_limits<size_t>::max ());
+
+ private:
+  struct EndsLater {
+    bool operator() (const Match &a, const Match &b) const
+    {
+            return a.end > b.end || (a.end == b.end && a.pattern > b.pattern);
+    }
+  };
+
+  const LongPatterns &_long_patterns;
+  const PatternSet &_patterns;
+  std::string_view _input;
+  std::priority_queue<Match, std::vector<Match>, EndsLater> _queue;
+};
+
+#endif //_LONG_PATTERNS_H_
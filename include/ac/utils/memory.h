@@ -0,0 +1,62 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _MEMORY_H_
+#define _MEMORY_H_
+
+#include <ac/search.h>
+
+#include <cstddef>
+#include <memory_resource>
+
+/**
+ * @brief Memory resource that backs large allocations, e.g. transition tables, with 2 MiB huge pages to reduce TLB
+ *  misses when searching large automata.
+ *
+ * Allocations of at least MIN_SIZE bytes are mapped separately, aligned to HUGE_PAGE_SIZE: from the reserved huge
+ *  pages (MAP_HUGETLB) if there are any left, otherwise as normal pages that the kernel is advised to back with
+ *  transparent huge pages (MADV_HUGEPAGE). Smaller allocations, and all allocations on systems other than Linux, are
+ *  passed to the upstream resource.
+ */
+class HugePageResource : public std::pmr::memory_resource {
+ public:
+  static constexpr size_t HUGE_PAGE_SIZE{size_t{2} << 20};
+  /// minimum size of an allocation that is backed by huge pages
+  static constexpr size_t MIN_SIZE{HUGE_PAGE_SIZE / 2};
+
+  explicit HugePageResource (std::pmr::memory_resource *upstream = std::pmr::new_delete_resource ());
+
+  [[nodiscard]]
+  std::pmr::memory_resource *upstream_resource () const;
+
+ private:
+  void *do_allocate (size_t bytes, size_t alignment) override;
+  void do_deallocate (void *p, size_t bytes, size_t alignment) override;
+  [[nodiscard]]
+  bool do_is_equal (const std::pmr::memory_resource &other) const noexcept override;
+
+  std::pmr::memory_resource *_upstream;
+};
+
+/**
+ * @brief Get a process wide HugePageResource passing small allocations to std::pmr::new_delete_resource ().
+ */
+std::pmr::memory_resource *huge_page_resource ();
+
+/**
+ * @brief Get the resource engines allocate their data from: config.memory_resource, or the default resource if it is
+ *  not set.
+ */
+std::pmr::memory_resource *memory_resource (const BuildConfig &config);
+
+/**
+ * @brief Get the resource engines allocate their transition tables from: huge_page_resource () if config.huge_pages
+ *  is set, memory_resource (config) otherwise.
+ */
+std::pmr::memory_resource *table_resource (const BuildConfig &config);
+
+#endif //_MEMORY_H_
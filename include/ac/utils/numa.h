@@ -0,0 +1,108 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _NUMA_H_
+#define _NUMA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief The NUMA nodes of the machine and the CPUs of every node, read from /sys/devices/system/node without
+ *  libnuma.
+ *
+ * Nodes are numbered densely from 0, in the order of their system IDs. A topology can also be described explicitly
+ *  (see parse), e.g. to test NUMA-aware code on a single node machine. Memory of such a fake topology is assumed to be
+ *  interleaved across its nodes in blocks of FAKE_INTERLEAVE bytes.
+ *
+ * Every constructed topology has its own thread bindings (see bind_thread), which its copies share.
+ */
+class NumaTopology {
+ public:
+  /// block size a fake topology assumes memory to be interleaved in
+  static constexpr size_t FAKE_INTERLEAVE{size_t{1} << 20};
+
+  /**
+   * @brief Construct a topology of a single node that all CPUs belong to.
+   */
+  NumaTopology ();
+
+  /**
+   * @brief Read the topology of this machine. If it cannot be read, e.g. on systems other than Linux, a single node
+   *  is returned.
+   */
+  static NumaTopology detect ();
+
+  /**
+   * @brief Construct a fake topology from a description of the CPUs of every node, separated by ';', each a list of
+   *  CPUs and CPU ranges like in /sys: e.g. "0-3,8-11;4-7,12-15" for two nodes. Nodes may share CPUs, e.g. "0;0"
+   *  describes two nodes on a single CPU. A std::invalid_argument is thrown if description is malformed.
+   * @param description
+   * @return
+   */
+  static NumaTopology parse (std::string_view description);
+
+  [[nodiscard]]
+  size_t num_nodes () const;
+
+  [[nodiscard]]
+  const std::vector<size_t> &cpus (size_t node) const;
+
+  [[nodiscard]]
+  bool fake () const;
+
+  /**
+   * @brief Get the node the calling thread runs on: the one it was bound to by bind_thread of this topology (or a copy
+   *  of it), otherwise the one of the CPU it currently runs on (0 if unknown).
+   */
+  [[nodiscard]]
+  size_t current_node () const;
+
+  /**
+   * @brief Restrict the calling thread to the CPUs of node, so that the memory it touches first is allocated on node.
+   * @param node
+   * @return false if the affinity could not be set. current_node () of this topology reports node nevertheless, that
+   *  of other topologies is not affected.
+   */
+  bool bind_thread (size_t node) const;
+
+  /**
+   * @brief Get the node the memory page containing address is allocated on (queried using move_pages), or nothing if
+   *  it is not known, e.g. because the page was not touched yet.
+   * @param address
+   * @return
+   */
+  [[nodiscard]]
+  std::optional<size_t> node_of (const void *address) const;
+
+ private:
+  /// CPUs by node
+  std::vector<std::vector<size_t>> _cpus;
+  /// system ID by node
+  std::vector<size_t> _ids;
+  bool _fake{false};
+  /// identifies the thread bindings of this topology and its copies
+  uint64_t _id;
+};
+
+/**
+ * @brief Run f (node, thread) on threads_per_node threads bound to every node of topology (see
+ *  NumaTopology::bind_thread). The threads are numbered node by node, from 0 to num_nodes () * threads_per_node. If f
+ *  throws, the first exception is rethrown on the calling thread after all threads have finished. If a thread cannot be
+ *  started, the std::system_error is rethrown after the threads started so far have finished.
+ * @param topology
+ * @param threads_per_node
+ * @param f
+ */
+void run_on_nodes (const NumaTopology &topology, size_t threads_per_node,
+                   const std::function<void (size_t node, size_t thread)> &f);
+
+#endif //_NUMA_H_
@@ -0,0 +1,33 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ * 
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * @brief Get the number of threads to use for a requested number of threads. 0 means one per hardware thread.
+ * @param requested
+ * @return
+ */
+size_t resolve_num_threads (size_t requested);
+
+/**
+ * @brief Run f(task, thread) for all tasks in [0, num_tasks) on up to num_threads threads.
+ *
+ * Tasks are handed out one by one, so tasks of different sizes are balanced automatically. If num_threads or
+ *  num_tasks is 1, everything is run on the calling thread. If a task throws, the remaining tasks are skipped and the
+ *  first exception is rethrown on the calling thread after all threads have finished.
+ * @param num_threads
+ * @param num_tasks
+ * @param f
+ */
+void parallel_for (size_t num_threads, size_t num_tasks, const std::function<void (size_t task, size_t thread)> &f);
+
+#endif //_PARALLEL_H_
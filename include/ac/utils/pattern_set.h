@@ -0,0 +1,150 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ * 
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _PATTERN_SET_H_
+#define _PATTERN_SET_H_
+
+#include <ac/search.h>
+
+#include <concepts>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief An immutable list of patterns stored in a single buffer.
+ *
+ * Patterns can be taken from any range of elements convertible to std::string_view (std::vector<std::string>,
+ *  std::vector<std::string_view>, arrays of C strings, ...). No std::string is created per pattern: all patterns are
+ *  concatenated into one buffer and addressed by their offsets.
+ */
+class PatternSet {
+ public:
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = std::string_view;
+
+    const_iterator () = default;
+    const_iterator (const PatternSet *set, PatternID id) : _set (set), _id (id)
+    {}
+
+    std::string_view operator* () const
+    {
+            return (*_set)[_id];
+    }
+
+    const_iterator &operator++ ()
+    {
+            ++_id;
+            return *this;
+    }
+
+    const_iterator operator++ (int)
+    {
+            auto tmp = *this;
+            ++_id;
+            return tmp;
+    }
+
+    bool operator== (const const_iterator &other) const
+    {
+            return _id == other._id;
+    }
+
+   private:
+    const PatternSet *_set{nullptr};
+    PatternID _id{0};
+  };
+
+  PatternSet () = default;
+
+  /**
+   * @brief Copy the patterns of a range. Not explicit, so that e.g. a std::vector<std::string> can be passed wherever
+   *  a PatternSet is expected.
+   * @param patterns
+   */
+  template<std::ranges::input_range R>
+  requires std::convertible_to<std::ranges::range_reference_t<const R &>, std::string_view>
+  PatternSet (const R &patterns)
+  {
+          if constexpr (std::ranges::forward_range<const R &>)
+                  {
+                          size_t total_len = 0;
+                          size_t count = 0;
+                          for (std::string_view pattern : patterns)
+                                  {
+                                          total_len += pattern.size ();
+                                          ++count;
+                                  }
+                          _bytes.reserve (total_len);
+                          _offsets.reserve (count + 1);
+                          _groups.reserve (count);
+                  }
+          for (std::string_view pattern : patterns)
+                  {
+                          add (pattern);
+                  }
+  }
+
+  PatternSet (std::initializer_list<std::string_view> patterns);
+
+  /**
+   * @brief Append a pattern. Its ID is the number of patterns added before.
+   * @param pattern
+   * @param group the group of the pattern, less than MAX_GROUPS. Searches can be restricted to some groups.
+   */
+  void add (std::string_view pattern, GroupID group = 0);
+
+  [[nodiscard]]
+  size_t size () const;
+
+  [[nodiscard]]
+  bool empty () const;
+
+  [[nodiscard]]
+  std::string_view operator[] (PatternID id) const;
+
+  [[nodiscard]]
+  GroupID group (PatternID id) const;
+
+  /**
+   * @brief Tell whether any pattern belongs to a group other than 0.
+   * @return
+   */
+  [[nodiscard]]
+  bool has_groups () const;
+
+  /**
+   * @brief Get the summed up length of all patterns.
+   * @return
+   */
+  [[nodiscard]]
+  size_t total_len () const;
+
+  [[nodiscard]]
+  const_iterator begin () const;
+
+  [[nodiscard]]
+  const_iterator end () const;
+
+ private:
+  std::string _bytes{};
+  /// pattern i is _bytes[_offsets[i], _offsets[i + 1])
+  std::vector<size_t> _offsets{0};
+  std::vector<GroupID> _groups{};
+  bool _has_groups{false};
+};
+
+#endif //_PATTERN_SET_H_
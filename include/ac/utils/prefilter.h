@@ -8,6 +8,92 @@
 #ifndef _PREFILTER_H_
 #define _PREFILTER_H_
 
+#include <ac/utils/pattern_set.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
 unsigned char opposite_ascii_case(unsigned char c);
 
+/**
+ * @brief Skips input that cannot be the start of a match.
+ *
+ * While a search is in the start state, no byte that does not start a pattern can change the state. The prefilter
+ *  jumps over such bytes, in one of two modes:
+ *  - If all patterns are at least MIN_WINDOW bytes long, a window of the minimum pattern length (at most MAX_WINDOW
+ *    bytes) is shifted over the input like in the Wu-Manber algorithm: a table tells by how far the window can be
+ *    shifted so that its last two bytes (a block) line up with the same block within the prefix of a pattern. A window
+ *    whose last block ends a pattern prefix is a candidate if its first block starts one as well. The search then
+ *    verifies the candidate by feeding it to the automaton. This looks at about window / shift bytes instead of all
+ *    of them. It is only used if the shift, averaged over the blocks of bytes the patterns consist of, is at least
+ *    MIN_MEAN_SHIFT.
+ *  - Otherwise, bytes that do not start a pattern are skipped: using memchr if all patterns start with the same byte,
+ *    or using a table of start bytes otherwise. This is only enabled if the start bytes are rare enough for skipping
+ *    to pay off and if there is no empty pattern (which would match at every position).
+ */
+class Prefilter {
+ public:
+  /// maximum number of distinct start bytes for which the prefilter is enabled
+  static constexpr size_t MAX_START_BYTES{32};
+  /// minimum length of all patterns for which windows are shifted
+  static constexpr size_t MIN_WINDOW{8};
+  /// maximum window length, a shift must fit into a byte
+  static constexpr size_t MAX_WINDOW{255};
+  /// minimum average shift for which windows are shifted
+  static constexpr size_t MIN_MEAN_SHIFT{4};
+
+  /**
+   * @brief Construct a disabled prefilter.
+   */
+  Prefilter() = default;
+
+  Prefilter(const PatternSet &patterns, bool ascii_i_case);
+
+  [[nodiscard]]
+  bool enabled() const;
+
+  /**
+   * @brief Get the length of the shifted window, or 0 if start bytes are skipped instead.
+   */
+  [[nodiscard]]
+  size_t window() const;
+
+  /**
+   * @brief Get the first position at or after at where a match may start, or input.size () if there is none. A
+   *  position whose window extends beyond input is always a candidate, so that input may be continued, e.g. by the
+   *  next chunk of an asynchronous search.
+   * @param input
+   * @param at
+   * @return
+   */
+  [[nodiscard]]
+  size_t find_candidate(std::string_view input, size_t at) const;
+
+ private:
+  [[nodiscard]]
+  size_t block(char first, char second) const
+  {
+    return (size_t{_fold[static_cast<unsigned char>(first)]} << 8) | _fold[static_cast<unsigned char>(second)];
+  }
+
+  bool init_window(const PatternSet &patterns, bool ascii_i_case);
+  size_t find_window(std::string_view input, size_t at) const;
+
+  bool _start_bytes[256]{false};
+  size_t _num_start_bytes{0};
+  /// the start byte if _num_start_bytes == 1
+  unsigned char _start_byte{0};
+  /// length of the shifted window, 0 if start bytes are skipped
+  size_t _window{0};
+  /// maps a byte to its lower case if ASCII case is ignored, to itself otherwise
+  unsigned char _fold[256]{0};
+  /// shift by block of the window's last two bytes
+  std::vector<uint8_t> _shift;
+  /// whether a pattern prefix starts with a block
+  std::vector<bool> _prefix_blocks;
+  bool _enabled{false};
+};
+
 #endif //_PREFILTER_H_
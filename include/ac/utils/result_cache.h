@@ -0,0 +1,99 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _RESULT_CACHE_H_
+#define _RESULT_CACHE_H_
+
+#include <ac/search.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief A bounded cache of the matches of small inputs that are searched repeatedly, e.g. user agents or URLs of log
+ *  records (see AhoCorasick::find_cached).
+ *
+ * Entries are keyed by the searcher that found them (see AhoCorasick::id), the groups searched for and the input
+ *  itself: the input is stored along with its matches, so a hash collision never returns wrong matches. The cache is
+ *  split into shards by the hash of the key, every shard is guarded by its own mutex and evicts its least recently used
+ *  entries once it holds more than its share of capacity bytes. Inputs longer than max_input_len are never cached, so
+ *  that searching large inputs does not evict the entries of small ones. A cache can be shared by several searchers
+ *  and threads.
+ */
+class ResultCache {
+ public:
+  static constexpr size_t DEFAULT_CAPACITY{size_t{64} << 20};
+  static constexpr size_t DEFAULT_NUM_SHARDS{16};
+  static constexpr size_t DEFAULT_MAX_INPUT_LEN{4096};
+
+  struct Stats {
+    size_t hits{0};
+    size_t misses{0};
+    size_t evictions{0};
+    /// inputs longer than max_input_len that were not looked up
+    size_t skipped{0};
+    /// number and size (inputs, matches and bookkeeping) of the entries
+    size_t entries{0};
+    size_t bytes{0};
+  };
+
+  /**
+   * @param capacity maximum size of all entries in bytes, see Stats::bytes
+   * @param num_shards number of independently locked shards, at least 1
+   * @param max_input_len inputs longer than this are never cached
+   */
+  explicit ResultCache (size_t capacity = DEFAULT_CAPACITY, size_t num_shards = DEFAULT_NUM_SHARDS,
+                        size_t max_input_len = DEFAULT_MAX_INPUT_LEN);
+  ResultCache (const ResultCache &) = delete;
+  ResultCache &operator= (const ResultCache &) = delete;
+  ~ResultCache ();
+
+  [[nodiscard]]
+  size_t max_input_len () const;
+
+  /**
+   * @brief Get the matches stored for input by searcher with groups, counting a hit or a miss. Inputs longer than
+   *  max_input_len are counted as skipped.
+   * @return the matches, nothing if none are stored
+   */
+  std::optional<std::vector<Match>> lookup (uint64_t searcher, GroupMask groups, std::string_view input);
+
+  /**
+   * @brief Store the matches of input found by searcher with groups, evicting the least recently used entries of its
+   *  shard if necessary. Inputs longer than max_input_len and entries larger than a shard are not stored.
+   */
+  void insert (uint64_t searcher, GroupMask groups, std::string_view input, std::span<const Match> matches);
+
+  /**
+   * @brief Get the counters and the size of the cache, summed over all shards.
+   */
+  [[nodiscard]]
+  Stats stats () const;
+
+  /**
+   * @brief Remove all entries. The counters are kept.
+   */
+  void clear ();
+
+ private:
+  struct Shard;
+
+  Shard &shard (size_t hash);
+
+  size_t _max_input_len;
+  size_t _shard_capacity;
+  std::atomic<size_t> _skipped{0};
+  std::vector<std::unique_ptr<Shard>> _shards;
+};
+
+#endif //_RESULT_CACHE_H_
@@ -0,0 +1,98 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _STATE_LAYOUT_H_
+#define _STATE_LAYOUT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+class PatternSet;
+struct BuildConfig;
+
+/**
+ * @brief The order in which an automaton stores its states, e.g. the most frequently visited states first, so that
+ *  the states a search spends most of its time in share a few cache lines and pages (see
+ *  automaton::ContiguousNFA::profile).
+ *
+ * States are identified by their index in breadth first order, which only depends on the patterns and on the options
+ *  that shape the trie: the match kind, ascii_case_insensitive, byte_classes and whole_words. A layout can therefore be
+ *  saved and applied to any automaton built from the same patterns with the same options (see
+ *  BuildConfig::state_layout). To tell, a layout carries the fingerprint of the patterns and options it was computed
+ *  for.
+ */
+class StateLayout {
+ public:
+  /**
+   * @brief The empty layout: states are stored in breadth first order.
+   */
+  StateLayout () = default;
+
+  /**
+   * @param order the breadth first index of the state stored at every position
+   * @param fingerprint see fingerprint (patterns, config)
+   */
+  StateLayout (std::vector<uint32_t> order, uint64_t fingerprint);
+
+  /**
+   * @brief Hash the patterns (in order) and the options of config that shape the trie. Layouts can only be applied to
+   *  automata of the same fingerprint.
+   * @param patterns
+   * @param config
+   * @return
+   */
+  static uint64_t fingerprint (const PatternSet &patterns, const BuildConfig &config);
+
+  /**
+   * @brief Read a layout written by save. A std::runtime_error is thrown if in does not contain one, e.g. if it is
+   *  truncated or its order is not a permutation of its states.
+   * @param in
+   * @return
+   */
+  static StateLayout load (std::istream &in);
+
+  /**
+   * @brief Write the layout to out in a binary format (native byte order).
+   * @param out
+   */
+  void save (std::ostream &out) const;
+
+  [[nodiscard]]
+  bool empty () const;
+
+  [[nodiscard]]
+  size_t num_states () const;
+
+  /**
+   * @brief Get the breadth first index of the state stored at every position.
+   */
+  [[nodiscard]]
+  const std::vector<uint32_t> &order () const;
+
+  [[nodiscard]]
+  uint64_t fingerprint () const;
+
+  /**
+   * @brief Check if the layout was computed for an automaton of fingerprint and is a permutation of its num_states
+   *  states.
+   */
+  [[nodiscard]]
+  bool valid_for (uint64_t fingerprint, size_t num_states) const;
+
+ private:
+  /// Check if _order is a permutation of its states
+  [[nodiscard]]
+  bool is_permutation () const;
+
+  std::vector<uint32_t> _order;
+  uint64_t _fingerprint{0};
+};
+
+#endif //_STATE_LAYOUT_H_
@@ -0,0 +1,83 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A thread pool whose workers steal tasks from each other.
+ *
+ * Every worker has its own task queue. A task submitted by a worker (e.g. the subdirectories found while walking a
+ *  directory) is put into the queue of that worker, which runs its own tasks newest first. A worker without tasks
+ *  steals the oldest task of another worker, i.e. the one that is most likely to spawn further work. Tasks submitted
+ *  from outside the pool are distributed round robin.
+ */
+class WorkStealingPool {
+ public:
+  /// A task gets the index of the worker running it, e.g. for using per worker buffers
+  using Task = std::function<void (size_t worker)>;
+
+  /**
+   * @brief Start the workers.
+   * @param num_threads number of workers, 0 means one per hardware thread (see resolve_num_threads)
+   */
+  explicit WorkStealingPool (size_t num_threads);
+  WorkStealingPool (const WorkStealingPool &) = delete;
+  WorkStealingPool &operator= (const WorkStealingPool &) = delete;
+
+  /// Waits for all tasks and stops the workers
+  ~WorkStealingPool ();
+
+  void submit (Task task);
+
+  /**
+   * @brief Wait until all tasks, including the ones submitted by tasks, are done. If a task threw, the first
+   *  exception is rethrown here; the remaining tasks are run nevertheless.
+   */
+  void wait ();
+
+  [[nodiscard]]
+  size_t num_threads () const;
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void run (size_t worker);
+  bool try_pop (size_t worker, Task &task);
+  bool try_steal (size_t worker, Task &task);
+
+  std::vector<std::unique_ptr<Queue>> _queues;
+  std::vector<std::thread> _threads;
+  /// number of tasks submitted but not finished yet
+  std::atomic<size_t> _pending{0};
+  /// number of tasks in the queues
+  std::atomic<size_t> _queued{0};
+  std::atomic<size_t> _next_queue{0};
+  bool _stop{false};
+  std::mutex _mutex;
+  /// notified when a task is submitted or the pool is stopped
+  std::condition_variable _work_available;
+  /// notified when the last pending task is finished
+  std::condition_variable _all_done;
+  std::exception_ptr _exception{nullptr};
+};
+
+#endif //_THREAD_POOL_H_
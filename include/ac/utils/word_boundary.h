@@ -0,0 +1,84 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _WORD_BOUNDARY_H_
+#define _WORD_BOUNDARY_H_
+
+#include <cstddef>
+#include <string_view>
+
+/**
+ * @brief Restricts matches to whole words (see BuildConfig::whole_words).
+ *
+ * A match [start, end) is a whole word if it is neither preceded nor followed by a word character, like with
+ *  grep -w. The start and the end of the input count as boundaries. The searches check the start of a match before
+ *  feeding the automaton: within a word, no byte is fed while the search is in the start state.
+ */
+class WordBoundary {
+ public:
+  /// word characters used if none are configured
+  static constexpr std::string_view DEFAULT_WORD_CHARS{
+          "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_"};
+
+  /**
+   * @brief Construct a disabled WordBoundary: every match is accepted.
+   */
+  WordBoundary () = default;
+
+  /**
+   * @param word_chars the bytes words consist of, DEFAULT_WORD_CHARS if empty
+   */
+  explicit WordBoundary (std::string_view word_chars);
+
+  [[nodiscard]]
+  bool enabled () const
+  {
+          return _enabled;
+  }
+
+  [[nodiscard]]
+  bool is_word (char c) const
+  {
+          return _word[static_cast<unsigned char>(c)];
+  }
+
+  /// Tell whether a match may start at pos of input
+  [[nodiscard]]
+  bool allows_start (std::string_view input, size_t pos) const
+  {
+          return !_enabled || pos == 0 || !is_word (input[pos - 1]);
+  }
+
+  /// Tell whether a match may end at pos of input
+  [[nodiscard]]
+  bool allows_end (std::string_view input, size_t pos) const
+  {
+          return !_enabled || pos == input.size () || !is_word (input[pos]);
+  }
+
+  [[nodiscard]]
+  bool allows (std::string_view input, size_t start, size_t end) const
+  {
+          return allows_start (input, start) && allows_end (input, end);
+  }
+
+  /**
+   * @brief Get the first position after pos at which a match may start: the one following the next non-word
+   *  character, or input.size () if there is none.
+   * @param input
+   * @param pos
+   * @return
+   */
+  [[nodiscard]]
+  size_t next_start (std::string_view input, size_t pos) const;
+
+ private:
+  bool _word[256]{false};
+  bool _enabled{false};
+};
+
+#endif //_WORD_BOUNDARY_H_
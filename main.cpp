@@ -1,14 +1,593 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
 #include <ac/ahocorasick.h>
+#include <ac/replicated_searcher.h>
+#include <ac/utils/decompress.h>
+#include <ac/utils/numa.h>
+#include <ac/utils/thread_pool.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char *USAGE = R"(usage: ac [options] <pattern file> <path>...
+
+Search files for the patterns listed in <pattern file> (one per line, empty lines are ignored). Directories are
+searched recursively, symbolic links found within directories are not followed. For every match, a line
+"<file>:<start>:<pattern>" is printed, or "<file>:<line number>:<line>" for every matching line with -n. The lines
+of a file are printed together, in the order the matches are found.
+
+options:
+  -i                  ignore the ASCII case
+  -w                  only match whole words: not preceded or followed by ASCII letters, digits or '_'
+  -k <kind>           match kind: standard (default, all matches), leftmost-first or leftmost-longest
+  -n                  print matching lines with their line numbers instead of the matches
+  -c                  only print the number of matches (or matching lines with -n) of every file with matches
+  --histogram         only print the number of matches of every pattern over all files, as "<count>:<pattern>"
+                      for every pattern with matches (-c and -n are ignored)
+  -z                  search gzip and zstd compressed files (detected by their magic bytes) while another thread
+                      decompresses them; reported offsets are positions in the decompressed data
+  -j <threads>        number of threads, 0 (default) means one per hardware thread
+  --mmap <bytes>      map files of at least this size instead of reading them (default: 1048576)
+  --numa              build the automaton once per NUMA node and bind every thread to a node, which searches the
+                      automaton of its node
+  --numa-topology <nodes>
+                      same as --numa, but for the given nodes instead of the ones of this machine: their CPU lists
+                      separated by ';', e.g. "0-3;4-7"
+  -h, --help          print this message
+
+exit status: 0 if a match was found, 1 if not, 2 if an error occurred
+)";
+
+struct Options {
+  std::string pattern_file;
+  std::vector<std::string> paths;
+  MatchKind match_kind{MatchKind::STANDARD};
+  bool ignore_case{false};
+  bool whole_words{false};
+  bool count_only{false};
+  bool line_mode{false};
+  bool histogram{false};
+  bool decompress{false};
+  size_t num_threads{0};
+  size_t mmap_threshold{size_t{1} << 20};
+  bool numa{false};
+  std::string numa_topology;
+};
+
+bool parse_size (const char *arg, size_t &value)
+{
+        char *end;
+        errno = 0;
+        unsigned long long parsed = std::strtoull (arg, &end, 10);
+        if (errno != 0 || end == arg || *end != '\0')
+                {
+                        return false;
+                }
+        value = parsed;
+        return true;
+}
+
+/**
+ * @brief Parse the command line into options.
+ * @return false if the command line is invalid
+ */
+bool parse_args (int argc, char **argv, Options &options)
+{
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; ++i)
+                {
+                        std::string_view arg = argv[i];
+                        bool has_value = i + 1 < argc;
+                        if (arg == "-i")
+                                {
+                                        options.ignore_case = true;
+                                }
+                        else if (arg == "-w")
+                                {
+                                        options.whole_words = true;
+                                }
+                        else if (arg == "-c")
+                                {
+                                        options.count_only = true;
+                                }
+                        else if (arg == "-n")
+                                {
+                                        options.line_mode = true;
+                                }
+                        else if (arg == "--histogram")
+                                {
+                                        options.histogram = true;
+                                }
+                        else if (arg == "-z")
+                                {
+                                        options.decompress = true;
+                                }
+                        else if (arg == "-k" && has_value)
+                                {
+                                        std::string_view kind = argv[++i];
+                                        if (kind == "standard")
+                                                options.match_kind = MatchKind::STANDARD;
+                                        else if (kind == "leftmost-first")
+                                                options.match_kind = MatchKind::LEFTMOST_FIRST;
+                                        else if (kind == "leftmost-longest")
+                                                options.match_kind = MatchKind::LEFTMOST_LONGEST;
+                                        else
+                                                return false;
+                                }
+                        else if (arg == "-j" && has_value)
+                                {
+                                        if (!parse_size (argv[++i], options.num_threads))
+                                                return false;
+                                }
+                        else if (arg == "--mmap" && has_value)
+                                {
+                                        if (!parse_size (argv[++i], options.mmap_threshold))
+                                                return false;
+                                }
+                        else if (arg == "--numa")
+                                {
+                                        options.numa = true;
+                                }
+                        else if (arg == "--numa-topology" && has_value)
+                                {
+                                        options.numa = true;
+                                        options.numa_topology = argv[++i];
+                                }
+                        else if (arg.size () > 1 && arg[0] == '-')
+                                {
+                                        return false;
+                                }
+                        else
+                                {
+                                        positional.emplace_back (arg);
+                                }
+                }
+        if (positional.size () < 2)
+                {
+                        return false;
+                }
+        options.pattern_file = positional[0];
+        options.paths.assign (positional.begin () + 1, positional.end ());
+        return true;
+}
+
+PatternSet read_patterns (const std::string &path)
+{
+        std::ifstream stream (path);
+        if (!stream)
+                {
+                        throw std::runtime_error (path + ": " + std::strerror (errno));
+                }
+        PatternSet patterns;
+        for (std::string line; std::getline (stream, line);)
+                {
+                        if (!line.empty () && line.back () == '\r')
+                                {
+                                        line.pop_back ();
+                                }
+                        if (!line.empty ())
+                                {
+                                        patterns.add (line);
+                                }
+                }
+        return patterns;
+}
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ */
+class MappedFile {
+ public:
+  MappedFile () = default;
+  MappedFile (const MappedFile &) = delete;
+  MappedFile &operator= (const MappedFile &) = delete;
+
+  ~MappedFile ()
+  {
+          if (_data != nullptr)
+                  {
+                          munmap (_data, _size);
+                  }
+  }
+
+  /**
+   * @return false if mapping failed, errno is set accordingly
+   */
+  bool map (int fd, size_t size)
+  {
+          void *data = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+          if (data == MAP_FAILED)
+                  {
+                          return false;
+                  }
+          _data = data;
+          _size = size;
+          madvise (_data, _size, MADV_SEQUENTIAL);
+          return true;
+  }
+
+  [[nodiscard]]
+  std::string_view view () const
+  {
+          return {static_cast<const char *>(_data), _size};
+  }
+
+ private:
+  void *_data{nullptr};
+  size_t _size{0};
+};
+
+/**
+ * @brief Check if the file open as fd is gzip or zstd compressed.
+ */
+bool is_compressed (int fd)
+{
+        char head[4];
+        ssize_t n = pread (fd, head, sizeof (head), 0);
+        return n > 0 && detect_compression (std::string_view (head, n)) != Compression::NONE;
+}
+
+/**
+ * @brief Scans files and directories on a WorkStealingPool. Every directory and every file is a task, so directory
+ *  walking is parallel as well. The workers of a NUMA node share its replica of the searcher, each worker has its own
+ *  read buffer and, with --histogram, its own match counts, which are summed up once all files are scanned.
+ */
+class Scanner {
+ public:
+  Scanner (const Options &options, const ReplicatedSearcher<automaton::Dynamic> &searcher, const PatternSet &patterns)
+          : _options (options), _searcher (searcher), _patterns (patterns), _pool (options.num_threads),
+            _buffers (_pool.num_threads ()), _bound (_pool.num_threads (), false),
+            _histograms (options.histogram ? _pool.num_threads () : 0, std::vector<size_t> (patterns.size (), 0))
+  {}
+
+  /**
+   * @brief Scan all paths and wait until done.
+   * @return the exit status
+   */
+  int run ()
+  {
+          for (const auto &path : _options.paths)
+                  {
+                          _pool.submit ([this, path] (size_t worker)
+                          {
+                            scan_path (path, worker, true);
+                          });
+                  }
+          _pool.wait ();
+          if (_options.histogram)
+                  {
+                          print_histogram ();
+                  }
+          if (_error)
+                  {
+                          return 2;
+                  }
+          return _matched ? 0 : 1;
+  }
+
+ private:
+  /**
+   * @brief Get the searcher of worker: the replica of the node the worker is assigned to round robin. On first use,
+   *  the worker is bound to this node.
+   */
+  const AhoCorasick<automaton::Dynamic> &searcher (size_t worker)
+  {
+          const auto &topology = _searcher.topology ();
+          size_t node = worker % topology.num_nodes ();
+          if (!_bound[worker] && topology.num_nodes () > 1)
+                  {
+                          topology.bind_thread (node);
+                          _bound[worker] = true;
+                  }
+          return _searcher.replica (node);
+  }
+
+  void report_error (const fs::path &path, const std::string &message)
+  {
+          _error = true;
+          std::string line = "ac: " + path.string () + ": " + message + "\n";
+          std::fwrite (line.data (), 1, line.size (), stderr);
+  }
+
+  void scan_path (const fs::path &path, size_t worker, bool follow_symlinks)
+  {
+          std::error_code error;
+          auto status = follow_symlinks ? fs::status (path, error) : fs::symlink_status (path, error);
+          if (error)
+                  {
+                          report_error (path, error.message ());
+                          return;
+                  }
+          if (fs::is_directory (status))
+                  {
+                          for (fs::directory_iterator it (path, error), end; !error && it != end; it.increment (error))
+                                  {
+                                          _pool.submit ([this, entry = it->path ()] (size_t w)
+                                          {
+                                            scan_path (entry, w, false);
+                                          });
+                                  }
+                          if (error)
+                                  {
+                                          report_error (path, error.message ());
+                                  }
+                          return;
+                  }
+          if (fs::is_regular_file (status))
+                  {
+                          scan_file (path, worker);
+                  }
+  }
+
+  void scan_file (const fs::path &path, size_t worker)
+  {
+          int fd = open (path.c_str (), O_RDONLY);
+          if (fd < 0)
+                  {
+                          report_error (path, std::strerror (errno));
+                          return;
+                  }
+          struct stat st{};
+          if (fstat (fd, &st) != 0)
+                  {
+                          report_error (path, std::strerror (errno));
+                          close (fd);
+                          return;
+                  }
+          if (_options.decompress && is_compressed (fd))
+                  {
+                          close (fd);
+                          scan_compressed (path, worker);
+                          return;
+                  }
+          auto size = static_cast<size_t>(st.st_size);
+          MappedFile mapped;
+          std::string_view content;
+          if (size >= _options.mmap_threshold && size > 0 && mapped.map (fd, size))
+                  {
+                          content = mapped.view ();
+                  }
+          else
+                  {
+                          // read into the buffer of this worker, which keeps its capacity from file to file
+                          auto &buffer = _buffers[worker];
+                          buffer.resize (size);
+                          size_t read_bytes = 0;
+                          while (read_bytes < size)
+                                  {
+                                          ssize_t n = read (fd, buffer.data () + read_bytes, size - read_bytes);
+                                          if (n < 0 && errno == EINTR)
+                                                  {
+                                                          continue;
+                                                  }
+                                          if (n < 0)
+                                                  {
+                                                          report_error (path, std::strerror (errno));
+                                                          close (fd);
+                                                          return;
+                                                  }
+                                          if (n == 0)
+                                                  {
+                                                          // the file was truncated meanwhile
+                                                          break;
+                                                  }
+                                          read_bytes += static_cast<size_t>(n);
+                                  }
+                          content = std::string_view (buffer.data (), read_bytes);
+                  }
+          close (fd);
+          scan_content (path, content, worker);
+  }
+
+  /**
+   * @brief Search a compressed file while it is decompressed by another thread (see DecompressingReader). Matches
+   *  are searched chunk by chunk. With -n or -w, which need the input around a match, the file is decompressed into
+   *  the read buffer of the worker first.
+   */
+  void scan_compressed (const fs::path &path, size_t worker)
+  {
+          try
+                  {
+                          DecompressingReader reader (path);
+                          if (_options.line_mode || _options.whole_words)
+                                  {
+                                          auto &buffer = _buffers[worker];
+                                          buffer.clear ();
+                                          while (auto chunk = reader.next ())
+                                                  {
+                                                          buffer.append (*chunk);
+                                                  }
+                                          scan_content (path, buffer, worker);
+                                          return;
+                                  }
+                          auto matches = searcher (worker).find_iter_chunks (reader.chunks ());
+                          if (_options.histogram)
+                                  {
+                                          for (const auto &match : matches)
+                                                  {
+                                                          ++_histograms[worker][match.pattern];
+                                                  }
+                                          return;
+                                  }
+                          print_matches (path, std::move (matches));
+                  }
+          catch (const std::exception &e)
+                  {
+                          report_error (path, e.what ());
+                  }
+  }
+
+  void scan_content (const fs::path &path, std::string_view content, size_t worker)
+  {
+          if (_options.histogram)
+                  {
+                          searcher (worker).count_matches (content, _histograms[worker]);
+                          return;
+                  }
+          search (path, content, worker);
+  }
+
+  /// Print the counts of all workers summed up, and set _matched if there are any
+  void print_histogram ()
+  {
+          std::vector<size_t> counts (_patterns.size (), 0);
+          for (const auto &histogram : _histograms)
+                  {
+                          for (size_t pattern = 0; pattern < counts.size (); ++pattern)
+                                  {
+                                          counts[pattern] += histogram[pattern];
+                                  }
+                  }
+          std::string output;
+          for (size_t pattern = 0; pattern < counts.size (); ++pattern)
+                  {
+                          if (counts[pattern] > 0)
+                                  {
+                                          _matched = true;
+                                          output.append (std::to_string (counts[pattern])).append (":");
+                                          output.append (_patterns[pattern]).append ("\n");
+                                  }
+                  }
+          std::fwrite (output.data (), 1, output.size (), stdout);
+  }
+
+  /// Search content and print the output of the file with a single write
+  void search (const fs::path &path, std::string_view content, size_t worker)
+  {
+          if (!_options.line_mode)
+                  {
+                          print_matches (path, searcher (worker).find_iter (content));
+                          return;
+                  }
+          std::string output;
+          size_t count = 0;
+          const std::string name = path.string ();
+          for (const auto &match : searcher (worker).find_lines (content, true))
+                  {
+                          ++count;
+                          if (_options.count_only)
+                                  {
+                                          continue;
+                                  }
+                          output.append (name).append (":").append (std::to_string (match.line_number));
+                          output.append (":").append (content.substr (match.line_start,
+                                                                      match.line_end - match.line_start));
+                          output.append ("\n");
+                  }
+          write_output (name, output, count);
+  }
+
+  /// Print matches of the file at path with a single write
+  void print_matches (const fs::path &path, Generator<Match> matches)
+  {
+          std::string output;
+          size_t count = 0;
+          const std::string name = path.string ();
+          for (const auto &match : matches)
+                  {
+                          ++count;
+                          if (_options.count_only)
+                                  {
+                                          continue;
+                                  }
+                          output.append (name).append (":").append (std::to_string (match.start));
+                          output.append (":").append (_patterns[match.pattern]).append ("\n");
+                  }
+          write_output (name, output, count);
+  }
+
+  /// Write the output of a file with count matches (or matching lines), and set _matched if there are any
+  void write_output (const std::string &name, std::string &output, size_t count)
+  {
+          if (count == 0)
+                  {
+                          return;
+                  }
+          _matched = true;
+          if (_options.count_only)
+                  {
+                          output.append (name).append (":").append (std::to_string (count)).append ("\n");
+                  }
+          std::fwrite (output.data (), 1, output.size (), stdout);
+  }
+
+  const Options &_options;
+  const ReplicatedSearcher<automaton::Dynamic> &_searcher;
+  const PatternSet &_patterns;
+  WorkStealingPool _pool;
+  /// read buffer of every worker
+  std::vector<std::string> _buffers;
+  /// whether a worker is bound to its node already, only accessed by the worker itself
+  std::vector<char> _bound;
+  /// match counts of every worker by pattern, only used with --histogram
+  std::vector<std::vector<size_t>> _histograms;
+  std::atomic<bool> _matched{false};
+  std::atomic<bool> _error{false};
+};
+
+}  // namespace
 
 int main (int argc, char **argv)
 {
-        std::vector<std::string> patterns {"tern", "er"};
-        AhoCorasick<automaton::NFA> searcher(std::move(patterns), MatchKind::LEFTMOST_FIRST);
-        auto res = searcher.find_all ("pattern!");
-        for (const auto& r : res)
+        Options options;
+        if (argc > 1 && (std::string_view (argv[1]) == "-h" || std::string_view (argv[1]) == "--help"))
+                {
+                        std::cout << USAGE;
+                        return 0;
+                }
+        if (!parse_args (argc, argv, options))
+                {
+                        std::cerr << USAGE;
+                        return 2;
+                }
+        try
+                {
+                        PatternSet patterns = read_patterns (options.pattern_file);
+                        // the engine is chosen automatically: AUTO never chooses a lazy DFA, which the threads of the
+                        //  scanner could not share (ReplicatedSearcher refuses it)
+                        auto builder = AhoCorasickBuilder ()
+                                .match_kind (options.match_kind)
+                                .ascii_case_insensitive (options.ignore_case)
+                                .whole_words (options.whole_words)
+                                .build_threads (options.num_threads);
+                        NumaTopology topology;
+                        if (!options.numa_topology.empty ())
+                                {
+                                        topology = NumaTopology::parse (options.numa_topology);
+                                }
+                        else if (options.numa)
+                                {
+                                        topology = NumaTopology::detect ();
+                                }
+                        ReplicatedSearcher<automaton::Dynamic> searcher (patterns, builder.config (), topology);
+                        Scanner scanner (options, searcher, patterns);
+                        return scanner.run ();
+                }
+        catch (const std::exception &e)
                 {
-                        std::cout << r << std::endl;
+                        std::cerr << "ac: " << e.what () << std::endl;
+                        return 2;
                 }
-        return 0;
-}
\ No newline at end of file
+}
@@ -6,6 +6,13 @@
  */
 
 #include <ac/ahocorasick.h>
+#include <ac/utils/lines.h>
+#include <ac/utils/parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string_view>
 
 std::ostream &operator<< (std::ostream &os, Result const &result)
 {
@@ -13,51 +20,806 @@ std::ostream &operator<< (std::ostream &os, Result const &result)
                   << std::to_string (result.end) << std::string ("]");
 }
 
-template<>
-AhoCorasick<automaton::NFA>::AhoCorasick (std::vector<std::string> patterns, MatchKind match_kind)
-        : _patterns (std::move (patterns)), _match_kind (match_kind), _automaton (_patterns, _match_kind, false)
-{}
+std::ostream &operator<< (std::ostream &os, AutomatonType type)
+{
+        switch (type)
+                {
+                        case AutomatonType::NFA:
+                                return os << "NFA";
+                        case AutomatonType::CONTIGUOUS_NFA:
+                                return os << "ContiguousNFA";
+                        case AutomatonType::LAZY_DFA:
+                                return os << "LazyDFA";
+                        case AutomatonType::AUTO:
+                                return os << "auto";
+                }
+        return os;
+}
+
+namespace {
+
+/// ID of the next searcher constructed, see AhoCorasick::id
+std::atomic<uint64_t> next_searcher_id{0};
 
-template<>
-std::vector<Result> AhoCorasick<automaton::NFA>::find_all (std::string input)
+/**
+ * @brief Generate the matches of patterns of groups within input, see detail::for_each_match.
+ */
+template<typename automaton_type>
+Generator<Match> generate_matches (const automaton_type &automaton, const Prefilter &prefilter,
+                                   const WordBoundary &words, MatchKind match_kind, std::string_view input,
+                                   GroupMask groups)
 {
-        std::vector<Result> results;
-        automaton::State *state = _automaton._start_state;
-        automaton::State *prev{nullptr};
-        for (size_t index = 0; index < input.size (); ++index)
-                {
-                        prev = state;
-                        state = state->next_state (input[index]);
-                        if (state == nullptr)
-                                {
-                                        // In this case, a failure transition is taken.
-                                        // We don't increase the index, since the same input char
-                                        // as before is considered again.
-                                        state = prev->failed;
-                                        --index;
-                                        continue;
+        if (match_kind == MatchKind::STANDARD)
+                {
+                        detail::StandardSearch search (automaton, prefilter, words, input, groups);
+                        while (search.next ())
+                                {
+                                        for (auto id : search.matches ())
+                                                {
+                                                        if (search.reports (id))
+                                                                {
+                                                                        co_yield search.match (id);
+                                                                }
+                                                }
+                                }
+                        co_return;
+                }
+        size_t at = 0;
+        while (auto match = detail::next_leftmost_match (automaton, prefilter, words, match_kind, input, at, groups))
+                {
+                        co_yield *match;
+                }
+}
+
+Generator<Match> generate_matches (const automaton::Dynamic &automaton, const Prefilter &prefilter,
+                                   const WordBoundary &words, MatchKind match_kind, std::string_view input,
+                                   GroupMask groups)
+{
+        return automaton.visit ([&] (const auto &engine)
+        {
+          return generate_matches (engine, prefilter, words, match_kind, input, groups);
+        });
+}
+
+/**
+ * @brief Generate the matches within input by line, see AhoCorasick::find_lines.
+ */
+template<typename automaton_type>
+Generator<LineMatch> generate_line_matches (const automaton_type &automaton, const Prefilter &prefilter,
+                                            const WordBoundary &words, MatchKind match_kind, std::string_view input,
+                                            bool first_match_per_line)
+{
+        LineLocator lines (input);
+        auto line_match = [&lines] (const Match &match)
+        {
+          lines.locate (match.start);
+          return LineMatch{match.pattern, lines.line_number (), lines.line_start (), lines.line_end ()};
+        };
+        if (match_kind == MatchKind::STANDARD)
+                {
+                        detail::StandardSearch search (automaton, prefilter, words, input, ALL_GROUPS);
+                        // matches starting before are not reported: their line was reported already
+                        size_t skip_until = 0;
+                        while (search.next ())
+                                {
+                                        for (auto id : search.matches ())
+                                                {
+                                                        Match match = search.match (id);
+                                                        if (match.start < skip_until || !search.reports (id))
+                                                                {
+                                                                        continue;
+                                                                }
+                                                        co_yield line_match (match);
+                                                        if (first_match_per_line)
+                                                                {
+                                                                        skip_until = lines.line_end () + 1;
+                                                                        break;
+                                                                }
+                                                }
+                                        if (skip_until > search.end ())
+                                                {
+                                                        // continue at the start of the next line
+                                                        search.restart (skip_until);
+                                                }
                                 }
-                        else if (state == _automaton._dead_state)
+                        co_return;
+                }
+        size_t at = 0;
+        while (auto match = detail::next_leftmost_match (automaton, prefilter, words, match_kind, input, at))
+                {
+                        co_yield line_match (*match);
+                        if (first_match_per_line)
                                 {
-                                        break;
+                                        at = std::max (at, lines.line_end () + 1);
                                 }
-                        else if (state->is_match ())
+                }
+}
+
+Generator<LineMatch> generate_line_matches (const automaton::Dynamic &automaton, const Prefilter &prefilter,
+                                            const WordBoundary &words, MatchKind match_kind, std::string_view input,
+                                            bool first_match_per_line)
+{
+        return automaton.visit ([&] (const auto &engine)
+        {
+          return generate_line_matches (engine, prefilter, words, match_kind, input, first_match_per_line);
+        });
+}
+
+/**
+ * @brief Generate the matches of patterns of groups within the concatenation of chunks, see
+ *  AhoCorasick::find_iter_async.
+ */
+template<typename automaton_type>
+AsyncGenerator<Match> generate_matches_async (const automaton_type &automaton, const Prefilter &prefilter,
+                                              MatchKind match_kind, size_t max_pattern_len,
+                                              AsyncGenerator<std::string_view> chunks, GroupMask groups)
+{
+        const WordBoundary words;
+        if (match_kind == MatchKind::STANDARD)
+                {
+                        // all matches ending at a position are known as soon as it is read: only the state is carried
+                        //  over from one chunk to the next
+                        detail::StandardSearch search (automaton, prefilter, words, std::string_view (), groups);
+                        size_t offset = 0;
+                        while (search.next ())
                                 {
-                                        if (_match_kind == MatchKind::STANDARD)
+                                        // the matches of the start state
+                                        for (auto id : search.matches ())
                                                 {
-                                                        for (auto *match : state->matches)
+                                                        if (search.reports (id))
                                                                 {
-                                                                        results.push_back({*match, index
-                                                                                                      - match->size (), index});
+                                                                        co_yield search.match (id);
                                                                 }
                                                 }
-                                        else
+                                }
+                        while (auto chunk = co_await chunks.next ())
+                                {
+                                        search.resume (*chunk);
+                                        while (search.next ())
+                                                {
+                                                        for (auto id : search.matches ())
+                                                                {
+                                                                        if (!search.reports (id))
+                                                                                {
+                                                                                        continue;
+                                                                                }
+                                                                        Match match = search.match (id);
+                                                                        co_yield Match{id, offset + match.start,
+                                                                                       offset + match.end};
+                                                                }
+                                                }
+                                        offset += chunk->size ();
+                                }
+                        co_return;
+                }
+        // A leftmost match is final only once the dead state is reached, which may happen in a later chunk. The input
+        //  from the position the current search started at is kept in window, so that the search can be repeated
+        //  with the next chunk appended.
+        std::string window;
+        // offset of window[0] within the whole input
+        size_t window_offset = 0;
+        size_t at = 0;
+        bool last_chunk = false;
+        while (!last_chunk)
+                {
+                        auto chunk = co_await chunks.next ();
+                        if (chunk)
+                                {
+                                        window.append (*chunk);
+                                }
+                        last_chunk = !chunk;
+                        PatternID pattern;
+                        size_t end;
+                        bool exhausted;
+                        while (at <= window.size ())
+                                {
+                                        bool found = detail::find_leftmost (automaton, prefilter, words, window, at,
+                                                                            pattern, end, exhausted, groups);
+                                        if (exhausted && !last_chunk)
+                                                {
+                                                        if (!found && max_pattern_len > 0)
+                                                                {
+                                                                        // a match starting before can neither end in
+                                                                        //  window nor be extended by the next chunk
+                                                                        at = std::max (at, (window.size () + 1)
+                                                                                           - std::min (window.size () + 1,
+                                                                                                       max_pattern_len));
+                                                                }
+                                                        break;
+                                                }
+                                        if (!found)
+                                                {
+                                                        at = window.size () + 1;
+                                                        break;
+                                                }
+                                        size_t start = end - automaton.pattern_len (pattern);
+                                        if (detail::in_groups (automaton, pattern, groups))
+                                                {
+                                                        co_yield Match{pattern, window_offset + start, window_offset + end};
+                                                }
+                                        at = end == start ? end + 1 : end;
+                                }
+                        size_t drop = std::min (at, window.size ());
+                        window.erase (0, drop);
+                        window_offset += drop;
+                        at -= drop;
+                }
+}
+
+AsyncGenerator<Match> generate_matches_async (const automaton::Dynamic &automaton, const Prefilter &prefilter,
+                                              MatchKind match_kind, size_t max_pattern_len,
+                                              AsyncGenerator<std::string_view> chunks, GroupMask groups)
+{
+        return automaton.visit ([&] (const auto &engine)
+        {
+          return generate_matches_async (engine, prefilter, match_kind, max_pattern_len, std::move (chunks), groups);
+        });
+}
+
+/**
+ * @brief Pass on chunks that are produced synchronously to an asynchronous consumer.
+ */
+AsyncGenerator<std::string_view> to_async (Generator<std::string_view> chunks)
+{
+        for (auto chunk : chunks)
+                {
+                        co_yield chunk;
+                }
+}
+
+/**
+ * @brief Pass on the matches of an asynchronous search to a synchronous consumer. Nothing but the chunks is awaited,
+ *  so the search runs on the thread advancing the generator.
+ */
+Generator<Match> await_matches (AsyncGenerator<Match> matches)
+{
+        while (auto match = co_await matches.next ())
+                {
+                        co_yield *match;
+                }
+}
+
+/**
+ * @brief Call callback (match) for the matches ending within the segment (begin, end] of input, or [0, end] if begin
+ *  is 0, see AhoCorasick::count_segment_matches. Only for MatchKind::STANDARD.
+ */
+template<typename automaton_type, typename Callback>
+void for_each_segment_match (const automaton_type &automaton, const Prefilter &prefilter, const WordBoundary &words,
+                             const LongPatterns &long_patterns, const PatternSet &patterns, size_t max_pattern_len,
+                             std::string_view input, size_t begin, size_t end, Callback &&callback, GroupMask groups)
+{
+        // a match ending in the segment may start up to max_pattern_len - 1 bytes before it
+        const size_t overlap = max_pattern_len > 0 ? max_pattern_len - 1 : 0;
+        // the segment with the matches ending within it and the bytes around them that whole words are checked on
+        const size_t window_begin = begin - std::min (begin, overlap + 1);
+        const size_t window_end = std::min (end + 1, input.size ());
+        // a match ending at begin belongs to the segment before, only the first one has the empty matches at 0
+        const size_t min_end = begin == 0 ? 0 : begin + 1;
+        auto in_segment = [&callback, window_begin, min_end, end] (const Match &match)
+        {
+          Match shifted{match.pattern, window_begin + match.start, window_begin + match.end};
+          if (shifted.end >= min_end && shifted.end <= end)
+            {
+              callback (shifted);
+            }
+        };
+        const std::string_view window = input.substr (window_begin, window_end - window_begin);
+        auto search = [&] (auto &segment_callback)
+        {
+          detail::for_each_match (automaton, prefilter, words, MatchKind::STANDARD, window, segment_callback, groups);
+        };
+        if (long_patterns.empty ())
+                {
+                        search (in_segment);
+                }
+        else
+                {
+                        // a long match ending in the segment starts within the window, it is at most max_pattern_len
+                        //  bytes long
+                        detail::confirm_long_matches (long_patterns, patterns, window, in_segment, search);
+                }
+}
+
+/**
+ * @brief Continue the search of input at offset until budget is used up, see AhoCorasick::find_budgeted. offset is
+ *  advanced and done is set once input is searched completely.
+ */
+template<typename automaton_type>
+void search_budgeted (const automaton_type &automaton, const Prefilter &prefilter, const WordBoundary &words,
+                      const LongPatterns &long_patterns, const PatternSet &patterns, MatchKind match_kind,
+                      size_t max_pattern_len, std::string_view input, const SearchBudget &budget, size_t &offset,
+                      bool &done, std::pmr::vector<Match> &matches, GroupMask groups)
+{
+        // A step searches up to limit. For the leftmost match kinds, it has to reach past the longest match that can
+        //  start at offset, otherwise the match could always be extended by the bytes following the step.
+        const size_t min_step = match_kind == MatchKind::STANDARD ? 1 : max_pattern_len + 1;
+        size_t searched = 0;
+        for (bool first = true; !done; first = false)
+                {
+                        if (!first && (searched >= budget.max_bytes
+                                       || std::chrono::steady_clock::now () >= budget.deadline))
+                                {
+                                        return;
+                                }
+                        if (offset > input.size ())
+                                {
+                                        // after an empty match at the end
+                                        done = true;
+                                        return;
+                                }
+                        size_t step = std::min (budget.max_bytes - std::min (budget.max_bytes, searched),
+                                                SearchBudget::CHECK_INTERVAL);
+                        step = std::max (step, min_step);
+                        const size_t limit = step < input.size () - offset ? offset + step : input.size ();
+                        const bool last = limit == input.size ();
+                        searched += limit - offset;
+                        if (match_kind == MatchKind::STANDARD)
+                                {
+                                        for_each_segment_match (automaton, prefilter, words, long_patterns, patterns,
+                                                                max_pattern_len, input, offset, limit,
+                                                                [&matches] (const Match &match)
+                                        {
+                                          matches.push_back (match);
+                                        }, groups);
+                                        offset = limit;
+                                        done = last;
+                                        continue;
+                                }
+                        // The window ends at limit. A match is final if the search reached the dead state before limit
+                        //  and it starts early enough for the whole-word checks not to see the end of the window.
+                        const std::string_view window = input.substr (0, limit);
+                        PatternID pattern;
+                        size_t end;
+                        bool exhausted;
+                        bool found;
+                        while ((found = offset <= limit
+                                        && detail::find_leftmost_word (automaton, prefilter, words, match_kind, window,
+                                                                       offset, pattern, end, exhausted, groups)))
+                                {
+                                        size_t start = end - automaton.pattern_len (pattern);
+                                        if (!last && (exhausted || start + max_pattern_len >= limit))
+                                                {
+                                                        break;
+                                                }
+                                        if (detail::in_groups (automaton, pattern, groups))
                                                 {
-                                                        std::string match = **(state->matches.begin ());
-                                                        size_t size = match.size ();
-                                                        results.push_back({std::move (match), index - size, index});
+                                                        matches.push_back (Match{pattern, start, end});
                                                 }
+                                        // an empty match would otherwise be found over and over again
+                                        offset = end == start ? end + 1 : end;
+                                }
+                        if (last)
+                                {
+                                        // every match of the last step is final
+                                        done = true;
+                                        continue;
+                                }
+                        // Matches starting before the last max_pattern_len bytes of the window end within it and were
+                        //  found, those starting later (or at the match that may still change) are searched again.
+                        size_t resume = limit + 1 - std::min (limit + 1, max_pattern_len);
+                        if (found)
+                                {
+                                        resume = std::min (resume, end - automaton.pattern_len (pattern));
                                 }
+                        offset = std::max (offset, resume);
+                }
+}
+
+template<typename Callback>
+void for_each_segment_match (const automaton::Dynamic &automaton, const Prefilter &prefilter,
+                             const WordBoundary &words, const LongPatterns &long_patterns, const PatternSet &patterns,
+                             size_t max_pattern_len, std::string_view input, size_t begin, size_t end,
+                             Callback &&callback, GroupMask groups)
+{
+        automaton.visit ([&] (const auto &engine)
+        {
+          for_each_segment_match (engine, prefilter, words, long_patterns, patterns, max_pattern_len, input, begin,
+                                  end, callback, groups);
+        });
+}
+
+void search_budgeted (const automaton::Dynamic &automaton, const Prefilter &prefilter, const WordBoundary &words,
+                      const LongPatterns &long_patterns, const PatternSet &patterns, MatchKind match_kind,
+                      size_t max_pattern_len, std::string_view input, const SearchBudget &budget, size_t &offset,
+                      bool &done, std::pmr::vector<Match> &matches, GroupMask groups)
+{
+        automaton.visit ([&] (const auto &engine)
+        {
+          search_budgeted (engine, prefilter, words, long_patterns, patterns, match_kind, max_pattern_len, input,
+                           budget, offset, done, matches, groups);
+        });
+}
+
+/**
+ * @brief Turn the matches of an automaton built from long_patterns.anchors (patterns) into the matches of patterns,
+ *  see detail::confirm_long_matches.
+ */
+Generator<Match> generate_confirmed_matches (Generator<Match> matches, const LongPatterns &long_patterns,
+                                             const PatternSet &patterns, std::string_view input)
+{
+        LongMatchQueue queue (long_patterns, patterns, input);
+        for (const auto &match : matches)
+                {
+                        if (!queue.push (match))
+                                {
+                                        continue;
+                                }
+                        while (auto confirmed = queue.pop (match.end))
+                                {
+                                        co_yield *confirmed;
+                                }
+                        co_yield match;
+                }
+        while (auto confirmed = queue.pop ())
+                {
+                        co_yield *confirmed;
+                }
+}
+
+/**
+ * @brief Build the automaton of a searcher: from the anchors of the long patterns if there are any.
+ */
+template<typename automaton_type>
+automaton_type build_automaton (const PatternSet &patterns, const LongPatterns &long_patterns,
+                                const BuildConfig &config)
+{
+        if (long_patterns.empty ())
+                {
+                        return automaton_type (patterns, config);
                 }
+        return automaton_type (long_patterns.anchors (patterns), config);
+}
+
+/**
+ * @brief Get the threshold of long patterns for config, 0 if the search cannot confirm their anchors: leftmost
+ *  searches would have to prefer their matches over overlapping ones before they are confirmed, whole-word checks
+ *  would apply to the end of the anchor.
+ */
+size_t long_pattern_threshold (const BuildConfig &config)
+{
+        return config.match_kind == MatchKind::STANDARD && !config.whole_words ? config.long_pattern_threshold : 0;
+}
+
+}  // namespace
+
+template<typename automaton_type>
+AhoCorasick<automaton_type>::AhoCorasick (const PatternSet &patterns, MatchKind match_kind)
+        : AhoCorasick (patterns, BuildConfig{match_kind})
+{}
+
+template<typename automaton_type>
+AhoCorasick<automaton_type>::AhoCorasick (PatternSet patterns, const BuildConfig &config)
+        : _id (next_searcher_id.fetch_add (1, std::memory_order_relaxed)), _patterns (std::move (patterns)),
+          _match_kind (config.match_kind),
+          _long_patterns (_patterns, long_pattern_threshold (config), config.ascii_case_insensitive),
+          _automaton (build_automaton<automaton_type> (_patterns, _long_patterns, config))
+{
+        for (auto pattern : _patterns)
+                {
+                        _max_pattern_len = std::max (_max_pattern_len, pattern.size ());
+                }
+        if (config.prefilter)
+                {
+                        _prefilter = Prefilter (_patterns, config.ascii_case_insensitive);
+                }
+        if (config.whole_words)
+                {
+                        _words = WordBoundary (config.word_chars);
+                }
+}
+
+template<typename automaton_type>
+const automaton_type &AhoCorasick<automaton_type>::automaton () const
+{
+        return _automaton;
+}
+
+template<typename automaton_type>
+uint64_t AhoCorasick<automaton_type>::id () const
+{
+        return _id;
+}
+
+template<typename automaton_type>
+std::vector<Result> AhoCorasick<automaton_type>::find_all (std::string input)
+{
+        std::vector<Result> results;
+        for_each_match (input, [this, &results] (const Match &match)
+        {
+          results.push_back ({std::string (_patterns[match.pattern]), match.start, match.end});
+        });
         return results;
-}
\ No newline at end of file
+}
+
+template<typename automaton_type>
+std::pmr::vector<Match> AhoCorasick<automaton_type>::find_matches (std::string_view input,
+                                                                  std::pmr::memory_resource *resource) const
+{
+        std::pmr::vector<Match> matches (resource);
+        for_each_match (input, [&matches] (const Match &match)
+        {
+          matches.push_back (match);
+        });
+        return matches;
+}
+
+template<typename automaton_type>
+std::vector<Match> AhoCorasick<automaton_type>::find_cached (std::string_view input, ResultCache &cache,
+                                                            GroupMask groups) const
+{
+        if (auto cached = cache.lookup (_id, groups, input))
+                {
+                        return std::move (*cached);
+                }
+        std::vector<Match> matches;
+        for_each_match (input, [&matches] (const Match &match)
+        {
+          matches.push_back (match);
+        }, groups);
+        cache.insert (_id, groups, input, matches);
+        return matches;
+}
+
+template<typename automaton_type>
+void AhoCorasick<automaton_type>::count_matches (std::string_view input, std::span<size_t> counts,
+                                                GroupMask groups) const
+{
+        if (counts.size () < _patterns.size ())
+                {
+                        throw std::invalid_argument ("count_matches: fewer counters than patterns");
+                }
+        for_each_match (input, [counts] (const Match &match)
+        {
+          ++counts[match.pattern];
+        }, groups);
+}
+
+template<typename automaton_type>
+void AhoCorasick<automaton_type>::count_segment_matches (std::string_view input, size_t begin, size_t end,
+                                                        std::span<size_t> counts, GroupMask groups) const
+{
+        if (_match_kind != MatchKind::STANDARD)
+                {
+                        throw std::invalid_argument ("count_segment_matches: requires MatchKind::STANDARD");
+                }
+        if (!detail::is_thread_safe (_automaton))
+                {
+                        throw std::invalid_argument ("count_segment_matches: a lazy DFA must not be searched by threads");
+                }
+        if (counts.size () < _patterns.size ())
+                {
+                        throw std::invalid_argument ("count_segment_matches: fewer counters than patterns");
+                }
+        for_each_segment_match (_automaton, _prefilter, _words, _long_patterns, _patterns, _max_pattern_len, input,
+                                begin, end, [counts] (const Match &match)
+        {
+          ++counts[match.pattern];
+        }, groups);
+}
+
+template<typename automaton_type>
+std::pmr::vector<Match> AhoCorasick<automaton_type>::find_budgeted (std::string_view input, SearchCursor &cursor,
+                                                                    const SearchBudget &budget, GroupMask groups,
+                                                                    std::pmr::memory_resource *resource) const
+{
+        std::pmr::vector<Match> matches (resource);
+        search_budgeted (_automaton, _prefilter, _words, _long_patterns, _patterns, _match_kind, _max_pattern_len,
+                         input, budget, cursor._offset, cursor._done, matches, groups);
+        return matches;
+}
+
+template<typename automaton_type>
+std::vector<size_t> AhoCorasick<automaton_type>::match_histogram (std::string_view input, size_t num_threads,
+                                                                  GroupMask groups) const
+{
+        std::vector<size_t> counts (_patterns.size (), 0);
+        num_threads = resolve_num_threads (num_threads);
+        const size_t num_segments = std::min (num_threads, input.size () / MIN_PARALLEL_SEGMENT_LEN);
+        if (_match_kind != MatchKind::STANDARD || num_segments <= 1 || !detail::is_thread_safe (_automaton))
+                {
+                        count_matches (input, counts, groups);
+                        return counts;
+                }
+        const size_t segment_len = (input.size () + num_segments - 1) / num_segments;
+        std::vector<std::vector<size_t>> thread_counts (std::min (num_threads, num_segments), counts);
+        parallel_for (num_threads, num_segments, [&] (size_t segment, size_t thread)
+        {
+          const size_t begin = segment * segment_len;
+          count_segment_matches (input, begin, std::min (begin + segment_len, input.size ()), thread_counts[thread],
+                                 groups);
+        });
+        for (const auto &histogram : thread_counts)
+                {
+                        for (size_t pattern = 0; pattern < counts.size (); ++pattern)
+                                {
+                                        counts[pattern] += histogram[pattern];
+                                }
+                }
+        return counts;
+}
+
+template<typename automaton_type>
+Generator<Match> AhoCorasick<automaton_type>::find_iter (std::string_view input, GroupMask groups) const
+{
+        if (!_long_patterns.empty ())
+                {
+                        return generate_confirmed_matches (
+                                generate_matches (_automaton, _prefilter, _words, _match_kind, input, groups),
+                                _long_patterns, _patterns, input);
+                }
+        return generate_matches (_automaton, _prefilter, _words, _match_kind, input, groups);
+}
+
+template<typename automaton_type>
+Generator<LineMatch> AhoCorasick<automaton_type>::find_lines (std::string_view input,
+                                                              bool first_match_per_line) const
+{
+        if (!_long_patterns.empty ())
+                {
+                        throw std::invalid_argument ("find_lines does not support long patterns");
+                }
+        return generate_line_matches (_automaton, _prefilter, _words, _match_kind, input, first_match_per_line);
+}
+
+template<typename automaton_type>
+std::optional<Match> AhoCorasick<automaton_type>::find_anchored (std::string_view input) const
+{
+        if (!_long_patterns.empty ())
+                {
+                        throw std::invalid_argument ("find_anchored does not support long patterns");
+                }
+        bool exhausted;
+        auto preferred = _match_kind == MatchKind::STANDARD ? detail::AnchoredMatch::SHORTEST
+                         : _match_kind == MatchKind::LEFTMOST_FIRST ? detail::AnchoredMatch::FIRST
+                         : detail::AnchoredMatch::LONGEST;
+        return detail::find_anchored (_automaton, _words, input, 0, preferred, exhausted);
+}
+
+template<typename automaton_type>
+std::optional<Match> AhoCorasick<automaton_type>::longest_prefix (std::string_view input) const
+{
+        if (!_long_patterns.empty ())
+                {
+                        throw std::invalid_argument ("longest_prefix does not support long patterns");
+                }
+        bool exhausted;
+        return detail::find_anchored (_automaton, _words, input, 0, detail::AnchoredMatch::LONGEST, exhausted);
+}
+
+template<typename automaton_type>
+AsyncGenerator<Match> AhoCorasick<automaton_type>::find_iter_async (AsyncGenerator<std::string_view> chunks,
+                                                                    GroupMask groups) const
+{
+        if (_words.enabled ())
+                {
+                        throw std::invalid_argument ("find_iter_async does not support whole-word matching");
+                }
+        if (!_long_patterns.empty ())
+                {
+                        throw std::invalid_argument ("find_iter_async does not support long patterns");
+                }
+        return generate_matches_async (_automaton, _prefilter, _match_kind, _max_pattern_len, std::move (chunks),
+                                       groups);
+}
+
+template<typename automaton_type>
+Generator<Match> AhoCorasick<automaton_type>::find_iter_chunks (Generator<std::string_view> chunks,
+                                                               GroupMask groups) const
+{
+        return await_matches (find_iter_async (to_async (std::move (chunks)), groups));
+}
+
+template class AhoCorasick<automaton::NFA>;
+template class AhoCorasick<automaton::ContiguousNFA>;
+template class AhoCorasick<automaton::LazyDFA<automaton::NFA>>;
+template class AhoCorasick<automaton::LazyDFA<automaton::ContiguousNFA>>;
+template class AhoCorasick<automaton::Dynamic>;
+
+// ===== AhoCorasickBuilder ============================================================================================
+
+AhoCorasickBuilder &AhoCorasickBuilder::match_kind (MatchKind match_kind)
+{
+        _config.match_kind = match_kind;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::ascii_case_insensitive (bool yes)
+{
+        _config.ascii_case_insensitive = yes;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::automaton_type (AutomatonType type)
+{
+        _config.automaton_type = type;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::memory_budget (size_t bytes)
+{
+        _config.memory_budget = bytes;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::prefilter (bool yes)
+{
+        _config.prefilter = yes;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::byte_classes (bool yes)
+{
+        _config.byte_classes = yes;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::dfa_state_limit (size_t states)
+{
+        _config.dfa_state_limit = states;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::memory_limit (size_t bytes)
+{
+        _config.memory_limit = bytes;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::build_threads (size_t num_threads)
+{
+        _config.build_threads = num_threads;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::dfa_cache_size (size_t bytes)
+{
+        _config.dfa_cache_size = bytes;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::dfa_pair_classes (size_t classes)
+{
+        _config.dfa_pair_classes = classes;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::whole_words (bool yes)
+{
+        _config.whole_words = yes;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::word_chars (std::string chars)
+{
+        _config.word_chars = std::move (chars);
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::memory_resource (std::pmr::memory_resource *resource)
+{
+        _config.memory_resource = resource;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::huge_pages (bool yes)
+{
+        _config.huge_pages = yes;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::state_layout (const StateLayout *layout)
+{
+        _config.state_layout = layout;
+        return *this;
+}
+
+AhoCorasickBuilder &AhoCorasickBuilder::long_pattern_threshold (size_t bytes)
+{
+        _config.long_pattern_threshold = bytes;
+        return *this;
+}
+
+const BuildConfig &AhoCorasickBuilder::config () const
+{
+        return _config;
+}
@@ -0,0 +1,231 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/dfa/lazy_dfa.h>
+#include <ac/utils/memory.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace automaton {
+
+template<typename nfa_type>
+LazyDFA<nfa_type>::LazyDFA (const PatternSet &patterns, MatchKind match_kind, bool ascii_i_case)
+        : LazyDFA (patterns, BuildConfig{match_kind, ascii_i_case})
+{}
+
+template<typename nfa_type>
+LazyDFA<nfa_type>::LazyDFA (const PatternSet &patterns, const BuildConfig &config)
+        : _nfa (patterns, config), _table (table_resource (config)), _pair_table (table_resource (config)),
+          _nfa_states (memory_resource (config)),
+          _is_match (memory_resource (config)), _dfa_states (memory_resource (config))
+{
+        if (config.dfa_state_limit < MIN_STATES)
+                {
+                        throw std::length_error ("LazyDFA: state limit of " + std::to_string (config.dfa_state_limit)
+                                                 + " is below the " + std::to_string (MIN_STATES)
+                                                 + " states a search needs");
+                }
+        if (config.byte_classes)
+                {
+                        CharSet char_set (config.ascii_case_insensitive);
+                        for (auto pattern : patterns)
+                                {
+                                        for (const char &c : pattern)
+                                                {
+                                                        char_set.add_char (c);
+                                                }
+                                }
+                        _stride = char_set.size ();
+                        for (int c = 255; c >= 0; --c)
+                                {
+                                        _classes[c] = char_set.get_code_point (c);
+                                        _representatives[_classes[c]] = c;
+                                }
+                }
+        else
+                {
+                        _stride = 256;
+                        for (int c = 0; c < 256; ++c)
+                                {
+                                        _classes[c] = c;
+                                        _representatives[c] = c;
+                                }
+                }
+        size_t state_size = _stride * sizeof (state_type) + sizeof (typename nfa_type::state_type)
+                            // node of _dfa_states
+                            + 4 * sizeof (void *);
+        size_t pair_state_size = state_size + _stride * _stride * sizeof (state_type);
+        // a DFA state stands for an NFA state, so pair transitions never make the cache overflow if it can hold all NFA
+        //  states with them. Otherwise the smaller capacity costs more than the pairs save.
+        if (config.byte_classes && _stride <= config.dfa_pair_classes
+            && std::min (config.dfa_cache_size / pair_state_size, config.dfa_state_limit) >= _nfa.num_states ())
+                {
+                        _pair_stride = _stride * _stride;
+                        state_size = pair_state_size;
+                }
+        _capacity = std::max (MIN_STATES, std::min (config.dfa_cache_size / state_size, config.dfa_state_limit));
+        _table.reserve (_capacity * _stride);
+        _pair_table.reserve (_capacity * _pair_stride);
+        _nfa_states.reserve (_capacity);
+        _is_match.reserve (_capacity);
+        _dfa_states.reserve (_capacity);
+        clear_cache ();
+}
+
+template<typename nfa_type>
+typename LazyDFA<nfa_type>::state_type LazyDFA<nfa_type>::start_state () const
+{
+        return START;
+}
+
+template<typename nfa_type>
+typename LazyDFA<nfa_type>::state_type LazyDFA<nfa_type>::compute_next_state (state_type state,
+                                                                              unsigned char c) const
+{
+        auto nfa_next = _nfa.next_state (_nfa_states[state], _representatives[_classes[c]]);
+        size_t num_cache_clears = _num_cache_clears;
+        state_type next = add_state (nfa_next);
+        if (num_cache_clears == _num_cache_clears)
+                {
+                        // state was dropped if the cache was cleared
+                        _table[state * _stride + _classes[c]] = next;
+                }
+        return next;
+}
+
+template<typename nfa_type>
+size_t LazyDFA<nfa_type>::compute_next_state_pair (state_type &state, unsigned char a, unsigned char b) const
+{
+        size_t index = state * _pair_stride + _classes[a] * _stride + _classes[b];
+        size_t num_cache_clears = _num_cache_clears;
+        state_type mid = next_state (state, a);
+        size_t num_read = 1;
+        state = mid;
+        if (!_is_match[mid])
+                {
+                        state = next_state (mid, b);
+                        num_read = 2;
+                }
+        if (num_cache_clears == _num_cache_clears)
+                {
+                        // the pair transition was dropped if the cache was cleared
+                        _pair_table[index] = num_read == 2 ? state : SPLIT;
+                }
+        return num_read;
+}
+
+template<typename nfa_type>
+std::span<const PatternID> LazyDFA<nfa_type>::matches (state_type state) const
+{
+        return _nfa.matches (_nfa_states[state]);
+}
+
+template<typename nfa_type>
+size_t LazyDFA<nfa_type>::pattern_len (PatternID pattern) const
+{
+        return _nfa.pattern_len (pattern);
+}
+
+template<typename nfa_type>
+GroupID LazyDFA<nfa_type>::pattern_group (PatternID pattern) const
+{
+        return _nfa.pattern_group (pattern);
+}
+
+template<typename nfa_type>
+GroupMask LazyDFA<nfa_type>::match_groups (state_type state) const
+{
+        return _nfa.match_groups (_nfa_states[state]);
+}
+
+template<typename nfa_type>
+GroupMask LazyDFA<nfa_type>::reachable_groups (state_type state) const
+{
+        return _nfa.reachable_groups (_nfa_states[state]);
+}
+
+template<typename nfa_type>
+typename LazyDFA<nfa_type>::state_type LazyDFA<nfa_type>::prune (state_type state, GroupMask groups) const
+{
+        auto nfa_state = _nfa_states[state];
+        auto pruned = _nfa.prune (nfa_state, groups);
+        return pruned == nfa_state ? state : add_state (pruned);
+}
+
+template<typename nfa_type>
+const nfa_type &LazyDFA<nfa_type>::nfa () const
+{
+        return _nfa;
+}
+
+template<typename nfa_type>
+size_t LazyDFA<nfa_type>::num_cached_states () const
+{
+        return _nfa_states.size ();
+}
+
+template<typename nfa_type>
+size_t LazyDFA<nfa_type>::num_cache_clears () const
+{
+        return _num_cache_clears;
+}
+
+template<typename nfa_type>
+typename LazyDFA<nfa_type>::state_type LazyDFA<nfa_type>::add_state (typename nfa_type::state_type nfa_state) const
+{
+        auto it = _dfa_states.find (nfa_state);
+        if (it != _dfa_states.end ())
+                {
+                        return it->second;
+                }
+        if (_nfa_states.size () == _capacity)
+                {
+                        clear_cache ();
+                        ++_num_cache_clears;
+                        // the start or the dead state are still there
+                        it = _dfa_states.find (nfa_state);
+                        if (it != _dfa_states.end ())
+                                {
+                                        return it->second;
+                                }
+                }
+        auto state = static_cast<state_type>(_nfa_states.size ());
+        _table.resize (_table.size () + _stride, UNKNOWN);
+        _pair_table.resize (_pair_table.size () + _pair_stride, UNKNOWN);
+        _nfa_states.push_back (nfa_state);
+        _is_match.push_back (_nfa.is_match (nfa_state));
+        _dfa_states.emplace (nfa_state, state);
+        return state;
+}
+
+template<typename nfa_type>
+void LazyDFA<nfa_type>::clear_cache () const
+{
+        _table.clear ();
+        _pair_table.clear ();
+        _nfa_states.clear ();
+        _is_match.clear ();
+        _dfa_states.clear ();
+        // the dead state only leads to itself
+        _table.resize (_stride, DEAD);
+        _pair_table.resize (_pair_stride, DEAD);
+        _nfa_states.push_back (_nfa.dead_state ());
+        _is_match.push_back (false);
+        _dfa_states.emplace (_nfa.dead_state (), DEAD);
+        _table.resize (2 * _stride, UNKNOWN);
+        _pair_table.resize (2 * _pair_stride, UNKNOWN);
+        _nfa_states.push_back (_nfa.start_state ());
+        _is_match.push_back (_nfa.is_match (_nfa.start_state ()));
+        _dfa_states.emplace (_nfa.start_state (), START);
+}
+
+template class LazyDFA<NFA>;
+template class LazyDFA<ContiguousNFA>;
+
+}  // namespace automaton
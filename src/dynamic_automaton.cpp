@@ -0,0 +1,180 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ * 
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/dynamic_automaton.h>
+#include <ac/utils/charset.h>
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace automaton {
+
+namespace {
+
+unsigned char fold (char c, bool ascii_i_case)
+{
+        auto u = static_cast<unsigned char>(c);
+        return ascii_i_case ? static_cast<unsigned char>(std::tolower (u)) : u;
+}
+
+AutomatonType resolve_type (const PatternSet &patterns, const BuildConfig &config)
+{
+        bool limited = config.memory_limit != std::numeric_limits<size_t>::max ();
+        if (config.automaton_type != AutomatonType::AUTO && !limited)
+                {
+                        return config.automaton_type;
+                }
+        auto stats = analyze_patterns (patterns, config.ascii_case_insensitive);
+        AutomatonType type = config.automaton_type == AutomatonType::AUTO ? select_automaton_type (stats, config)
+                                                                          : config.automaton_type;
+        size_t estimated_size = estimate_size (type, stats, config.byte_classes);
+        if (type == AutomatonType::LAZY_DFA)
+                {
+                        estimated_size += config.dfa_cache_size;
+                }
+        if (estimated_size > config.memory_limit)
+                {
+                        std::ostringstream message;
+                        message << "Dynamic: estimated size of " << estimated_size << " bytes for " << stats.num_patterns
+                                << " patterns (" << stats.trie_size << " states) exceeds the memory limit of "
+                                << config.memory_limit << " bytes";
+                        throw std::length_error (message.str ());
+                }
+        return type;
+}
+
+Dynamic::variant_type build (AutomatonType type, const PatternSet &patterns, const BuildConfig &config)
+{
+        switch (type)
+                {
+                        case AutomatonType::NFA:
+                                return Dynamic::variant_type (std::in_place_type<NFA>, patterns, config);
+                        case AutomatonType::CONTIGUOUS_NFA:
+                                return Dynamic::variant_type (std::in_place_type<ContiguousNFA>, patterns, config);
+                        case AutomatonType::LAZY_DFA:
+                                return Dynamic::variant_type (std::in_place_type<LazyDFA<ContiguousNFA>>, patterns,
+                                                              config);
+                        default:
+                                throw std::invalid_argument ("Dynamic: no engine available for this automaton type");
+                }
+}
+
+}  // namespace
+
+PatternStats analyze_patterns (const PatternSet &patterns, bool ascii_i_case)
+{
+        PatternStats stats;
+        stats.num_patterns = patterns.size ();
+        stats.groups = patterns.has_groups ();
+        stats.min_len = patterns.empty () ? 0 : std::numeric_limits<size_t>::max ();
+        CharSet char_set (ascii_i_case);
+        std::vector<std::string_view> sorted;
+        sorted.reserve (patterns.size ());
+        for (auto pattern : patterns)
+                {
+                        stats.total_len += pattern.size ();
+                        stats.min_len = std::min (stats.min_len, pattern.size ());
+                        stats.max_len = std::max (stats.max_len, pattern.size ());
+                        for (const char &c : pattern)
+                                {
+                                        char_set.add_char (c);
+                                        stats.ascii = stats.ascii && static_cast<unsigned char>(c) < 128;
+                                }
+                        sorted.emplace_back (pattern);
+                }
+        stats.alphabet_size = char_set.size ();
+        auto char_less = [ascii_i_case] (char x, char y)
+        {
+          return fold (x, ascii_i_case) < fold (y, ascii_i_case);
+        };
+        auto less = [&char_less] (std::string_view a, std::string_view b)
+        {
+          return std::lexicographical_compare (a.begin (), a.end (), b.begin (), b.end (), char_less);
+        };
+        std::sort (sorted.begin (), sorted.end (), less);
+        std::string_view prev;
+        for (auto pattern : sorted)
+                {
+                        size_t common = 0;
+                        while (common < prev.size () && common < pattern.size ()
+                               && fold (prev[common], ascii_i_case) == fold (pattern[common], ascii_i_case))
+                                {
+                                        ++common;
+                                }
+                        stats.trie_size += pattern.size () - common;
+                        // prev is a leaf unless pattern extends it
+                        stats.trie_leaves += common < prev.size ();
+                        prev = pattern;
+                }
+        stats.trie_leaves += !prev.empty ();
+        return stats;
+}
+
+size_t estimate_nfa_size (const PatternStats &stats, bool byte_classes)
+{
+        // start and dead state + one State per trie state, a row of transitions for the start and dead state, all leaves
+        //  together and every other trie state, plus at least one match per pattern
+        size_t rows = 3 + stats.trie_size - stats.trie_leaves;
+        size_t columns = byte_classes ? stats.alphabet_size : 128;
+        return (stats.trie_size + 2) * sizeof (State) + rows * columns * sizeof (State *)
+               + stats.num_patterns * (sizeof (PatternID) + sizeof (size_t));
+}
+
+size_t estimate_contiguous_nfa_size (const PatternStats &stats)
+{
+        // dense rows for the start state, the dead state and (at most alphabet_size) states at depth 1, a header, one
+        //  packed code point and one target per remaining state, and the match lists
+        size_t header = stats.groups ? 7 : 3;
+        size_t dense_states = 2 + std::min<size_t> (stats.alphabet_size, stats.trie_size);
+        size_t dense = dense_states * (header + stats.alphabet_size) * sizeof (uint32_t);
+        size_t sparse = stats.trie_size * (header + 1 + 1) * sizeof (uint32_t);
+        return dense + sparse + stats.num_patterns * (2 * sizeof (PatternID) + sizeof (size_t));
+}
+
+size_t estimate_size (AutomatonType type, const PatternStats &stats, bool byte_classes)
+{
+        switch (type)
+                {
+                        case AutomatonType::NFA:
+                                return estimate_nfa_size (stats, byte_classes);
+                        case AutomatonType::CONTIGUOUS_NFA:
+                        case AutomatonType::LAZY_DFA:
+                                return estimate_contiguous_nfa_size (stats);
+                        default:
+                                return 0;
+                }
+}
+
+AutomatonType select_automaton_type (const PatternStats &stats, const BuildConfig &config)
+{
+        size_t budget = std::min (config.memory_budget, config.memory_limit);
+        if (stats.ascii && estimate_nfa_size (stats, config.byte_classes) <= budget)
+                {
+                        return AutomatonType::NFA;
+                }
+        return AutomatonType::CONTIGUOUS_NFA;
+}
+
+// ===== Dynamic =======================================================================================================
+
+Dynamic::Dynamic (const PatternSet &patterns, const BuildConfig &config)
+        : _type (resolve_type (patterns, config)), _automaton (build (_type, patterns, config))
+{}
+
+Dynamic::Dynamic (const PatternSet &patterns, MatchKind match_kind, bool ascii_i_case)
+        : Dynamic (patterns, BuildConfig{match_kind, ascii_i_case})
+{}
+
+AutomatonType Dynamic::type () const
+{
+        return _type;
+}
+
+}  // namespace automaton
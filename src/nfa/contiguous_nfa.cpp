@@ -0,0 +1,683 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ * 
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/nfa/contiguous_nfa.h>
+#include <ac/utils/memory.h>
+
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <stdexcept>
+#include <string>
+
+namespace automaton {
+
+namespace {
+
+constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max ();
+constexpr uint32_t DEAD = 0;
+constexpr uint32_t START = 1;
+
+/// Transition of the intermediate trie. The transitions of a state form a linked list sorted by code point.
+struct BuildTransition {
+  uint32_t next;
+  uint32_t link;
+  CodePoint code_point;
+};
+
+/// Match of the intermediate trie. The matches of a state form a linked list in insertion order.
+struct BuildMatch {
+  PatternID pattern;
+  uint32_t link;
+};
+
+struct BuildState {
+  uint32_t transitions{NONE};
+  uint32_t matches{NONE};
+  uint32_t fail{START};
+  uint32_t depth{0};
+  /// see ContiguousNFA::reachable_groups
+  GroupMask reachable_groups{0};
+};
+
+/**
+ * @brief Sparse trie used while constructing a ContiguousNFA. All states, transitions and matches live in flat
+ *  vectors so that construction does not need a heap allocation per state. Only the start state has a dense row.
+ */
+class TrieBuilder {
+ public:
+  TrieBuilder (size_t alphabet_len, size_t memory_limit, std::pmr::memory_resource *resource)
+          : _states (resource), _start_row (alphabet_len, NONE, resource), _transitions (resource),
+            _matches (resource), _memory_limit (memory_limit)
+  {
+          _states.resize (2);
+          _states[DEAD].fail = DEAD;
+  }
+
+  [[nodiscard]]
+  uint32_t next (uint32_t state, CodePoint code_point) const
+  {
+          if (state == START)
+                  {
+                          return _start_row[code_point];
+                  }
+          if (state == DEAD)
+                  {
+                          return DEAD;
+                  }
+          for (uint32_t t = _states[state].transitions; t != NONE; t = _transitions[t].link)
+                  {
+                          if (_transitions[t].code_point == code_point)
+                                  {
+                                          return _transitions[t].next;
+                                  }
+                          if (_transitions[t].code_point > code_point)
+                                  {
+                                          break;
+                                  }
+                  }
+          return NONE;
+  }
+
+  uint32_t add_state (uint32_t depth)
+  {
+          if (_states.size () == NONE)
+                  {
+                          throw std::length_error ("ContiguousNFA: too many states");
+                  }
+          if (memory_usage () > _memory_limit)
+                  {
+                          throw std::length_error ("ContiguousNFA: memory limit of " + std::to_string (_memory_limit)
+                                                   + " bytes exceeded after " + std::to_string (_states.size ())
+                                                   + " states");
+                  }
+          _states.push_back ({NONE, NONE, START, depth, 0});
+          return static_cast<uint32_t>(_states.size () - 1);
+  }
+
+  void add_transition (uint32_t state, CodePoint code_point, uint32_t next)
+  {
+          if (state == START)
+                  {
+                          _start_row[code_point] = next;
+                          return;
+                  }
+          auto index = static_cast<uint32_t>(_transitions.size ());
+          uint32_t prev = NONE;
+          uint32_t link = _states[state].transitions;
+          while (link != NONE && _transitions[link].code_point < code_point)
+                  {
+                          prev = link;
+                          link = _transitions[link].link;
+                  }
+          _transitions.push_back ({next, link, code_point});
+          (prev == NONE ? _states[state].transitions : _transitions[prev].link) = index;
+  }
+
+  void add_match (uint32_t state, PatternID pattern)
+  {
+          auto index = static_cast<uint32_t>(_matches.size ());
+          uint32_t prev = NONE;
+          for (uint32_t link = _states[state].matches; link != NONE; link = _matches[link].link)
+                  {
+                          if (_matches[link].pattern == pattern)
+                                  {
+                                          return;
+                                  }
+                          prev = link;
+                  }
+          _matches.push_back ({pattern, NONE});
+          (prev == NONE ? _states[state].matches : _matches[prev].link) = index;
+  }
+
+  void copy_matches (uint32_t src, uint32_t dst)
+  {
+          for (uint32_t m = _states[src].matches; m != NONE; m = _matches[m].link)
+                  {
+                          add_match (dst, _matches[m].pattern);
+                  }
+  }
+
+  /**
+   * @brief Call f(code_point, next) for every transition of state in ascending code point order. Self loops and
+   *  transitions to the dead state of the start state are skipped.
+   */
+  template<typename F>
+  void for_each_transition (uint32_t state, F &&f) const
+  {
+          if (state == START)
+                  {
+                          for (size_t cp = 0; cp < _start_row.size (); ++cp)
+                                  {
+                                          uint32_t next = _start_row[cp];
+                                          if (next != NONE && next != START && next != DEAD)
+                                                  {
+                                                          f (static_cast<CodePoint>(cp), next);
+                                                  }
+                                  }
+                          return;
+                  }
+          for (uint32_t t = _states[state].transitions; t != NONE; t = _transitions[t].link)
+                  {
+                          f (_transitions[t].code_point, _transitions[t].next);
+                  }
+  }
+
+  template<typename F>
+  void for_each_match (uint32_t state, F &&f) const
+  {
+          for (uint32_t m = _states[state].matches; m != NONE; m = _matches[m].link)
+                  {
+                          f (_matches[m].pattern);
+                  }
+  }
+
+  [[nodiscard]]
+  bool is_match (uint32_t state) const
+  {
+          return _states[state].matches != NONE;
+  }
+
+  [[nodiscard]]
+  size_t memory_usage () const
+  {
+          return _states.size () * sizeof (BuildState) + _transitions.size () * sizeof (BuildTransition)
+                 + _matches.size () * sizeof (BuildMatch);
+  }
+
+  [[nodiscard]]
+  size_t num_transitions (uint32_t state) const
+  {
+          size_t n = 0;
+          for_each_transition (state, [&n] (CodePoint, uint32_t) { ++n; });
+          return n;
+  }
+
+  std::pmr::vector<BuildState> _states;
+  std::pmr::vector<uint32_t> _start_row;
+  std::pmr::vector<BuildTransition> _transitions;
+  std::pmr::vector<BuildMatch> _matches;
+  size_t _memory_limit;
+};
+
+}  // namespace
+
+ContiguousNFA::ContiguousNFA (const PatternSet &patterns, MatchKind match_kind, bool ascii_i_case,
+                              size_t dense_depth)
+        : ContiguousNFA (patterns, BuildConfig{match_kind, ascii_i_case}, dense_depth)
+{}
+
+ContiguousNFA::ContiguousNFA (const PatternSet &patterns, const BuildConfig &config, size_t dense_depth)
+        : _match_kind (config.match_kind), _char_set (config.ascii_case_insensitive),
+          _repr (table_resource (config)), _matches (1, 0, memory_resource (config)),
+          _pattern_lens (memory_resource (config)), _pattern_groups (memory_resource (config)),
+          _fingerprint (StateLayout::fingerprint (patterns, config))
+{
+        for (auto pattern : patterns)
+                {
+                        for (const char &c : pattern)
+                                {
+                                        _char_set.add_char (c);
+                                }
+                }
+        for (size_t c = 0; c < 256; ++c)
+                {
+                        if (config.byte_classes)
+                                {
+                                        _code_points[c] = _char_set.get_code_point (static_cast<unsigned char>(c));
+                                }
+                        else
+                                {
+                                        _code_points[c] = static_cast<CodePoint>(config.ascii_case_insensitive
+                                                                                 ? std::tolower (static_cast<int>(c))
+                                                                                 : c);
+                                }
+                }
+        _alphabet_len = config.byte_classes ? _char_set.size () : 256;
+        bool is_leftmost = _match_kind != MatchKind::STANDARD;
+        // see NFA::_skip_shadowed
+        bool skip_shadowed = _match_kind == MatchKind::LEFTMOST_FIRST && !config.whole_words;
+        TrieBuilder trie (_alphabet_len, config.memory_limit, memory_resource (config));
+
+        // ----- trie ------------------------------------------------------------------------------------------------
+        for (PatternID id = 0; id < patterns.size (); ++id)
+                {
+                        std::string_view pattern = patterns[id];
+                        _min_pattern_len = std::min (_min_pattern_len, pattern.size ());
+                        _max_pattern_len = std::max (_max_pattern_len, pattern.size ());
+                        _pattern_lens.push_back (pattern.size ());
+                        _pattern_groups.push_back (patterns.group (id));
+                        uint32_t prev = START;
+                        bool skip_pattern = false;
+                        uint32_t depth = 0;
+                        for (const char &c : pattern)
+                                {
+                                        if (skip_shadowed && trie.is_match (prev))
+                                                {
+                                                        // a prefix of this pattern has a higher priority
+                                                        skip_pattern = true;
+                                                }
+                                        CodePoint code_point = _code_points[static_cast<unsigned char>(c)];
+                                        uint32_t next = trie.next (prev, code_point);
+                                        if (next == NONE)
+                                                {
+                                                        if (skip_pattern)
+                                                                {
+                                                                        break;
+                                                                }
+                                                        next = trie.add_state (depth + 1);
+                                                        trie.add_transition (prev, code_point, next);
+                                                }
+                                        prev = next;
+                                        ++depth;
+                                }
+                        // Unless an equal pattern (up to the ASCII case) was added before: pattern then matches
+                        //  whenever that one does and may be reported instead of it (see detail::preferred_pattern).
+                        if (!skip_pattern || (depth == pattern.size () && trie.is_match (prev)))
+                                {
+                                        trie.add_match (prev, id);
+                                        trie._states[prev].reachable_groups |= GroupMask{1} << patterns.group (id);
+                                }
+                }
+        for (auto &next : trie._start_row)
+                {
+                        if (next == NONE)
+                                {
+                                        next = START;
+                                }
+                }
+
+        // ----- failure transitions ---------------------------------------------------------------------------------
+        // See NFA::add_failure_transitions for the leftmost handling.
+        std::pmr::vector<uint32_t> order (memory_resource (config));
+        order.reserve (trie._states.size ());
+        std::pmr::deque<uint32_t> queue (memory_resource (config));
+        bool start_is_match = trie.is_match (START);
+        trie.for_each_transition (START, [&] (CodePoint, uint32_t next)
+        {
+          queue.push_back (next);
+          if (is_leftmost && (start_is_match || trie.is_match (next)))
+            {
+              trie._states[next].fail = DEAD;
+            }
+        });
+        while (!queue.empty ())
+                {
+                        uint32_t state = queue.front ();
+                        queue.pop_front ();
+                        order.push_back (state);
+                        trie.for_each_transition (state, [&] (CodePoint code_point, uint32_t next)
+                        {
+                          queue.push_back (next);
+                          if (is_leftmost && trie.is_match (next))
+                            {
+                              trie._states[next].fail = DEAD;
+                              return;
+                            }
+                          uint32_t fail = trie._states[state].fail;
+                          while (trie.next (fail, code_point) == NONE)
+                            {
+                              fail = trie._states[fail].fail;
+                            }
+                          fail = trie.next (fail, code_point);
+                          trie._states[next].fail = fail;
+                          trie.copy_matches (fail, next);
+                        });
+                        if (!is_leftmost)
+                                {
+                                        trie.copy_matches (START, state);
+                                }
+                }
+        if (is_leftmost && trie.is_match (START))
+                {
+                        for (auto &next : trie._start_row)
+                                {
+                                        if (next == START)
+                                                {
+                                                        next = DEAD;
+                                                }
+                                }
+                }
+
+        // the groups reachable from a state are its own ones and those of its children, which come later in order
+        for (auto it = order.rbegin (); it != order.rend (); ++it)
+                {
+                        auto &state = trie._states[*it];
+                        trie.for_each_transition (*it, [&] (CodePoint, uint32_t next)
+                        {
+                          state.reachable_groups |= trie._states[next].reachable_groups;
+                        });
+                }
+        trie._states[START].reachable_groups = ALL_GROUPS;
+
+        // ----- contiguous layout -----------------------------------------------------------------------------------
+        // States are laid out in breadth first order, so that the (dense) states close to the start state are adjacent,
+        //  or in the order of config.state_layout, which refers to the states by their breadth first index.
+        order.insert (order.begin (), {DEAD, START});
+        if (config.state_layout != nullptr && !config.state_layout->empty ())
+                {
+                        _layout = *config.state_layout;
+                        if (_layout.fingerprint () != _fingerprint)
+                                {
+                                        throw std::invalid_argument ("ContiguousNFA: state layout was computed for "
+                                                                     "other patterns or options");
+                                }
+                        if (!_layout.valid_for (_fingerprint, order.size ()))
+                                {
+                                        throw std::invalid_argument ("ContiguousNFA: state layout of "
+                                                                     + std::to_string (_layout.num_states ())
+                                                                     + " states does not match the "
+                                                                     + std::to_string (order.size ()) + " states");
+                                }
+                        std::pmr::vector<uint32_t> breadth_first (std::move (order));
+                        order = std::pmr::vector<uint32_t> (memory_resource (config));
+                        order.reserve (breadth_first.size ());
+                        for (uint32_t index : _layout.order ())
+                                {
+                                        order.push_back (breadth_first[index]);
+                                }
+                }
+        std::pmr::vector<uint32_t> offsets (trie._states.size (), NONE, memory_resource (config));
+        std::pmr::vector<bool> dense (trie._states.size (), false, memory_resource (config));
+        uint64_t size = 0;
+        if (patterns.has_groups ())
+                {
+                        _header_size += GROUPS_HEADER_SIZE;
+                }
+        for (auto state : order)
+                {
+                        size_t n = trie.num_transitions (state);
+                        size_t sparse_len = (n + 3) / 4 + n;
+                        dense[state] = state == DEAD || state == START || trie._states[state].depth < dense_depth
+                                       || sparse_len >= _alphabet_len;
+                        offsets[state] = static_cast<uint32_t>(size);
+                        size += _header_size + (dense[state] ? _alphabet_len : sparse_len);
+                        if (size >= FAIL)
+                                {
+                                        throw std::length_error ("ContiguousNFA: automaton exceeds 2^32 words");
+                                }
+                        if (size * sizeof (uint32_t) > config.memory_limit)
+                                {
+                                        throw std::length_error ("ContiguousNFA: memory limit of "
+                                                                 + std::to_string (config.memory_limit)
+                                                                 + " bytes exceeded by the transition table");
+                                }
+                }
+        _repr.reserve (size);
+        for (auto state : order)
+                {
+                        const auto &s = trie._states[state];
+                        size_t n = trie.num_transitions (state);
+                        _repr.push_back (dense[state] ? DENSE : static_cast<uint32_t>(n));
+                        _repr.push_back (offsets[s.fail]);
+                        if (trie.is_match (state))
+                                {
+                                        size_t count_index = _matches.size ();
+                                        _matches.push_back (0);
+                                        trie.for_each_match (state, [this, count_index] (PatternID id)
+                                        {
+                                          _matches.push_back (id);
+                                          ++_matches[count_index];
+                                        });
+                                        _repr.push_back (static_cast<uint32_t>(count_index));
+                                }
+                        else
+                                {
+                                        _repr.push_back (0);
+                                }
+                        if (_header_size > HEADER_SIZE)
+                                {
+                                        GroupMask match_groups = 0;
+                                        trie.for_each_match (state, [&] (PatternID id)
+                                        {
+                                          match_groups |= GroupMask{1} << patterns.group (id);
+                                        });
+                                        for (GroupMask mask : {s.reachable_groups, match_groups})
+                                                {
+                                                        _repr.push_back (static_cast<uint32_t>(mask));
+                                                        _repr.push_back (static_cast<uint32_t>(mask >> 32));
+                                                }
+                                }
+                        if (dense[state])
+                                {
+                                        size_t row = _repr.size ();
+                                        _repr.resize (row + _alphabet_len, state == DEAD ? offsets[DEAD] : FAIL);
+                                        if (state == START)
+                                                {
+                                                        for (size_t cp = 0; cp < _alphabet_len; ++cp)
+                                                                {
+                                                                        _repr[row + cp] = offsets[trie._start_row[cp]];
+                                                                }
+                                                }
+                                        else
+                                                {
+                                                        trie.for_each_transition (state, [&] (CodePoint code_point,
+                                                                                              uint32_t next)
+                                                        {
+                                                          _repr[row + code_point] = offsets[next];
+                                                        });
+                                                }
+                                }
+                        else
+                                {
+                                        size_t code_points = _repr.size ();
+                                        _repr.resize (code_points + (n + 3) / 4 + n, 0);
+                                        auto *packed = reinterpret_cast<uint8_t *>(_repr.data () + code_points);
+                                        uint32_t *targets = _repr.data () + code_points + (n + 3) / 4;
+                                        size_t i = 0;
+                                        trie.for_each_transition (state, [&] (CodePoint code_point, uint32_t next)
+                                        {
+                                          packed[i] = code_point;
+                                          targets[i] = offsets[next];
+                                          ++i;
+                                        });
+                                }
+                }
+        _dead_state = offsets[DEAD];
+        _start_state = offsets[START];
+        _num_states = order.size ();
+        _repr.shrink_to_fit ();
+        _matches.shrink_to_fit ();
+}
+
+ContiguousNFA::state_type ContiguousNFA::start_state () const
+{
+        return _start_state;
+}
+
+ContiguousNFA::state_type ContiguousNFA::dead_state () const
+{
+        return _dead_state;
+}
+
+ContiguousNFA::state_type ContiguousNFA::next_state (state_type state, unsigned char c) const
+{
+        const CodePoint code_point = _code_points[c];
+        while (true)
+                {
+                        const uint32_t *s = _repr.data () + state;
+                        const uint32_t kind = s[0];
+                        state_type next = FAIL;
+                        if (kind == DENSE)
+                                {
+                                        next = s[_header_size + code_point];
+                                }
+                        else
+                                {
+                                        const auto *packed = reinterpret_cast<const uint8_t *>(s + _header_size);
+                                        for (uint32_t i = 0; i < kind; ++i)
+                                                {
+                                                        if (packed[i] == code_point)
+                                                                {
+                                                                        next = s[_header_size + (kind + 3) / 4 + i];
+                                                                        break;
+                                                                }
+                                                        if (packed[i] > code_point)
+                                                                {
+                                                                        break;
+                                                                }
+                                                }
+                                }
+                        if (next != FAIL)
+                                {
+                                        return next;
+                                }
+                        state = s[1];
+                }
+}
+
+ContiguousNFA::state_type ContiguousNFA::transition (state_type state, CodePoint code_point) const
+{
+        const uint32_t *s = _repr.data () + state;
+        const uint32_t kind = s[0];
+        if (kind == DENSE)
+                {
+                        return s[_header_size + code_point];
+                }
+        const auto *packed = reinterpret_cast<const uint8_t *>(s + _header_size);
+        for (uint32_t i = 0; i < kind && packed[i] <= code_point; ++i)
+                {
+                        if (packed[i] == code_point)
+                                {
+                                        return s[_header_size + (kind + 3) / 4 + i];
+                                }
+                }
+        return FAIL;
+}
+
+ContiguousNFA::state_type ContiguousNFA::next_state_anchored (state_type state, unsigned char c) const
+{
+        state_type next = transition (state, _code_points[c]);
+        // trie states never lead back to the start state, so this can only be its loop
+        if (next == FAIL || next == _start_state)
+                {
+                        return _dead_state;
+                }
+        return next;
+}
+
+bool ContiguousNFA::is_dead (state_type state) const
+{
+        return state == _dead_state;
+}
+
+bool ContiguousNFA::is_match (state_type state) const
+{
+        return _repr[state + 2] != 0;
+}
+
+std::span<const PatternID> ContiguousNFA::matches (state_type state) const
+{
+        uint32_t index = _repr[state + 2];
+        return {_matches.data () + index + 1, _matches[index]};
+}
+
+size_t ContiguousNFA::pattern_len (PatternID pattern) const
+{
+        return _pattern_lens[pattern];
+}
+
+GroupID ContiguousNFA::pattern_group (PatternID pattern) const
+{
+        return _pattern_groups[pattern];
+}
+
+GroupMask ContiguousNFA::match_groups (state_type state) const
+{
+        if (_header_size == HEADER_SIZE)
+                {
+                        // all patterns belong to group 0
+                        return is_match (state) ? 1 : 0;
+                }
+        return _repr[state + HEADER_SIZE + 2] | (GroupMask{_repr[state + HEADER_SIZE + 3]} << 32);
+}
+
+GroupMask ContiguousNFA::reachable_groups (state_type state) const
+{
+        if (_header_size == HEADER_SIZE)
+                {
+                        return ALL_GROUPS;
+                }
+        return _repr[state + HEADER_SIZE] | (GroupMask{_repr[state + HEADER_SIZE + 1]} << 32);
+}
+
+ContiguousNFA::state_type ContiguousNFA::prune (state_type state, GroupMask groups) const
+{
+        while (state != _start_state && (reachable_groups (state) & groups) == 0)
+                {
+                        state = _repr[state + 1];
+                }
+        return state;
+}
+
+size_t ContiguousNFA::num_states () const
+{
+        return _num_states;
+}
+
+size_t ContiguousNFA::memory_usage () const
+{
+        return _repr.capacity () * sizeof (uint32_t) + _matches.capacity () * sizeof (PatternID)
+               + _pattern_lens.capacity () * sizeof (size_t) + _layout.num_states () * sizeof (uint32_t);
+}
+
+StateLayout ContiguousNFA::profile (std::span<const std::string_view> samples) const
+{
+        // offsets of the states in storage order: the position of a state is found by binary search
+        std::vector<state_type> offsets;
+        offsets.reserve (_num_states);
+        for (size_t offset = 0; offset < _repr.size ();)
+                {
+                        offsets.push_back (static_cast<state_type>(offset));
+                        const uint32_t kind = _repr[offset];
+                        offset += _header_size + (kind == DENSE ? _alphabet_len : (kind + 3) / 4 + kind);
+                }
+        std::vector<uint64_t> visits (offsets.size (), 0);
+        auto visit = [&offsets, &visits] (state_type state)
+        {
+          ++visits[std::lower_bound (offsets.begin (), offsets.end (), state) - offsets.begin ()];
+        };
+        for (auto sample : samples)
+                {
+                        state_type state = _start_state;
+                        for (char c : sample)
+                                {
+                                        const CodePoint code_point = _code_points[static_cast<unsigned char>(c)];
+                                        visit (state);
+                                        state_type next;
+                                        while ((next = transition (state, code_point)) == FAIL)
+                                                {
+                                                        state = _repr[state + 1];
+                                                        visit (state);
+                                                }
+                                        state = next == _dead_state ? _start_state : next;
+                                }
+                }
+        std::vector<uint32_t> positions (offsets.size ());
+        for (uint32_t position = 0; position < positions.size (); ++position)
+                {
+                        positions[position] = position;
+                }
+        std::stable_sort (positions.begin (), positions.end (), [&visits] (uint32_t a, uint32_t b)
+        {
+          return visits[a] > visits[b];
+        });
+        // refer to the states by their breadth first index, also if they are stored in another layout already
+        std::vector<uint32_t> order (positions.size ());
+        for (size_t i = 0; i < positions.size (); ++i)
+                {
+                        order[i] = _layout.empty () ? positions[i] : _layout.order ()[positions[i]];
+                }
+        return StateLayout (std::move (order), _fingerprint);
+}
+
+const StateLayout &ContiguousNFA::layout () const
+{
+        return _layout;
+}
+
+}  // namespace automaton
@@ -7,12 +7,61 @@
 
 #include <ac/search.h>
 #include <ac/nfa/nfa.h>
+#include <ac/utils/memory.h>
+#include <ac/utils/parallel.h>
 
-#include <queue>
-#include <set>
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <stdexcept>
 
 namespace automaton {
 
+namespace {
+
+constexpr PatternID NO_MATCH = std::numeric_limits<PatternID>::max ();
+
+unsigned char fold (char c, bool ascii_i_case)
+{
+        auto u = static_cast<unsigned char>(c);
+        return ascii_i_case ? static_cast<unsigned char>(std::tolower (u)) : u;
+}
+
+/// Three-way comparison of a and b, ignoring the ASCII case if ascii_i_case is set
+int compare (std::string_view a, std::string_view b, bool ascii_i_case)
+{
+        if (!ascii_i_case)
+                {
+                        return a.compare (b);
+                }
+        for (size_t i = 0; i < a.size () && i < b.size (); ++i)
+                {
+                        unsigned char x = fold (a[i], true);
+                        unsigned char y = fold (b[i], true);
+                        if (x != y)
+                                {
+                                        return x < y ? -1 : 1;
+                                }
+                }
+        return a.size () < b.size () ? -1 : (a.size () > b.size () ? 1 : 0);
+}
+
+}  // namespace
+
+State::State (const allocator_type &allocator) : matches (allocator)
+{}
+
+State::State (const State &other, const allocator_type &allocator) : matches (allocator)
+{
+        // assigning keeps the allocator of matches
+        *this = other;
+}
+
+State::State (State &&other, const allocator_type &allocator) : matches (allocator)
+{
+        *this = std::move (other);
+}
+
 bool State::is_match () const
 {
         return !matches.empty ();
@@ -26,126 +75,462 @@ State *State::next_state (CodePoint code_point) const
 
 // ===== NFA ===========================================================================================================
 
-NFA::NFA (const std::vector<std::string> &patterns, MatchKind match_kind, bool ascii_i_case)
-        : _match_kind (match_kind), _ignore_case (ascii_i_case)
+NFA::NFA (const PatternSet &patterns, MatchKind match_kind, bool ascii_i_case)
+        : NFA (patterns, BuildConfig{match_kind, ascii_i_case})
+{}
+
+NFA::NFA (const PatternSet &patterns, const BuildConfig &config)
+        : _match_kind (config.match_kind),
+          _skip_shadowed (config.match_kind == MatchKind::LEFTMOST_FIRST && !config.whole_words),
+          _char_set (config.ascii_case_insensitive), _byte_classes (config.byte_classes),
+          _states (table_resource (config)), _rows (table_resource (config)),
+          _pattern_lens (memory_resource (config)), _pattern_groups (memory_resource (config)),
+          _ignore_case (config.ascii_case_insensitive), _memory_limit (config.memory_limit),
+          _num_threads (config.build_threads)
 {
-        init_start_state ();
         build_trie (patterns);
+        init_start_state ();
         add_start_state_loop ();
         add_dead_state_loop ();
         add_failure_transitions ();
         close_start_state_loop_for_leftmost ();
 }
 
-NFA::~NFA ()
+NFA::state_type NFA::start_state () const
+{
+        return _start_state;
+}
+
+NFA::state_type NFA::dead_state () const
+{
+        return _dead_state;
+}
+
+NFA::state_type NFA::next_state (state_type state, unsigned char c) const
+{
+        if (c >= 128)
+                {
+                        // No pattern contains c: the only states that are left are the dead state and, unless it was
+                        //  closed for leftmost searches, the start state.
+                        while (state != _start_state && state != _dead_state)
+                                {
+                                        state = state->failed;
+                                }
+                        if (state == _dead_state || (_match_kind != MatchKind::STANDARD && _start_state->is_match ()))
+                                {
+                                        return _dead_state;
+                                }
+                        return _start_state;
+                }
+        State *next;
+        const CodePoint column = _code_points[c];
+        while ((next = state->next_state (column)) == nullptr)
+                {
+                        state = state->failed;
+                }
+        return next;
+}
+
+NFA::state_type NFA::next_state_anchored (state_type state, unsigned char c) const
+{
+        if (c >= 128)
+                {
+                        return _dead_state;
+                }
+        State *next = state->next_state (_code_points[c]);
+        // trie states never lead back to the start state, so this can only be its loop
+        if (next == nullptr || next == _start_state)
+                {
+                        return _dead_state;
+                }
+        return next;
+}
+
+bool NFA::is_dead (state_type state) const
+{
+        return state == _dead_state;
+}
+
+bool NFA::is_match (state_type state) const
+{
+        return state->is_match ();
+}
+
+std::span<const PatternID> NFA::matches (state_type state) const
+{
+        return state->matches;
+}
+
+size_t NFA::pattern_len (PatternID pattern) const
+{
+        return _pattern_lens[pattern];
+}
+
+GroupID NFA::pattern_group (PatternID pattern) const
+{
+        return _pattern_groups[pattern];
+}
+
+size_t NFA::num_rows () const
+{
+        return _rows.size () / _num_columns;
+}
+
+size_t NFA::num_columns () const
+{
+        return _num_columns;
+}
+
+size_t NFA::num_states () const
+{
+        return _states.size ();
+}
+
+GroupMask NFA::match_groups (state_type state) const
+{
+        return state->match_groups;
+}
+
+GroupMask NFA::reachable_groups (state_type state) const
+{
+        return state->reachable_groups;
+}
+
+NFA::state_type NFA::prune (state_type state, GroupMask groups) const
 {
-        delete _dead_state;
-        delete _start_state;
-        for (auto *s : _states)
+        while (state != _start_state && (state->reachable_groups & groups) == 0)
                 {
-                        delete s;
+                        state = state->failed;
                 }
+        return state;
 }
 
-void NFA::build_trie (const std::vector<std::string> &patterns)
+void NFA::build_trie (const PatternSet &patterns)
 {
-        for (const auto &pattern : patterns)
+        // Everything that is shared between subtries is done up front, so that the subtries of patterns with different
+        //  first bytes can be built independently of each other.
+        std::vector<PatternID> empty_patterns;
+        for (PatternID id = 0; id < patterns.size (); ++id)
                 {
+                        std::string_view pattern = patterns[id];
                         _min_pattern_len = std::min (_min_pattern_len, pattern.size ());
                         _max_pattern_len = std::max (_max_pattern_len, pattern.size ());
                         _pattern_lens.push_back (pattern.size ());
-                        // TODO: add the pattern to the prefilter here
-                        State *prev = _start_state;
-                        bool saw_match = false;
-                        bool skip_pattern = false;
-                        size_t depth = 0;
+                        _pattern_groups.push_back (patterns.group (id));
                         for (const char &c : pattern)
                                 {
-                                        saw_match = saw_match || prev->is_match ();
-                                        if (_match_kind == MatchKind::LEFTMOST_FIRST && saw_match)
+                                        if (static_cast<unsigned char>(c) >= 128)
                                                 {
-                                                        // skip to the next pattern
-                                                        skip_pattern = true;
-                                                        break;
+                                                        throw std::invalid_argument (
+                                                                "NFA: patterns must be ASCII, use a ContiguousNFA instead");
                                                 }
                                         _char_set.add_char (c);
-                                        State *next = prev->transitions[static_cast<CodePoint>(c)];
-                                        if (next == nullptr)
+                                }
+                        if (pattern.empty ())
+                                {
+                                        empty_patterns.push_back (id);
+                                }
+                }
+        // With byte classes, a row only has a column per char of the patterns, all other chars share column 0. Both
+        //  cases of a char share a column if ignoring case.
+        for (size_t c = 0; c < 256; ++c)
+                {
+                        if (_byte_classes)
+                                {
+                                        _code_points[c] = _char_set.get_code_point (static_cast<unsigned char>(c));
+                                }
+                        else
+                                {
+                                        _code_points[c] = c < 128 ? fold (static_cast<char>(c), _ignore_case) : 0;
+                                }
+                }
+        _num_columns = _byte_classes ? _char_set.size () : 128;
+        // Bucket the pattern IDs by (case folded) first byte. Each bucket is sorted and inserted by its own task.
+        auto bucket_of = [this] (std::string_view pattern)
+        {
+          return fold (pattern[0], _ignore_case);
+        };
+        auto is_inserted = [&] (PatternID id)
+        {
+          return !patterns[id].empty ();
+        };
+        PatternID first_empty = empty_patterns.empty () ? NO_MATCH : empty_patterns[0];
+        std::vector<size_t> bucket_begin (129, 0);
+        for (PatternID id = 0; id < patterns.size (); ++id)
+                {
+                        if (is_inserted (id))
+                                {
+                                        ++bucket_begin[bucket_of (patterns[id]) + 1];
+                                }
+                }
+        for (size_t b = 0; b < 128; ++b)
+                {
+                        bucket_begin[b + 1] += bucket_begin[b];
+                }
+        std::vector<PatternID> order (bucket_begin[128]);
+        {
+                std::vector<size_t> pos (bucket_begin.begin (), bucket_begin.end () - 1);
+                for (PatternID id = 0; id < patterns.size (); ++id)
+                        {
+                                if (is_inserted (id))
+                                        {
+                                                order[pos[bucket_of (patterns[id])]++] = id;
+                                        }
+                        }
+        }
+        auto bucket = [&] (size_t b)
+        {
+          return std::span<const PatternID> (order.data () + bucket_begin[b], order.data () + bucket_begin[b + 1]);
+        };
+        auto less = [&] (PatternID a, PatternID b)
+        {
+          int cmp = compare (patterns[a], patterns[b], _ignore_case);
+          return cmp < 0 || (cmp == 0 && a < b);
+        };
+        // Sort the buckets and count their states and rows, so that all of them can be allocated at once.
+        //  bucket_states[b + 1] is the number of states of bucket b, bucket_rows[b + 1] the number of its rows.
+        std::vector<size_t> bucket_states (129, 0);
+        std::vector<size_t> bucket_rows (129, 0);
+        parallel_for (_num_threads, 128, [&] (size_t b, size_t)
+        {
+          std::sort (order.begin () + bucket_begin[b], order.begin () + bucket_begin[b + 1], less);
+          bucket_states[b + 1] = insert_sorted (patterns, bucket (b), first_empty, nullptr, nullptr,
+                                                bucket_rows[b + 1]);
+        });
+        // start and dead state, and the rows of the leaves, the start state and the dead state
+        bucket_states[0] = 2;
+        bucket_rows[0] = 3;
+        for (size_t b = 0; b < 128; ++b)
+                {
+                        bucket_states[b + 1] += bucket_states[b];
+                        bucket_rows[b + 1] += bucket_rows[b];
+                }
+        size_t num_states = bucket_states[128];
+        size_t num_rows = bucket_rows[128];
+        if (num_states * sizeof (State) + num_rows * _num_columns * sizeof (State *) > _memory_limit)
+                {
+                        throw std::length_error ("NFA: " + std::to_string (num_states) + " states exceed the memory limit of "
+                                                 + std::to_string (_memory_limit) + " bytes");
+                }
+        _states.resize (num_states);
+        _rows.assign (num_rows * _num_columns, nullptr);
+        _start_state = &_states[0];
+        _dead_state = &_states[1];
+        _start_state->transitions = &_rows[_num_columns];
+        _dead_state->transitions = &_rows[2 * _num_columns];
+        _start_state->reachable_groups = ALL_GROUPS;
+        for (auto id : empty_patterns)
+                {
+                        _start_state->match_groups |= GroupMask{1} << patterns.group (id);
+                }
+        _start_state->matches.assign (empty_patterns.begin (), empty_patterns.end ());
+        parallel_for (_num_threads, 128, [&] (size_t b, size_t)
+        {
+          size_t rows;
+          insert_sorted (patterns, bucket (b), first_empty, &_states[bucket_states[b]],
+                         &_rows[bucket_rows[b] * _num_columns], rows);
+        });
+}
+
+size_t NFA::insert_sorted (const PatternSet &patterns, std::span<const PatternID> ids, PatternID first_empty,
+                           State *first_state, State **first_row, size_t &num_rows)
+{
+        size_t num_states = 0;
+        num_rows = 0;
+        // The existing states on the path of the previous pattern: path[d] is the state at depth d and min_match[d] the
+        //  smallest ID matching at any state of the path up to depth d. The next pattern shares the states of its
+        //  common prefix with the previous pattern, all other states are new. has_row[d] tells if path[d] has a row of
+        //  its own already, i.e. if it has a transition (the start state always has).
+        std::vector<State *> path{_start_state};
+        // an empty pattern matches before any pattern added after it
+        std::vector<PatternID> min_match{first_empty};
+        std::vector<bool> has_row{true};
+        std::string_view prev;
+        for (PatternID id : ids)
+                {
+                        std::string_view pattern = patterns[id];
+                        size_t common = 0;
+                        while (common + 1 < path.size () && common < pattern.size ()
+                               && fold (prev[common], _ignore_case) == fold (pattern[common], _ignore_case))
+                                {
+                                        ++common;
+                                }
+                        path.resize (common + 1);
+                        min_match.resize (common + 1);
+                        has_row.resize (common + 1);
+                        prev = pattern;
+                        // Skip pattern if a proper prefix of it was added before and always matches first. Unless it
+                        //  equals the previous pattern (up to the ASCII case): it then matches whenever that one does
+                        //  and may be reported instead of it (see detail::preferred_pattern).
+                        if (_skip_shadowed && common < pattern.size () && min_match[common] < id)
+                                {
+                                        continue;
+                                }
+                        for (size_t depth = common; depth < pattern.size (); ++depth)
+                                {
+                                        State *parent = path.back ();
+                                        State *next = nullptr;
+                                        if (!has_row.back ())
+                                                {
+                                                        if (first_state != nullptr)
+                                                                {
+                                                                        parent->transitions = first_row + num_rows * _num_columns;
+                                                                }
+                                                        has_row.back () = true;
+                                                        ++num_rows;
+                                                }
+                                        if (first_state != nullptr)
                                                 {
-                                                        next = add_state (depth);
-                                                        prev->transitions[static_cast<CodePoint>(c)] = next;
-                                                        if (_ignore_case)
+                                                        next = first_state + num_states;
+                                                        next->depth = depth + 1;
+                                                        next->failed = _start_state;
+                                                        // until it gets a transition, a state shares the leaf row
+                                                        next->transitions = _rows.data ();
+                                                        // the start state is shared by all buckets
+                                                        if (parent != _start_state)
                                                                 {
-                                                                        prev->transitions[opposite_ascii_case (c)] = next;
+                                                                        parent->leaf = false;
                                                                 }
+                                                        unsigned char c = pattern[depth];
+                                                        parent->transitions[_code_points[c]] = next;
                                                 }
-                                        prev = next;
-                                        ++depth;
+                                        ++num_states;
+                                        path.push_back (next);
+                                        min_match.push_back (min_match.back ());
+                                        has_row.push_back (false);
                                 }
-                        if (skip_pattern)
+                        if (first_state != nullptr)
                                 {
-                                        continue;
+                                        GroupMask group = GroupMask{1} << patterns.group (id);
+                                        path.back ()->matches.push_back (id);
+                                        path.back ()->match_groups |= group;
+                                        for (size_t depth = 1; depth < path.size (); ++depth)
+                                                {
+                                                        path[depth]->reachable_groups |= group;
+                                                }
                                 }
-                        prev->matches.insert (&pattern);
+                        min_match.back () = std::min (min_match.back (), id);
                 }
+        return num_states;
 }
 
 void NFA::add_failure_transitions ()
 {
-        bool is_leftmost = _match_kind == MatchKind::LEFTMOST_FIRST;
-        std::queue<State *> queue{};
-        std::set<State *> visited{nullptr};
-        for (auto &next : _start_state->transitions)
+        bool is_leftmost = _match_kind != MatchKind::STANDARD;
+        // For leftmost match kinds, a match state must never fail: a match found later would start right of the one
+        //  already found. Since failure transitions are computed from the failure transition of the parent, all states
+        //  following a match state fail to the dead state as well. An empty pattern matches at the start state, so in
+        //  this case every state fails to the dead state.
+        bool start_is_match = _start_state->is_match ();
+        // Only chars of the patterns have transitions. If ignoring case, both cases of a char share a column, so every
+        //  state is reached exactly once.
+        bool used[128]{false};
+        for (int c = 0; c < 128; ++c)
                 {
-                        if (visited.contains (next))
+                        if (_char_set.get_code_point (c) != 0)
+                                {
+                                        used[fold (c, _ignore_case)] = true;
+                                }
+                }
+        std::vector<CodePoint> chars;
+        for (int c = 0; c < 128; ++c)
+                {
+                        if (used[c])
+                                {
+                                        chars.push_back (_code_points[c]);
+                                }
+                }
+        // States are visited level by level. All states a state of the next level depends on (its failure state and
+        //  the failure state's matches) are on a level that is already done, so a level can be split across threads.
+        //  queue holds all levels in BFS order, the current level is queue[level_begin, level_end).
+        std::vector<State *> queue;
+        queue.reserve (_states.size ());
+        for (auto c : chars)
+                {
+                        State *next = _start_state->transitions[c];
+                        if (next == _start_state)
                                 continue;
-                        queue.push (next);
-                        visited.insert (next);
-                        if (is_leftmost && next->is_match ())
+                        queue.push_back (next);
+                        if (is_leftmost && (start_is_match || next->is_match ()))
                                 next->failed = _dead_state;
+                        if (!is_leftmost)
+                                copy_matches (_start_state, next);
                 }
-        while (!queue.empty ())
+        // levels smaller than this are not worth splitting
+        constexpr size_t chunk_size = 1024;
+        std::vector<std::vector<State *>> next_levels;
+        size_t level_begin = 0;
+        while (level_begin < queue.size ())
                 {
-                        auto *state = queue.front ();
-                        queue.pop ();
-                        for (int c = 0; c < 128; ++c)
+                        size_t level_end = queue.size ();
+                        size_t num_chunks = (level_end - level_begin + chunk_size - 1) / chunk_size;
+                        next_levels.resize (std::max (next_levels.size (), num_chunks));
+                        parallel_for (_num_threads, num_chunks, [&] (size_t chunk, size_t)
+                        {
+                          auto &next_level = next_levels[chunk];
+                          next_level.clear ();
+                          size_t end = std::min (level_end, level_begin + (chunk + 1) * chunk_size);
+                          for (size_t i = level_begin + chunk * chunk_size; i < end; ++i)
+                            {
+                              State *state = queue[i];
+                              if (state->leaf)
+                                continue;
+                              for (auto c : chars)
                                 {
-                                        State *next = state->transitions[c];
-                                        if (visited.contains (next))
-                                                continue;
-                                        queue.push (next);
-                                        visited.insert (next);
-                                        if (is_leftmost && next->is_match ())
-                                                {
-                                                        next->failed = _dead_state;
-                                                        continue;
-                                                }
-                                        State *fail = state->failed;
-                                        while (fail->next_state (c) == nullptr)
-                                                {
-                                                        fail = fail->failed;
-                                                }
-                                        fail = fail->next_state (c);
-                                        next->failed = fail;
-                                        copy_matches (fail, next);
+                                  State *next = state->transitions[c];
+                                  if (next == nullptr)
+                                    continue;
+                                  next_level.push_back (next);
+                                  if (is_leftmost && next->is_match ())
+                                    {
+                                      next->failed = _dead_state;
+                                      continue;
+                                    }
+                                  State *fail = state->failed;
+                                  while (fail->next_state (c) == nullptr)
+                                    {
+                                      fail = fail->failed;
+                                    }
+                                  fail = fail->next_state (c);
+                                  next->failed = fail;
+                                  // for STANDARD, the matches of fail include those of the start state
+                                  copy_matches (fail, next);
                                 }
-                        if (!is_leftmost)
+                            }
+                        });
+                        for (size_t chunk = 0; chunk < num_chunks; ++chunk)
                                 {
-                                        copy_matches (_start_state, state);
+                                        queue.insert (queue.end (), next_levels[chunk].begin (), next_levels[chunk].end ());
                                 }
+                        level_begin = level_end;
                 }
 }
 
-void NFA::copy_matches (State *src, State *dst)
+void NFA::copy_matches (const State *src, State *dst)
 {
-        dst->matches.insert (src->matches.begin (), src->matches.end ());
-}
-
-State *NFA::add_state (size_t depth)
-{
-        auto *state = new State {{nullptr}, {}, _start_state, depth};
-        _states.push_back (state);
-        return state;
+        if (src->matches.empty ())
+                {
+                        return;
+                }
+        dst->match_groups |= src->match_groups;
+        size_t own = dst->matches.size ();
+        dst->matches.resize (own + src->matches.size ());
+        // merge from the back, so that neither a temporary buffer (as for std::inplace_merge) nor any allocation but
+        //  the one of dst's resource is needed
+        auto out = dst->matches.end ();
+        auto mine = dst->matches.begin () + static_cast<std::ptrdiff_t>(own);
+        auto theirs = src->matches.end ();
+        while (theirs != src->matches.begin ())
+                {
+                        if (mine != dst->matches.begin () && *(mine - 1) > *(theirs - 1))
+                                {
+                                        *--out = *--mine;
+                                }
+                        else
+                                {
+                                        *--out = *--theirs;
+                                }
+                }
 }
 
 void NFA::init_start_state ()
@@ -155,7 +540,7 @@ void NFA::init_start_state ()
 
 void NFA::add_start_state_loop ()
 {
-        for (auto &s : _start_state->transitions)
+        for (auto &s : std::span (_start_state->transitions, _num_columns))
                 {
                         if (s == nullptr)
                                 {
@@ -165,24 +550,20 @@ void NFA::add_start_state_loop ()
 }
 void NFA::close_start_state_loop_for_leftmost ()
 {
-        if (_match_kind == MatchKind::LEFTMOST_FIRST && _start_state->is_match ())
+        if (_match_kind != MatchKind::STANDARD && _start_state->is_match ())
                 {
-                        for (uint8_t c = 0; /**/; ++c)
+                        for (auto &s : std::span (_start_state->transitions, _num_columns))
                                 {
-                                        if (_start_state->next_state (c) == _start_state)
-                                                {
-                                                        _start_state->transitions[c] = _dead_state;
-                                                }
-                                        if (c == 255)
+                                        if (s == _start_state)
                                                 {
-                                                        break;
+                                                        s = _dead_state;
                                                 }
                                 }
                 }
 }
 void NFA::add_dead_state_loop ()
 {
-        for (auto &s : _dead_state->transitions)
+        for (auto &s : std::span (_dead_state->transitions, _num_columns))
                 {
                         s = _dead_state;
                 }
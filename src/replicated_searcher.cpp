@@ -0,0 +1,101 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/replicated_searcher.h>
+#include <ac/utils/parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <utility>
+
+template<typename automaton_type>
+ReplicatedSearcher<automaton_type>::ReplicatedSearcher (const PatternSet &patterns, const BuildConfig &config,
+                                                        NumaTopology topology)
+        : _topology (std::move (topology)), _match_kind (config.match_kind), _num_patterns (patterns.size ()),
+          _replicas (_topology.num_nodes ())
+{
+        if (config.automaton_type == AutomatonType::LAZY_DFA)
+                {
+                        throw std::invalid_argument ("ReplicatedSearcher: a lazy DFA must not be shared by threads");
+                }
+        run_on_nodes (_topology, 1, [&] (size_t node, size_t)
+        {
+          _replicas[node] = std::make_unique<AhoCorasick<automaton_type>> (patterns, config);
+        });
+}
+
+template<typename automaton_type>
+const NumaTopology &ReplicatedSearcher<automaton_type>::topology () const
+{
+        return _topology;
+}
+
+template<typename automaton_type>
+const AhoCorasick<automaton_type> &ReplicatedSearcher<automaton_type>::replica (size_t node) const
+{
+        return *_replicas[node];
+}
+
+template<typename automaton_type>
+const AhoCorasick<automaton_type> &ReplicatedSearcher<automaton_type>::local () const
+{
+        return *_replicas[_topology.current_node ()];
+}
+
+template<typename automaton_type>
+std::vector<size_t> ReplicatedSearcher<automaton_type>::match_histogram (std::string_view input, size_t num_threads,
+                                                                         GroupMask groups) const
+{
+        const size_t num_nodes = _topology.num_nodes ();
+        const size_t threads_per_node = std::max<size_t> (1, resolve_num_threads (num_threads) / num_nodes);
+        const size_t segment_len = AhoCorasick<automaton_type>::MIN_PARALLEL_SEGMENT_LEN;
+        const size_t num_segments = (input.size () + segment_len - 1) / segment_len;
+        if (_match_kind != MatchKind::STANDARD || num_segments <= 1)
+                {
+                        return local ().match_histogram (input, num_threads, groups);
+                }
+        // segments by the node holding their first page
+        std::vector<std::vector<size_t>> node_segments (num_nodes);
+        for (size_t segment = 0; segment < num_segments; ++segment)
+                {
+                        auto node = _topology.node_of (input.data () + segment * segment_len);
+                        node_segments[node.value_or (segment % num_nodes)].push_back (segment);
+                }
+        std::vector<std::atomic<size_t>> next_segment (num_nodes);
+        std::vector<std::vector<size_t>> thread_counts (num_nodes * threads_per_node,
+                                                        std::vector<size_t> (_num_patterns, 0));
+        run_on_nodes (_topology, threads_per_node, [&] (size_t node, size_t thread)
+        {
+          const auto &searcher = replica (node);
+          for (size_t i = 0; i < num_nodes; ++i)
+            {
+              const auto &segments = node_segments[(node + i) % num_nodes];
+              auto &next = next_segment[(node + i) % num_nodes];
+              size_t index;
+              while ((index = next.fetch_add (1, std::memory_order_relaxed)) < segments.size ())
+                {
+                  const size_t begin = segments[index] * segment_len;
+                  searcher.count_segment_matches (input, begin, std::min (begin + segment_len, input.size ()),
+                                                  thread_counts[thread], groups);
+                }
+            }
+        });
+        std::vector<size_t> counts (_num_patterns, 0);
+        for (const auto &histogram : thread_counts)
+                {
+                        for (size_t pattern = 0; pattern < counts.size (); ++pattern)
+                                {
+                                        counts[pattern] += histogram[pattern];
+                                }
+                }
+        return counts;
+}
+
+template class ReplicatedSearcher<automaton::NFA>;
+template class ReplicatedSearcher<automaton::ContiguousNFA>;
+template class ReplicatedSearcher<automaton::Dynamic>;
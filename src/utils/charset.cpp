@@ -12,13 +12,24 @@
 CharSet::CharSet (bool ignore_case) : _ignore_case (ignore_case)
 {}
 
-uint8_t CharSet::size () const
+uint16_t CharSet::size () const
 {
         return _size;
 }
 
 void CharSet::add_char (unsigned char c)
 {
+        if (get_code_point (c) != 0)
+                {
+                        return;
+                }
+        if (_size == 256)
+                {
+                        // All other code points are taken: c is the last char not covered yet and thus exclusively
+                        //  owns code point 0.
+                        _mapping[0] = c;
+                        return;
+                }
         if (_ignore_case)
                 {
                         _mapping[_size] = std::tolower (c);
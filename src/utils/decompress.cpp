@@ -0,0 +1,428 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/utils/decompress.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+#if defined(AC_WITH_ZLIB)
+#include <zlib.h>
+#endif
+#if defined(AC_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace detail {
+
+/**
+ * @brief Decompresses a stream that is passed in blocks of arbitrary size.
+ */
+class Decoder {
+ public:
+  virtual ~Decoder () = default;
+
+  /**
+   * @brief Decompress input into out until either of them is exhausted.
+   * @param input the input consumed is removed from it
+   * @param out
+   * @return the number of bytes written to out
+   */
+  virtual size_t decode (std::string_view &input, std::span<char> out) = 0;
+
+  /**
+   * @brief Check if the input decoded so far ends at the end of a gzip member or zstd frame, i.e. is not truncated.
+   */
+  [[nodiscard]]
+  virtual bool complete () const = 0;
+};
+
+}  // namespace detail
+
+namespace {
+
+/// number of compressed bytes read from the file at once
+constexpr size_t INPUT_BLOCK_SIZE{size_t{1} << 18};
+
+#if defined(AC_WITH_ZLIB)
+class GzipDecoder : public detail::Decoder {
+ public:
+  GzipDecoder ()
+  {
+          // 15 + 32: maximum window size, detecting gzip and zlib headers automatically
+          if (inflateInit2 (&_stream, 15 + 32) != Z_OK)
+                  {
+                          throw std::runtime_error ("gzip: cannot initialize zlib");
+                  }
+  }
+
+  GzipDecoder (const GzipDecoder &) = delete;
+  GzipDecoder &operator= (const GzipDecoder &) = delete;
+
+  ~GzipDecoder () override
+  {
+          inflateEnd (&_stream);
+  }
+
+  size_t decode (std::string_view &input, std::span<char> out) override
+  {
+          _stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data ()));
+          _stream.avail_in = static_cast<uInt>(std::min<size_t> (input.size (), UINT_MAX));
+          _stream.next_out = reinterpret_cast<Bytef *>(out.data ());
+          _stream.avail_out = static_cast<uInt>(std::min<size_t> (out.size (), UINT_MAX));
+          const uInt out_size = _stream.avail_out;
+          const uInt in_size = _stream.avail_in;
+          while (_stream.avail_in > 0 && _stream.avail_out > 0)
+                  {
+                          if (_complete && !start_member ())
+                                  {
+                                          // like gzip, ignore data following the last member, e.g. zero padding
+                                          //  added by tar
+                                          _trailing = true;
+                                          _stream.avail_in = 0;
+                                          break;
+                                  }
+                          if (_complete)
+                                  {
+                                          // the first byte of the magic number ended the input
+                                          continue;
+                                  }
+                          int status = inflate (&_stream, Z_NO_FLUSH);
+                          if (status == Z_STREAM_END)
+                                  {
+                                          _complete = true;
+                                  }
+                          else if (status != Z_OK)
+                                  {
+                                          throw std::runtime_error (std::string ("gzip: ")
+                                                                    + (_stream.msg != nullptr ? _stream.msg
+                                                                                              : "invalid data"));
+                                  }
+                  }
+          input.remove_prefix (in_size - _stream.avail_in);
+          return out_size - _stream.avail_out;
+  }
+
+  [[nodiscard]]
+  bool complete () const override
+  {
+          return _complete;
+  }
+
+ private:
+  static constexpr unsigned char MAGIC[2]{0x1f, 0x8b};
+
+  /**
+   * @brief Start the next member of the gzip file (a gzip file may consist of several members) if the input starts
+   *  with the gzip magic number. If the input ends after its first byte, the byte is consumed and the member is started
+   *  with the next input.
+   * @return false if the input is trailing data instead
+   */
+  bool start_member ()
+  {
+          if (_trailing)
+                  {
+                          return false;
+                  }
+          if (!_magic_split && _stream.avail_in == 1 && _stream.next_in[0] == MAGIC[0])
+                  {
+                          _magic_split = true;
+                          ++_stream.next_in;
+                          --_stream.avail_in;
+                          return true;
+                  }
+          bool magic = _magic_split ? _stream.next_in[0] == MAGIC[1]
+                                    : _stream.avail_in >= 2 && _stream.next_in[0] == MAGIC[0]
+                                      && _stream.next_in[1] == MAGIC[1];
+          if (!magic)
+                  {
+                          return false;
+                  }
+          inflateReset (&_stream);
+          _complete = false;
+          if (_magic_split)
+                  {
+                          // feed the consumed first byte of the magic number, which only moves the header state
+                          _magic_split = false;
+                          Bytef *next_in = _stream.next_in;
+                          uInt avail_in = _stream.avail_in;
+                          _stream.next_in = const_cast<Bytef *>(&MAGIC[0]);
+                          _stream.avail_in = 1;
+                          inflate (&_stream, Z_NO_FLUSH);
+                          _stream.next_in = next_in;
+                          _stream.avail_in = avail_in;
+                  }
+          return true;
+  }
+
+  z_stream _stream{};
+  /// true if no member was started or the last one ended
+  bool _complete{true};
+  /// true if the input following the last member was found not to be a member
+  bool _trailing{false};
+  /// true if the input ended after the first byte of the magic number of the next member
+  bool _magic_split{false};
+};
+#endif
+
+#if defined(AC_WITH_ZSTD)
+class ZstdDecoder : public detail::Decoder {
+ public:
+  ZstdDecoder () : _stream (ZSTD_createDStream ())
+  {
+          if (_stream == nullptr)
+                  {
+                          throw std::runtime_error ("zstd: cannot create a decompression stream");
+                  }
+  }
+
+  ZstdDecoder (const ZstdDecoder &) = delete;
+  ZstdDecoder &operator= (const ZstdDecoder &) = delete;
+
+  ~ZstdDecoder () override
+  {
+          ZSTD_freeDStream (_stream);
+  }
+
+  size_t decode (std::string_view &input, std::span<char> out) override
+  {
+          ZSTD_inBuffer in_buffer{input.data (), input.size (), 0};
+          ZSTD_outBuffer out_buffer{out.data (), out.size (), 0};
+          while (in_buffer.pos < in_buffer.size && out_buffer.pos < out_buffer.size)
+                  {
+                          // frames follow each other without a reset, 0 means that a frame just ended
+                          size_t hint = ZSTD_decompressStream (_stream, &out_buffer, &in_buffer);
+                          if (ZSTD_isError (hint))
+                                  {
+                                          throw std::runtime_error (std::string ("zstd: ") + ZSTD_getErrorName (hint));
+                                  }
+                          _complete = hint == 0;
+                  }
+          input.remove_prefix (in_buffer.pos);
+          return out_buffer.pos;
+  }
+
+  [[nodiscard]]
+  bool complete () const override
+  {
+          return _complete;
+  }
+
+ private:
+  ZSTD_DStream *_stream;
+  /// true if no frame was started or the last one ended
+  bool _complete{true};
+};
+#endif
+
+std::unique_ptr<detail::Decoder> make_decoder (Compression compression)
+{
+        switch (compression)
+                {
+#if defined(AC_WITH_ZLIB)
+                        case Compression::GZIP:
+                                return std::make_unique<GzipDecoder> ();
+#endif
+#if defined(AC_WITH_ZSTD)
+                        case Compression::ZSTD:
+                                return std::make_unique<ZstdDecoder> ();
+#endif
+                        default:
+                                return nullptr;
+                }
+}
+
+}  // namespace
+
+Compression detect_compression (std::string_view head)
+{
+        if (head.size () >= 2 && head[0] == '\x1f' && head[1] == '\x8b')
+                {
+                        return Compression::GZIP;
+                }
+        if (head.size () >= 4 && head.substr (0, 4) == std::string_view ("\x28\xb5\x2f\xfd", 4))
+                {
+                        return Compression::ZSTD;
+                }
+        return Compression::NONE;
+}
+
+bool compression_supported (Compression compression)
+{
+        switch (compression)
+                {
+                        case Compression::NONE:
+                                return true;
+                        case Compression::GZIP:
+#if defined(AC_WITH_ZLIB)
+                                return true;
+#else
+                                return false;
+#endif
+                        case Compression::ZSTD:
+#if defined(AC_WITH_ZSTD)
+                                return true;
+#else
+                                return false;
+#endif
+                }
+        return false;
+}
+
+DecompressingReader::DecompressingReader (const std::filesystem::path &path, size_t buffer_size, size_t num_buffers)
+        : _file (path, std::ios::binary), _path (path.string ()),
+          _buffers (std::max<size_t> (num_buffers, 2), std::string (std::max<size_t> (buffer_size, 1), '\0')),
+          _lengths (_buffers.size (), 0)
+{
+        if (!_file)
+                {
+                        throw std::runtime_error (_path + ": " + std::strerror (errno));
+                }
+        char head[4];
+        _file.read (head, sizeof (head));
+        _compression = detect_compression (std::string_view (head, _file.gcount ()));
+        _file.clear ();
+        _file.seekg (0);
+        if (!compression_supported (_compression))
+                {
+                        throw std::runtime_error (std::string ("built without support for ")
+                                                  + (_compression == Compression::GZIP ? "gzip" : "zstd"));
+                }
+        _decoder = make_decoder (_compression);
+        if (_decoder != nullptr)
+                {
+                        _input.resize (INPUT_BLOCK_SIZE);
+                }
+        _thread = std::thread (&DecompressingReader::produce, this);
+}
+
+DecompressingReader::~DecompressingReader ()
+{
+        {
+                std::lock_guard lock (_mutex);
+                _stop = true;
+        }
+        _changed.notify_all ();
+        _thread.join ();
+}
+
+Compression DecompressingReader::compression () const
+{
+        return _compression;
+}
+
+std::optional<std::string_view> DecompressingReader::next ()
+{
+        std::unique_lock lock (_mutex);
+        if (_released < _consumed)
+                {
+                        _released = _consumed;
+                        _changed.notify_all ();
+                }
+        _changed.wait (lock, [this] ()
+        {
+          return _produced > _consumed || _done;
+        });
+        if (_produced > _consumed)
+                {
+                        size_t index = _consumed++ % _buffers.size ();
+                        return std::string_view (_buffers[index].data (), _lengths[index]);
+                }
+        if (_exception)
+                {
+                        std::rethrow_exception (std::exchange (_exception, nullptr));
+                }
+        return std::nullopt;
+}
+
+Generator<std::string_view> DecompressingReader::chunks ()
+{
+        while (auto chunk = next ())
+                {
+                        co_yield *chunk;
+                }
+}
+
+std::string *DecompressingReader::acquire ()
+{
+        std::unique_lock lock (_mutex);
+        _changed.wait (lock, [this] ()
+        {
+          return _produced - _released < _buffers.size () || _stop;
+        });
+        return _stop ? nullptr : &_buffers[_produced % _buffers.size ()];
+}
+
+size_t DecompressingReader::fill (std::span<char> buffer)
+{
+        size_t filled = 0;
+        if (_decoder == nullptr)
+                {
+                        // uncompressed: only read ahead
+                        _file.read (buffer.data (), static_cast<std::streamsize>(buffer.size ()));
+                        filled = static_cast<size_t>(_file.gcount ());
+                }
+        while (_decoder != nullptr && filled < buffer.size ())
+                {
+                        if (_pending.empty ())
+                                {
+                                        if (_end_of_file)
+                                                {
+                                                        break;
+                                                }
+                                        _file.read (_input.data (), static_cast<std::streamsize>(_input.size ()));
+                                        _pending = std::string_view (_input.data (), _file.gcount ());
+                                        _end_of_file = !_file;
+                                        continue;
+                                }
+                        filled += _decoder->decode (_pending, buffer.subspan (filled));
+                }
+        if (_file.bad ())
+                {
+                        throw std::runtime_error ("read error");
+                }
+        return filled;
+}
+
+void DecompressingReader::produce ()
+{
+        try
+                {
+                        std::string *buffer;
+                        while ((buffer = acquire ()) != nullptr)
+                                {
+                                        size_t filled = fill (*buffer);
+                                        if (filled > 0)
+                                                {
+                                                        std::lock_guard lock (_mutex);
+                                                        _lengths[_produced % _buffers.size ()] = filled;
+                                                        ++_produced;
+                                                        _changed.notify_all ();
+                                                }
+                                        if (filled < buffer->size ())
+                                                {
+                                                        break;
+                                                }
+                                }
+                        if (buffer != nullptr && _decoder != nullptr && !_decoder->complete ())
+                                {
+                                        throw std::runtime_error ("unexpected end of compressed data");
+                                }
+                }
+        catch (...)
+                {
+                        std::lock_guard lock (_mutex);
+                        _exception = std::current_exception ();
+                }
+        std::lock_guard lock (_mutex);
+        _done = true;
+        _changed.notify_all ();
+}
@@ -0,0 +1,101 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/utils/lines.h>
+
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+size_t count_newlines (std::string_view input)
+{
+        const char *pos = input.data ();
+        const char *end = pos + input.size ();
+        size_t count = 0;
+        // the comparison results (-1 per newline) are subtracted from byte counters, which are summed up before they
+        //  can overflow, i.e. after at most 255 blocks
+#if defined(__AVX2__)
+        const __m256i newline = _mm256_set1_epi8 ('\n');
+        while (end - pos >= 32)
+                {
+                        size_t num_blocks = std::min<size_t> ((end - pos) / 32, 255);
+                        __m256i counters = _mm256_setzero_si256 ();
+                        for (size_t block = 0; block < num_blocks; ++block, pos += 32)
+                                {
+                                        __m256i chunk = _mm256_loadu_si256 (reinterpret_cast<const __m256i *>(pos));
+                                        counters = _mm256_sub_epi8 (counters, _mm256_cmpeq_epi8 (chunk, newline));
+                                }
+                        __m256i sums = _mm256_sad_epu8 (counters, _mm256_setzero_si256 ());
+                        count += _mm256_extract_epi16 (sums, 0) + _mm256_extract_epi16 (sums, 4)
+                                 + _mm256_extract_epi16 (sums, 8) + _mm256_extract_epi16 (sums, 12);
+                }
+#elif defined(__SSE2__)
+        const __m128i newline = _mm_set1_epi8 ('\n');
+        while (end - pos >= 16)
+                {
+                        size_t num_blocks = std::min<size_t> ((end - pos) / 16, 255);
+                        __m128i counters = _mm_setzero_si128 ();
+                        for (size_t block = 0; block < num_blocks; ++block, pos += 16)
+                                {
+                                        __m128i chunk = _mm_loadu_si128 (reinterpret_cast<const __m128i *>(pos));
+                                        counters = _mm_sub_epi8 (counters, _mm_cmpeq_epi8 (chunk, newline));
+                                }
+                        __m128i sums = _mm_sad_epu8 (counters, _mm_setzero_si128 ());
+                        count += _mm_extract_epi16 (sums, 0) + _mm_extract_epi16 (sums, 4);
+                }
+#endif
+        return count + std::count (pos, end, '\n');
+}
+
+LineLocator::LineLocator (std::string_view input) : _input (input), _line_end (input.find ('\n'))
+{
+        if (_line_end == std::string_view::npos)
+                {
+                        _line_end = _input.size ();
+                }
+}
+
+void LineLocator::locate (size_t pos)
+{
+        if (pos >= _line_start && pos <= _line_end)
+                {
+                        return;
+                }
+        if (pos > _line_end)
+                {
+                        _line_number += count_newlines (_input.substr (_line_end, pos - _line_end));
+                        // there is a newline at _line_end at least
+                        _line_start = _input.rfind ('\n', pos - 1) + 1;
+                }
+        else
+                {
+                        _line_number -= count_newlines (_input.substr (pos, _line_start - pos));
+                        _line_start = pos == 0 ? 0 : _input.rfind ('\n', pos - 1) + 1;
+                }
+        _line_end = _input.find ('\n', pos);
+        if (_line_end == std::string_view::npos)
+                {
+                        _line_end = _input.size ();
+                }
+}
+
+size_t LineLocator::line_number () const
+{
+        return _line_number;
+}
+
+size_t LineLocator::line_start () const
+{
+        return _line_start;
+}
+
+size_t LineLocator::line_end () const
+{
+        return _line_end;
+}
@@ -0,0 +1,120 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/utils/long_patterns.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+unsigned char fold (unsigned char c, bool ignore_case)
+{
+        return ignore_case ? static_cast<unsigned char>(std::tolower (c)) : c;
+}
+
+}  // namespace
+
+LongPatterns::LongPatterns (const PatternSet &patterns, size_t threshold, bool ascii_case_insensitive)
+        : _threshold (threshold), _ignore_case (ascii_case_insensitive)
+{
+        if (threshold == 0)
+                {
+                        return;
+                }
+        _long.resize (patterns.size (), false);
+        for (PatternID id = 0; id < patterns.size (); ++id)
+                {
+                        if (patterns[id].size () > threshold)
+                                {
+                                        _long[id] = true;
+                                        ++_num_long;
+                                }
+                }
+}
+
+bool LongPatterns::empty () const
+{
+        return _num_long == 0;
+}
+
+size_t LongPatterns::threshold () const
+{
+        return _threshold;
+}
+
+bool LongPatterns::is_long (PatternID pattern) const
+{
+        return _num_long > 0 && _long[pattern];
+}
+
+PatternSet LongPatterns::anchors (const PatternSet &patterns) const
+{
+        PatternSet anchors;
+        for (PatternID id = 0; id < patterns.size (); ++id)
+                {
+                        std::string_view pattern = patterns[id];
+                        anchors.add (is_long (id) ? pattern.substr (0, _threshold) : pattern, patterns.group (id));
+                }
+        return anchors;
+}
+
+bool LongPatterns::confirm (std::string_view input, size_t start, std::string_view bytes) const
+{
+        if (start > input.size () || input.size () - start < bytes.size ())
+                {
+                        return false;
+                }
+        // the anchor was matched by the automaton
+        bytes.remove_prefix (std::min (_threshold, bytes.size ()));
+        start += _threshold;
+        if (!_ignore_case)
+                {
+                        return std::memcmp (input.data () + start, bytes.data (), bytes.size ()) == 0;
+                }
+        return std::equal (bytes.begin (), bytes.end (), input.begin () + static_cast<std::ptrdiff_t>(start),
+                           [] (char a, char b)
+                           {
+                             return fold (static_cast<unsigned char>(a), true)
+                                    == fold (static_cast<unsigned char>(b), true);
+                           });
+}
+
+size_t LongPatterns::memory_usage () const
+{
+        return _long.capacity () / 8;
+}
+
+LongMatchQueue::LongMatchQueue (const LongPatterns &long_patterns, const PatternSet &patterns, std::string_view input)
+        : _long_patterns (long_patterns), _patterns (patterns), _input (input)
+{}
+
+bool LongMatchQueue::push (const Match &match)
+{
+        if (!_long_patterns.is_long (match.pattern))
+                {
+                        return true;
+                }
+        std::string_view bytes = _patterns[match.pattern];
+        if (_long_patterns.confirm (_input, match.start, bytes))
+                {
+                        _queue.push (Match{match.pattern, match.start, match.start + bytes.size ()});
+                }
+        return false;
+}
+
+std::optional<Match> LongMatchQueue::pop (size_t end)
+{
+        if (_queue.empty () || _queue.top ().end > end)
+                {
+                        return std::nullopt;
+                }
+        Match match = _queue.top ();
+        _queue.pop ();
+        return match;
+}
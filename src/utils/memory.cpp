@@ -0,0 +1,111 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/utils/memory.h>
+
+#include <cstdint>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+size_t round_up_to_huge_pages (size_t bytes)
+{
+        return (bytes + HugePageResource::HUGE_PAGE_SIZE - 1) & ~(HugePageResource::HUGE_PAGE_SIZE - 1);
+}
+
+bool use_huge_pages (size_t bytes, size_t alignment)
+{
+#if defined(__linux__)
+        return bytes >= HugePageResource::MIN_SIZE && alignment <= HugePageResource::HUGE_PAGE_SIZE;
+#else
+        return false;
+#endif
+}
+
+}  // namespace
+
+HugePageResource::HugePageResource (std::pmr::memory_resource *upstream) : _upstream (upstream)
+{}
+
+std::pmr::memory_resource *HugePageResource::upstream_resource () const
+{
+        return _upstream;
+}
+
+void *HugePageResource::do_allocate (size_t bytes, size_t alignment)
+{
+        if (!use_huge_pages (bytes, alignment))
+                {
+                        return _upstream->allocate (bytes, alignment);
+                }
+#if defined(__linux__)
+        size_t size = round_up_to_huge_pages (bytes);
+        void *p = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED)
+                {
+                        return p;
+                }
+        // no reserved huge pages left: map one huge page more than needed and trim it to an aligned range, so that the
+        //  whole range can be backed by transparent huge pages
+        void *mapped = mmap (nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                             0);
+        if (mapped == MAP_FAILED)
+                {
+                        throw std::bad_alloc ();
+                }
+        auto begin = reinterpret_cast<uintptr_t>(mapped);
+        auto aligned = (begin + HUGE_PAGE_SIZE - 1) & ~(uintptr_t{HUGE_PAGE_SIZE} - 1);
+        if (aligned > begin)
+                {
+                        munmap (mapped, aligned - begin);
+                }
+        munmap (reinterpret_cast<void *>(aligned + size), begin + HUGE_PAGE_SIZE - aligned);
+        p = reinterpret_cast<void *>(aligned);
+        madvise (p, size, MADV_HUGEPAGE);
+        return p;
+#else
+        return nullptr;
+#endif
+}
+
+void HugePageResource::do_deallocate (void *p, size_t bytes, size_t alignment)
+{
+        if (!use_huge_pages (bytes, alignment))
+                {
+                        _upstream->deallocate (p, bytes, alignment);
+                        return;
+                }
+#if defined(__linux__)
+        munmap (p, round_up_to_huge_pages (bytes));
+#endif
+}
+
+bool HugePageResource::do_is_equal (const std::pmr::memory_resource &other) const noexcept
+{
+        const auto *huge = dynamic_cast<const HugePageResource *>(&other);
+        return huge != nullptr && huge->_upstream->is_equal (*_upstream);
+}
+
+std::pmr::memory_resource *huge_page_resource ()
+{
+        static HugePageResource resource;
+        return &resource;
+}
+
+std::pmr::memory_resource *memory_resource (const BuildConfig &config)
+{
+        return config.memory_resource != nullptr ? config.memory_resource : std::pmr::get_default_resource ();
+}
+
+std::pmr::memory_resource *table_resource (const BuildConfig &config)
+{
+        return config.huge_pages ? huge_page_resource () : memory_resource (config);
+}
@@ -0,0 +1,313 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/utils/numa.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/// ID of the next topology constructed (see NumaTopology::_id)
+std::atomic<uint64_t> next_topology_id{0};
+
+/// the nodes the current thread was bound to by NumaTopology::bind_thread, as pairs of topology ID and node
+thread_local std::vector<std::pair<uint64_t, size_t>> bound_nodes;
+
+/**
+ * @brief Get the node the current thread was bound to by the topology of ID id, or nullptr if it was not bound by it.
+ */
+size_t *bound_node (uint64_t id)
+{
+        auto it = std::find_if (bound_nodes.begin (), bound_nodes.end (), [id] (const auto &binding)
+        {
+          return binding.first == id;
+        });
+        return it == bound_nodes.end () ? nullptr : &it->second;
+}
+
+/**
+ * @brief Parse a list of CPUs and CPU ranges, e.g. "0-3,8". Whitespace around it is ignored.
+ * @return false if list is malformed
+ */
+bool parse_cpu_list (std::string_view list, std::vector<size_t> &cpus)
+{
+        while (!list.empty () && std::isspace (static_cast<unsigned char>(list.back ())))
+                {
+                        list.remove_suffix (1);
+                }
+        while (!list.empty () && std::isspace (static_cast<unsigned char>(list.front ())))
+                {
+                        list.remove_prefix (1);
+                }
+        auto parse_number = [&list] (size_t &value)
+        {
+          if (list.empty () || list[0] < '0' || list[0] > '9')
+            {
+              return false;
+            }
+          value = 0;
+          while (!list.empty () && list[0] >= '0' && list[0] <= '9')
+            {
+              value = value * 10 + (list[0] - '0');
+              list.remove_prefix (1);
+            }
+          return true;
+        };
+        while (!list.empty ())
+                {
+                        size_t first, last;
+                        if (!parse_number (first))
+                                {
+                                        return false;
+                                }
+                        last = first;
+                        if (!list.empty () && list[0] == '-')
+                                {
+                                        list.remove_prefix (1);
+                                        if (!parse_number (last) || last < first)
+                                                {
+                                                        return false;
+                                                }
+                                }
+                        for (size_t cpu = first; cpu <= last; ++cpu)
+                                {
+                                        cpus.push_back (cpu);
+                                }
+                        if (!list.empty ())
+                                {
+                                        if (list[0] != ',' || list.size () == 1)
+                                                {
+                                                        return false;
+                                                }
+                                        list.remove_prefix (1);
+                                }
+                }
+        return true;
+}
+
+}  // namespace
+
+NumaTopology::NumaTopology () : _cpus (1), _ids {0}, _id (next_topology_id.fetch_add (1, std::memory_order_relaxed))
+{
+        for (size_t cpu = 0; cpu < std::max<size_t> (1, std::thread::hardware_concurrency ()); ++cpu)
+                {
+                        _cpus[0].push_back (cpu);
+                }
+}
+
+NumaTopology NumaTopology::detect ()
+{
+        NumaTopology topology;
+#if defined(__linux__)
+        namespace fs = std::filesystem;
+        std::vector<std::pair<size_t, std::vector<size_t>>> nodes;
+        std::error_code error;
+        for (fs::directory_iterator it ("/sys/devices/system/node", error), end; !error && it != end;
+             it.increment (error))
+                {
+                        std::string name = it->path ().filename ().string ();
+                        if (name.size () <= 4 || name.compare (0, 4, "node") != 0
+                            || name.find_first_not_of ("0123456789", 4) != std::string::npos)
+                                {
+                                        continue;
+                                }
+                        std::ifstream stream (it->path () / "cpulist");
+                        std::string list;
+                        std::vector<size_t> cpus;
+                        if (!std::getline (stream, list) || !parse_cpu_list (list, cpus))
+                                {
+                                        return topology;
+                                }
+                        nodes.emplace_back (std::stoul (name.substr (4)), std::move (cpus));
+                }
+        if (error || nodes.empty ())
+                {
+                        return topology;
+                }
+        std::sort (nodes.begin (), nodes.end ());
+        topology._cpus.clear ();
+        topology._ids.clear ();
+        for (auto &[id, cpus] : nodes)
+                {
+                        topology._ids.push_back (id);
+                        topology._cpus.push_back (std::move (cpus));
+                }
+#endif
+        return topology;
+}
+
+NumaTopology NumaTopology::parse (std::string_view description)
+{
+        if (description.empty ())
+                {
+                        throw std::invalid_argument ("invalid NUMA topology: no nodes");
+                }
+        NumaTopology topology;
+        topology._cpus.clear ();
+        topology._ids.clear ();
+        topology._fake = true;
+        while (true)
+                {
+                        size_t separator = description.find (';');
+                        std::vector<size_t> cpus;
+                        if (!parse_cpu_list (description.substr (0, separator), cpus))
+                                {
+                                        throw std::invalid_argument ("invalid NUMA topology: "
+                                                                     + std::string (description));
+                                }
+                        topology._ids.push_back (topology._cpus.size ());
+                        topology._cpus.push_back (std::move (cpus));
+                        if (separator == std::string_view::npos)
+                                {
+                                        break;
+                                }
+                        description.remove_prefix (separator + 1);
+                }
+        return topology;
+}
+
+size_t NumaTopology::num_nodes () const
+{
+        return _cpus.size ();
+}
+
+const std::vector<size_t> &NumaTopology::cpus (size_t node) const
+{
+        return _cpus[node];
+}
+
+bool NumaTopology::fake () const
+{
+        return _fake;
+}
+
+size_t NumaTopology::current_node () const
+{
+        if (const size_t *node = bound_node (_id); node != nullptr && *node < _cpus.size ())
+                {
+                        return *node;
+                }
+#if defined(__linux__)
+        int cpu = sched_getcpu ();
+        for (size_t node = 0; cpu >= 0 && node < _cpus.size (); ++node)
+                {
+                        if (std::find (_cpus[node].begin (), _cpus[node].end (), static_cast<size_t>(cpu))
+                            != _cpus[node].end ())
+                                {
+                                        return node;
+                                }
+                }
+#endif
+        return 0;
+}
+
+bool NumaTopology::bind_thread (size_t node) const
+{
+        if (size_t *bound = bound_node (_id); bound != nullptr)
+                {
+                        *bound = node;
+                }
+        else
+                {
+                        bound_nodes.emplace_back (_id, node);
+                }
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO (&set);
+        for (size_t cpu : _cpus[node])
+                {
+                        if (cpu < CPU_SETSIZE)
+                                {
+                                        CPU_SET (cpu, &set);
+                                }
+                }
+        return CPU_COUNT (&set) > 0 && sched_setaffinity (0, sizeof (set), &set) == 0;
+#else
+        return false;
+#endif
+}
+
+std::optional<size_t> NumaTopology::node_of (const void *address) const
+{
+        if (_fake)
+                {
+                        return (reinterpret_cast<uintptr_t>(address) / FAKE_INTERLEAVE) % _cpus.size ();
+                }
+#if defined(__linux__)
+        auto page_size = static_cast<uintptr_t>(sysconf (_SC_PAGESIZE));
+        void *page = reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(address) & ~(page_size - 1));
+        int status = -1;
+        // without target nodes, move_pages only reports the node of every page (or a negative error code)
+        if (syscall (SYS_move_pages, 0, 1, &page, nullptr, &status, 0) != 0 || status < 0)
+                {
+                        return std::nullopt;
+                }
+        auto it = std::find (_ids.begin (), _ids.end (), static_cast<size_t>(status));
+        if (it != _ids.end ())
+                {
+                        return it - _ids.begin ();
+                }
+#endif
+        return std::nullopt;
+}
+
+void run_on_nodes (const NumaTopology &topology, size_t threads_per_node,
+                   const std::function<void (size_t, size_t)> &f)
+{
+        std::exception_ptr exception{nullptr};
+        std::mutex exception_mutex;
+        // joined on destruction as well, so that no thread outlives f if starting one of them throws
+        std::vector<std::jthread> threads;
+        threads.reserve (topology.num_nodes () * threads_per_node);
+        for (size_t node = 0; node < topology.num_nodes (); ++node)
+                {
+                        for (size_t i = 0; i < threads_per_node; ++i)
+                                {
+                                        threads.emplace_back ([&, node, thread = threads.size ()] ()
+                                        {
+                                          topology.bind_thread (node);
+                                          try
+                                            {
+                                              f (node, thread);
+                                            }
+                                          catch (...)
+                                            {
+                                              std::lock_guard lock (exception_mutex);
+                                              if (!exception)
+                                                {
+                                                  exception = std::current_exception ();
+                                                }
+                                            }
+                                        });
+                                }
+                }
+        for (auto &thread : threads)
+                {
+                        thread.join ();
+                }
+        if (exception)
+                {
+                        std::rethrow_exception (exception);
+                }
+}
@@ -0,0 +1,87 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ * 
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/utils/parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+size_t resolve_num_threads (size_t requested)
+{
+        if (requested != 0)
+                {
+                        return requested;
+                }
+        return std::max<size_t> (1, std::thread::hardware_concurrency ());
+}
+
+void parallel_for (size_t num_threads, size_t num_tasks, const std::function<void (size_t, size_t)> &f)
+{
+        num_threads = std::min (resolve_num_threads (num_threads), num_tasks);
+        if (num_threads <= 1)
+                {
+                        for (size_t task = 0; task < num_tasks; ++task)
+                                {
+                                        f (task, 0);
+                                }
+                        return;
+                }
+        std::atomic<size_t> next_task{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr exception{nullptr};
+        std::mutex exception_mutex;
+        auto worker = [&] (size_t thread)
+        {
+          size_t task;
+          while (!failed.load (std::memory_order_relaxed)
+                 && (task = next_task.fetch_add (1, std::memory_order_relaxed)) < num_tasks)
+            {
+              try
+                {
+                  f (task, thread);
+                }
+              catch (...)
+                {
+                  std::lock_guard lock (exception_mutex);
+                  if (!exception)
+                    {
+                      exception = std::current_exception ();
+                    }
+                  failed = true;
+                }
+            }
+        };
+        // joined on destruction as well, so that no thread outlives f if starting one of them throws
+        std::vector<std::jthread> threads;
+        threads.reserve (num_threads - 1);
+        try
+                {
+                        for (size_t thread = 1; thread < num_threads; ++thread)
+                                {
+                                        threads.emplace_back (worker, thread);
+                                }
+                }
+        catch (...)
+                {
+                        // let the started threads stop after their current task
+                        failed = true;
+                        throw;
+                }
+        worker (0);
+        for (auto &thread : threads)
+                {
+                        thread.join ();
+                }
+        if (exception)
+                {
+                        std::rethrow_exception (exception);
+                }
+}
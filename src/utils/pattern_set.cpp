@@ -0,0 +1,77 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ * 
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/utils/pattern_set.h>
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+PatternSet::PatternSet (std::initializer_list<std::string_view> patterns)
+{
+        for (auto pattern : patterns)
+                {
+                        add (pattern);
+                }
+}
+
+void PatternSet::add (std::string_view pattern, GroupID group)
+{
+        if (size () >= std::numeric_limits<PatternID>::max ())
+                {
+                        throw std::length_error ("PatternSet: too many patterns");
+                }
+        if (group >= MAX_GROUPS)
+                {
+                        throw std::invalid_argument ("PatternSet: group " + std::to_string (group) + " is not less than "
+                                                     + std::to_string (MAX_GROUPS));
+                }
+        _bytes.append (pattern);
+        _offsets.push_back (_bytes.size ());
+        _groups.push_back (group);
+        _has_groups = _has_groups || group != 0;
+}
+
+size_t PatternSet::size () const
+{
+        return _offsets.size () - 1;
+}
+
+bool PatternSet::empty () const
+{
+        return size () == 0;
+}
+
+std::string_view PatternSet::operator[] (PatternID id) const
+{
+        return {_bytes.data () + _offsets[id], _offsets[id + 1] - _offsets[id]};
+}
+
+GroupID PatternSet::group (PatternID id) const
+{
+        return _groups[id];
+}
+
+bool PatternSet::has_groups () const
+{
+        return _has_groups;
+}
+
+size_t PatternSet::total_len () const
+{
+        return _bytes.size ();
+}
+
+PatternSet::const_iterator PatternSet::begin () const
+{
+        return {this, 0};
+}
+
+PatternSet::const_iterator PatternSet::end () const
+{
+        return {this, static_cast<PatternID>(size ())};
+}
@@ -5,7 +5,10 @@
  * This file is part of builddir.
  */
 
+#include <algorithm>
 #include <cctype>
+#include <cstring>
+#include <limits>
 #include <ac/utils/prefilter.h>
 
 unsigned char opposite_ascii_case(unsigned char c) {
@@ -15,4 +18,150 @@ unsigned char opposite_ascii_case(unsigned char c) {
                 return std::toupper (c);
         }
         return c;
-}
\ No newline at end of file
+}
+
+Prefilter::Prefilter (const PatternSet &patterns, bool ascii_i_case)
+{
+        if (init_window (patterns, ascii_i_case))
+                {
+                        _enabled = true;
+                        return;
+                }
+        for (auto pattern : patterns)
+                {
+                        if (pattern.empty ())
+                                {
+                                        return;
+                                }
+                        auto c = static_cast<unsigned char>(pattern[0]);
+                        _start_bytes[c] = true;
+                        if (ascii_i_case)
+                                {
+                                        _start_bytes[opposite_ascii_case (c)] = true;
+                                }
+                }
+        for (size_t c = 0; c < 256; ++c)
+                {
+                        if (_start_bytes[c])
+                                {
+                                        _start_byte = static_cast<unsigned char>(c);
+                                        ++_num_start_bytes;
+                                }
+                }
+        _enabled = _num_start_bytes > 0 && _num_start_bytes <= MAX_START_BYTES;
+}
+
+bool Prefilter::init_window (const PatternSet &patterns, bool ascii_i_case)
+{
+        size_t min_len = patterns.empty () ? 0 : std::numeric_limits<size_t>::max ();
+        for (auto pattern : patterns)
+                {
+                        min_len = std::min (min_len, pattern.size ());
+                }
+        if (min_len < MIN_WINDOW)
+                {
+                        return false;
+                }
+        const size_t window = std::min (min_len, MAX_WINDOW);
+        for (size_t c = 0; c < 256; ++c)
+                {
+                        _fold[c] = static_cast<unsigned char>(ascii_i_case ? std::tolower (static_cast<int>(c)) : c);
+                }
+        // a block that is not part of any pattern prefix lets the window move past it entirely
+        _shift.assign (size_t{1} << 16, static_cast<uint8_t>(window - 1));
+        _prefix_blocks.assign (size_t{1} << 16, false);
+        // the bytes of the patterns approximate the input the patterns are searched in
+        size_t frequency[256]{0};
+        for (auto pattern : patterns)
+                {
+                        for (size_t j = 1; j < window; ++j)
+                                {
+                                        auto &shift = _shift[block (pattern[j - 1], pattern[j])];
+                                        shift = std::min (shift, static_cast<uint8_t>(window - 1 - j));
+                                }
+                        _prefix_blocks[block (pattern[0], pattern[1])] = true;
+                        for (unsigned char c : pattern)
+                                {
+                                        ++frequency[_fold[c]];
+                                }
+                }
+        // estimate the average shift over the input, weighting each block by the frequencies of its bytes
+        double total_weight = 0;
+        double total_shift = 0;
+        for (size_t first = 0; first < 256; ++first)
+                {
+                        for (size_t second = 0; second < 256 && frequency[first] > 0; ++second)
+                                {
+                                        double weight = static_cast<double>(frequency[first]) * frequency[second];
+                                        total_weight += weight;
+                                        total_shift += weight * _shift[(first << 8) | second];
+                                }
+                }
+        if (total_shift < MIN_MEAN_SHIFT * total_weight)
+                {
+                        _shift.clear ();
+                        _prefix_blocks.clear ();
+                        return false;
+                }
+        _window = window;
+        return true;
+}
+
+bool Prefilter::enabled () const
+{
+        return _enabled;
+}
+
+size_t Prefilter::window () const
+{
+        return _window;
+}
+
+size_t Prefilter::find_candidate (std::string_view input, size_t at) const
+{
+        if (at >= input.size ())
+                {
+                        return input.size ();
+                }
+        if (_window > 0)
+                {
+                        return find_window (input, at);
+                }
+        if (_num_start_bytes == 1)
+                {
+                        const void *found = std::memchr (input.data () + at, _start_byte, input.size () - at);
+                        return found == nullptr ? input.size () : static_cast<const char *>(found) - input.data ();
+                }
+        while (at < input.size () && !_start_bytes[static_cast<unsigned char>(input[at])])
+                {
+                        ++at;
+                }
+        return at;
+}
+
+size_t Prefilter::find_window (std::string_view input, size_t at) const
+{
+        if (input.size () - at < _window)
+                {
+                        return at;
+                }
+        // the last position of the window starting at at
+        size_t end = at + _window - 1;
+        while (end < input.size ())
+                {
+                        size_t shift = _shift[block (input[end - 1], input[end])];
+                        if (shift > 0)
+                                {
+                                        end += shift;
+                                        continue;
+                                }
+                        size_t start = end + 1 - _window;
+                        if (_prefix_blocks[block (input[start], input[start + 1])])
+                                {
+                                        return start;
+                                }
+                        ++end;
+                }
+        // the windows from here on extend beyond input
+        return std::min (end + 1 - _window, input.size ());
+}
@@ -0,0 +1,168 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/utils/result_cache.h>
+
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+struct Key {
+  size_t hash;
+  uint64_t searcher;
+  GroupMask groups;
+  /// points into the input stored by the entry (or the input looked up)
+  std::string_view input;
+
+  bool operator== (const Key &other) const
+  {
+          return hash == other.hash && searcher == other.searcher && groups == other.groups && input == other.input;
+  }
+};
+
+struct KeyHash {
+  size_t operator() (const Key &key) const
+  {
+          return key.hash;
+  }
+};
+
+struct Entry {
+  uint64_t searcher;
+  GroupMask groups;
+  std::string input;
+  std::vector<Match> matches;
+  size_t bytes;
+};
+
+/// estimated size of the list and map nodes of an entry besides the Entry itself
+constexpr size_t NODE_OVERHEAD{64};
+
+Key make_key (uint64_t searcher, GroupMask groups, std::string_view input)
+{
+        size_t hash = std::hash<std::string_view>{} (input);
+        // mix in the searcher and the groups, so that entries of several searchers spread over the shards evenly
+        hash ^= (searcher + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+        hash ^= (groups + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+        return Key{hash, searcher, groups, input};
+}
+
+}  // namespace
+
+struct ResultCache::Shard {
+  std::mutex mutex;
+  /// most recently used first
+  std::list<Entry> entries;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+  size_t bytes{0};
+  size_t hits{0};
+  size_t misses{0};
+  size_t evictions{0};
+};
+
+ResultCache::ResultCache (size_t capacity, size_t num_shards, size_t max_input_len)
+        : _max_input_len (max_input_len), _shard_capacity (capacity / std::max<size_t> (num_shards, 1))
+{
+        for (size_t i = 0; i < std::max<size_t> (num_shards, 1); ++i)
+                {
+                        _shards.push_back (std::make_unique<Shard> ());
+                }
+}
+
+ResultCache::~ResultCache () = default;
+
+size_t ResultCache::max_input_len () const
+{
+        return _max_input_len;
+}
+
+ResultCache::Shard &ResultCache::shard (size_t hash)
+{
+        return *_shards[hash % _shards.size ()];
+}
+
+std::optional<std::vector<Match>> ResultCache::lookup (uint64_t searcher, GroupMask groups, std::string_view input)
+{
+        if (input.size () > _max_input_len)
+                {
+                        _skipped.fetch_add (1, std::memory_order_relaxed);
+                        return std::nullopt;
+                }
+        Key key = make_key (searcher, groups, input);
+        Shard &s = shard (key.hash);
+        std::lock_guard lock (s.mutex);
+        auto it = s.index.find (key);
+        if (it == s.index.end ())
+                {
+                        ++s.misses;
+                        return std::nullopt;
+                }
+        ++s.hits;
+        s.entries.splice (s.entries.begin (), s.entries, it->second);
+        return it->second->matches;
+}
+
+void ResultCache::insert (uint64_t searcher, GroupMask groups, std::string_view input, std::span<const Match> matches)
+{
+        const size_t bytes = sizeof (Entry) + NODE_OVERHEAD + input.size () + matches.size () * sizeof (Match);
+        if (input.size () > _max_input_len || bytes > _shard_capacity)
+                {
+                        return;
+                }
+        Key key = make_key (searcher, groups, input);
+        Shard &s = shard (key.hash);
+        std::lock_guard lock (s.mutex);
+        if (s.index.contains (key))
+                {
+                        // inserted by another thread that missed at the same time
+                        return;
+                }
+        while (s.bytes + bytes > _shard_capacity)
+                {
+                        const Entry &victim = s.entries.back ();
+                        s.index.erase (make_key (victim.searcher, victim.groups, victim.input));
+                        s.bytes -= victim.bytes;
+                        s.entries.pop_back ();
+                        ++s.evictions;
+                }
+        s.entries.push_front (Entry{searcher, groups, std::string (input), {matches.begin (), matches.end ()}, bytes});
+        key.input = s.entries.front ().input;
+        s.index.emplace (key, s.entries.begin ());
+        s.bytes += bytes;
+}
+
+ResultCache::Stats ResultCache::stats () const
+{
+        Stats stats;
+        stats.skipped = _skipped.load (std::memory_order_relaxed);
+        for (const auto &s : _shards)
+                {
+                        std::lock_guard lock (s->mutex);
+                        stats.hits += s->hits;
+                        stats.misses += s->misses;
+                        stats.evictions += s->evictions;
+                        stats.entries += s->entries.size ();
+                        stats.bytes += s->bytes;
+                }
+        return stats;
+}
+
+void ResultCache::clear ()
+{
+        for (const auto &s : _shards)
+                {
+                        std::lock_guard lock (s->mutex);
+                        s->index.clear ();
+                        s->entries.clear ();
+                        s->bytes = 0;
+                }
+}
@@ -0,0 +1,152 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/utils/state_layout.h>
+
+#include <ac/search.h>
+#include <ac/utils/pattern_set.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+/// leading bytes of a saved layout, followed by the fingerprint (uint64_t), the number of states (uint64_t) and the
+///  order (uint32_t each)
+constexpr char MAGIC[8] = {'A', 'C', 'L', 'A', 'Y', 'O', 'U', '2'};
+
+/// FNV-1a
+class Hasher {
+ public:
+  void add (const void *data, size_t size)
+  {
+          for (size_t i = 0; i < size; ++i)
+                  {
+                          _hash = (_hash ^ static_cast<const unsigned char *>(data)[i]) * 0x100000001b3ULL;
+                  }
+  }
+
+  void add (uint64_t value)
+  {
+          add (&value, sizeof (value));
+  }
+
+  [[nodiscard]]
+  uint64_t hash () const
+  {
+          return _hash;
+  }
+
+ private:
+  uint64_t _hash{0xcbf29ce484222325ULL};
+};
+
+}  // namespace
+
+StateLayout::StateLayout (std::vector<uint32_t> order, uint64_t fingerprint)
+        : _order (std::move (order)), _fingerprint (fingerprint)
+{}
+
+uint64_t StateLayout::fingerprint (const PatternSet &patterns, const BuildConfig &config)
+{
+        Hasher hasher;
+        hasher.add (patterns.size ());
+        for (auto pattern : patterns)
+                {
+                        // the length first, so that the concatenation of the patterns is not all that counts
+                        hasher.add (pattern.size ());
+                        hasher.add (pattern.data (), pattern.size ());
+                }
+        hasher.add (static_cast<uint64_t>(config.match_kind));
+        hasher.add (config.ascii_case_insensitive);
+        hasher.add (config.byte_classes);
+        hasher.add (config.whole_words);
+        return hasher.hash ();
+}
+
+StateLayout StateLayout::load (std::istream &in)
+{
+        char magic[sizeof (MAGIC)];
+        uint64_t fingerprint = 0;
+        uint64_t num_states = 0;
+        if (!in.read (magic, sizeof (magic)) || std::memcmp (magic, MAGIC, sizeof (MAGIC)) != 0
+            || !in.read (reinterpret_cast<char *>(&fingerprint), sizeof (fingerprint))
+            || !in.read (reinterpret_cast<char *>(&num_states), sizeof (num_states)))
+                {
+                        throw std::runtime_error ("invalid state layout: bad header");
+                }
+        std::vector<uint32_t> order;
+        // read in blocks, so that a corrupt size does not allocate more than the stream holds
+        constexpr size_t BLOCK_SIZE{size_t{1} << 16};
+        while (order.size () < num_states)
+                {
+                        size_t n = std::min<uint64_t> (BLOCK_SIZE, num_states - order.size ());
+                        order.resize (order.size () + n);
+                        if (!in.read (reinterpret_cast<char *>(order.data () + order.size () - n),
+                                      static_cast<std::streamsize>(n * sizeof (uint32_t))))
+                                {
+                                        throw std::runtime_error ("invalid state layout: truncated");
+                                }
+                }
+        StateLayout layout (std::move (order), fingerprint);
+        if (!layout.is_permutation ())
+                {
+                        throw std::runtime_error ("invalid state layout: not a permutation of its states");
+                }
+        return layout;
+}
+
+void StateLayout::save (std::ostream &out) const
+{
+        uint64_t num_states = _order.size ();
+        out.write (MAGIC, sizeof (MAGIC));
+        out.write (reinterpret_cast<const char *>(&_fingerprint), sizeof (_fingerprint));
+        out.write (reinterpret_cast<const char *>(&num_states), sizeof (num_states));
+        out.write (reinterpret_cast<const char *>(_order.data ()),
+                   static_cast<std::streamsize>(_order.size () * sizeof (uint32_t)));
+}
+
+bool StateLayout::empty () const
+{
+        return _order.empty ();
+}
+
+size_t StateLayout::num_states () const
+{
+        return _order.size ();
+}
+
+const std::vector<uint32_t> &StateLayout::order () const
+{
+        return _order;
+}
+
+uint64_t StateLayout::fingerprint () const
+{
+        return _fingerprint;
+}
+
+bool StateLayout::valid_for (uint64_t fingerprint, size_t num_states) const
+{
+        return _fingerprint == fingerprint && _order.size () == num_states && is_permutation ();
+}
+
+bool StateLayout::is_permutation () const
+{
+        std::vector<bool> seen (_order.size (), false);
+        for (uint32_t state : _order)
+                {
+                        if (state >= _order.size () || seen[state])
+                                {
+                                        return false;
+                                }
+                        seen[state] = true;
+                }
+        return true;
+}
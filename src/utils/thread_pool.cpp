@@ -0,0 +1,153 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/utils/thread_pool.h>
+#include <ac/utils/parallel.h>
+
+#include <utility>
+
+namespace {
+
+/// the pool the current thread is a worker of and its index within the pool
+thread_local const WorkStealingPool *current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool (size_t num_threads)
+{
+        num_threads = resolve_num_threads (num_threads);
+        for (size_t worker = 0; worker < num_threads; ++worker)
+                {
+                        _queues.push_back (std::make_unique<Queue> ());
+                }
+        for (size_t worker = 0; worker < num_threads; ++worker)
+                {
+                        _threads.emplace_back (&WorkStealingPool::run, this, worker);
+                }
+}
+
+WorkStealingPool::~WorkStealingPool ()
+{
+        {
+                std::lock_guard lock (_mutex);
+                _stop = true;
+        }
+        _work_available.notify_all ();
+        for (auto &thread : _threads)
+                {
+                        thread.join ();
+                }
+}
+
+void WorkStealingPool::submit (Task task)
+{
+        size_t queue = current_pool == this ? current_worker
+                                            : _next_queue.fetch_add (1, std::memory_order_relaxed) % _queues.size ();
+        _pending.fetch_add (1);
+        _queued.fetch_add (1);
+        {
+                std::lock_guard lock (_queues[queue]->mutex);
+                _queues[queue]->tasks.push_back (std::move (task));
+        }
+        {
+                // a worker going to sleep checks _queued while holding _mutex, so it cannot miss the notification
+                std::lock_guard lock (_mutex);
+        }
+        _work_available.notify_one ();
+}
+
+void WorkStealingPool::wait ()
+{
+        std::unique_lock lock (_mutex);
+        _all_done.wait (lock, [this] ()
+        { return _pending.load () == 0; });
+        if (_exception)
+                {
+                        std::rethrow_exception (std::exchange (_exception, nullptr));
+                }
+}
+
+size_t WorkStealingPool::num_threads () const
+{
+        return _threads.size ();
+}
+
+void WorkStealingPool::run (size_t worker)
+{
+        current_pool = this;
+        current_worker = worker;
+        while (true)
+                {
+                        Task task;
+                        if (try_pop (worker, task) || try_steal (worker, task))
+                                {
+                                        try
+                                                {
+                                                        task (worker);
+                                                }
+                                        catch (...)
+                                                {
+                                                        std::lock_guard lock (_mutex);
+                                                        if (!_exception)
+                                                                {
+                                                                        _exception = std::current_exception ();
+                                                                }
+                                                }
+                                        if (_pending.fetch_sub (1) == 1)
+                                                {
+                                                        std::lock_guard lock (_mutex);
+                                                        _all_done.notify_all ();
+                                                }
+                                        continue;
+                                }
+                        std::unique_lock lock (_mutex);
+                        _work_available.wait (lock, [this] ()
+                        { return _stop || _queued.load () > 0; });
+                        if (_queued.load () == 0)
+                                {
+                                        // stopped and no tasks are left
+                                        return;
+                                }
+                }
+}
+
+bool WorkStealingPool::try_pop (size_t worker, Task &task)
+{
+        auto &queue = *_queues[worker];
+        {
+                std::lock_guard lock (queue.mutex);
+                if (queue.tasks.empty ())
+                        {
+                                return false;
+                        }
+                task = std::move (queue.tasks.back ());
+                queue.tasks.pop_back ();
+        }
+        _queued.fetch_sub (1);
+        return true;
+}
+
+bool WorkStealingPool::try_steal (size_t worker, Task &task)
+{
+        for (size_t i = 1; i < _queues.size (); ++i)
+                {
+                        auto &queue = *_queues[(worker + i) % _queues.size ()];
+                        {
+                                std::lock_guard lock (queue.mutex);
+                                if (queue.tasks.empty ())
+                                        {
+                                                continue;
+                                        }
+                                task = std::move (queue.tasks.front ());
+                                queue.tasks.pop_front ();
+                        }
+                        _queued.fetch_sub (1);
+                        return true;
+                }
+        return false;
+}
@@ -0,0 +1,29 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <ac/utils/word_boundary.h>
+
+WordBoundary::WordBoundary (std::string_view word_chars) : _enabled (true)
+{
+        if (word_chars.empty ())
+                {
+                        word_chars = DEFAULT_WORD_CHARS;
+                }
+        for (char c : word_chars)
+                {
+                        _word[static_cast<unsigned char>(c)] = true;
+                }
+}
+
+size_t WordBoundary::next_start (std::string_view input, size_t pos) const
+{
+        while (pos < input.size () && is_word (input[pos]))
+                {
+                        ++pos;
+                }
+        return pos < input.size () ? pos + 1 : input.size ();
+}
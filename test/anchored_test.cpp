@@ -0,0 +1,104 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+
+#include "reference.h"
+
+namespace {
+
+/// Get the shortest or the longest pattern starting at input[0], the lowest pattern ID among equally long ones
+std::optional<Match> prefix_match (const PatternSet &patterns, std::string_view input, bool ignore_case,
+                                   bool shortest)
+{
+        std::optional<Match> best;
+        for (PatternID id = 0; id < patterns.size (); ++id)
+                {
+                        size_t len = patterns[id].size ();
+                        if (!reference::equal_at (input, 0, patterns[id], ignore_case))
+                                {
+                                        continue;
+                                }
+                        if (!best || (shortest ? len < best->end : len > best->end))
+                                {
+                                        best = Match{id, 0, len};
+                                }
+                }
+        return best;
+}
+
+}  // namespace
+
+TEST (AnchoredTest, MatchesReference)
+{
+        std::mt19937 rng (35);
+        const AutomatonType types[] = {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::LAZY_DFA,
+                                       AutomatonType::AUTO};
+        for (int round = 0; round < 240; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        AutomatonType type = types[round / 3 % 4];
+                        bool ignore_case = round % 2 == 1;
+                        PatternSet patterns (reference::random_patterns (rng, 1 + rng () % 20, 6, "abAB"));
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type).match_kind (match_kind)
+                            .ascii_case_insensitive (ignore_case).build (patterns);
+                        for (int i = 0; i < 20; ++i)
+                                {
+                                        std::string input = reference::random_string (rng, rng () % 9, "abABx");
+                                        std::optional<Match> expected;
+                                        if (match_kind == MatchKind::STANDARD)
+                                                {
+                                                        expected = prefix_match (patterns, input, ignore_case, true);
+                                                }
+                                        else
+                                                {
+                                                        expected = reference::preferred_at (patterns, input, 0,
+                                                                                            match_kind, ignore_case,
+                                                                                            WordBoundary ());
+                                                }
+                                        EXPECT_EQ (searcher.find_anchored (input), expected)
+                                                                << type << " round " << round << " " << input;
+                                        if (match_kind == MatchKind::LEFTMOST_FIRST)
+                                                {
+                                                        // patterns shadowed by a prefix of a lower ID are not matched
+                                                        EXPECT_EQ (searcher.longest_prefix (input), expected);
+                                                        continue;
+                                                }
+                                        EXPECT_EQ (searcher.longest_prefix (input),
+                                                   prefix_match (patterns, input, ignore_case, false))
+                                                                << type << " round " << round << " " << input;
+                                }
+                }
+}
+
+TEST (AnchoredTest, OnlyMatchesAtTheStart)
+{
+        auto searcher = AhoCorasickBuilder ().build (PatternSet{"/api", "/api/users", "users"});
+        EXPECT_EQ (searcher.find_anchored ("/api/users/7"), (Match{0, 0, 4}));
+        EXPECT_EQ (searcher.longest_prefix ("/api/users/7"), (Match{1, 0, 10}));
+        EXPECT_EQ (searcher.longest_prefix ("/ap"), std::nullopt);
+        EXPECT_EQ (searcher.find_anchored ("x/api/users"), std::nullopt);
+        EXPECT_EQ (searcher.longest_prefix ("x/api/users"), std::nullopt);
+        EXPECT_EQ (searcher.longest_prefix (""), std::nullopt);
+}
+
+TEST (AnchoredTest, EmptyPattern)
+{
+        auto searcher = AhoCorasickBuilder ().build (PatternSet{"", "ab"});
+        EXPECT_EQ (searcher.find_anchored ("xab"), (Match{0, 0, 0}));
+        EXPECT_EQ (searcher.longest_prefix ("abc"), (Match{1, 0, 2}));
+        EXPECT_EQ (searcher.longest_prefix ("b"), (Match{0, 0, 0}));
+}
+
+TEST (AnchoredTest, RejectsLongPatterns)
+{
+        auto searcher = AhoCorasickBuilder ().long_pattern_threshold (4).build (PatternSet{"abcdefgh"});
+        EXPECT_THROW (static_cast<void> (searcher.find_anchored ("abcdefgh")), std::invalid_argument);
+        EXPECT_THROW (static_cast<void> (searcher.longest_prefix ("abcdefgh")), std::invalid_argument);
+}
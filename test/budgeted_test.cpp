@@ -0,0 +1,130 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+
+#include "reference.h"
+
+namespace {
+
+const AutomatonType TYPES[] = {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::LAZY_DFA};
+
+/**
+ * @brief Search input by calls of find_budgeted with budget until the cursor is done, checking that every call makes
+ *  progress.
+ */
+template<typename Searcher>
+std::vector<Match> find_in_calls (const Searcher &searcher, std::string_view input, const SearchBudget &budget,
+                                  GroupMask groups = ALL_GROUPS)
+{
+        std::vector<Match> matches;
+        SearchCursor cursor;
+        for (size_t calls = 0; !cursor.done (); ++calls)
+                {
+                        if (calls > input.size () + 1)
+                                {
+                                        ADD_FAILURE () << "no progress at " << cursor.offset ();
+                                        break;
+                                }
+                        size_t offset = cursor.offset ();
+                        auto found = searcher.find_budgeted (input, cursor, budget, groups);
+                        matches.insert (matches.end (), found.begin (), found.end ());
+                        EXPECT_TRUE (cursor.offset () > offset || cursor.done ()) << offset;
+                        EXPECT_LE (cursor.offset (), input.size ());
+                }
+        return matches;
+}
+
+template<typename Searcher>
+std::vector<Match> for_each_match (const Searcher &searcher, std::string_view input, GroupMask groups = ALL_GROUPS)
+{
+        std::vector<Match> matches;
+        searcher.for_each_match (input, [&matches] (const Match &match)
+        {
+          matches.push_back (match);
+        }, groups);
+        return matches;
+}
+
+}  // namespace
+
+TEST (BudgetedTest, CallsReportTheMatchesOfForEachMatch)
+{
+        std::mt19937 rng (46);
+        for (int round = 0; round < 180; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        AutomatonType type = TYPES[round / 3 % 3];
+                        bool whole_words = round % 4 == 1;
+                        GroupMask groups = round % 5 == 2 ? GroupMask{1} << (rng () % 3) : ALL_GROUPS;
+                        PatternSet patterns;
+                        for (const auto &pattern : reference::random_patterns (rng, 1 + rng () % 20, 6, "ab"))
+                                {
+                                        patterns.add (pattern, rng () % 3);
+                                }
+                        std::string input = reference::random_string (rng, 300, "ab ");
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type).match_kind (match_kind)
+                            .whole_words (whole_words).build (patterns);
+                        auto expected = for_each_match (searcher, input, groups);
+                        for (size_t max_bytes : {size_t{0}, size_t{1}, size_t{5}, size_t{37}, size_t{1000}})
+                                {
+                                        SearchBudget budget;
+                                        budget.max_bytes = max_bytes;
+                                        EXPECT_EQ (find_in_calls (searcher, input, budget, groups), expected)
+                                                                << type << " round " << round << " max " << max_bytes;
+                                }
+                }
+}
+
+TEST (BudgetedTest, LongMatchesSpanCalls)
+{
+        // a leftmost match that is longer than the budget must neither be cut nor reported twice
+        for (auto match_kind : {MatchKind::STANDARD, MatchKind::LEFTMOST_FIRST, MatchKind::LEFTMOST_LONGEST})
+                {
+                        auto searcher = AhoCorasickBuilder ().match_kind (match_kind)
+                            .build (PatternSet{"a", "aaaaaaaaaaaaaaaaaaab", "b"});
+                        std::string input = "aaaaaaaaaaaaaaaaaaab aaaaaaaaaaaaaaaaaaab";
+                        SearchBudget budget;
+                        budget.max_bytes = 3;
+                        EXPECT_EQ (find_in_calls (searcher, input, budget), for_each_match (searcher, input))
+                                                << match_kind;
+                }
+}
+
+TEST (BudgetedTest, ProgressesAfterTheDeadline)
+{
+        std::mt19937 rng (460);
+        PatternSet patterns (reference::random_patterns (rng, 20, 5, "abc"));
+        std::string input = reference::random_string (rng, 2000, "abcd");
+        SearchBudget budget;
+        budget.deadline = std::chrono::steady_clock::time_point::min ();
+        for (auto match_kind : {MatchKind::STANDARD, MatchKind::LEFTMOST_FIRST, MatchKind::LEFTMOST_LONGEST})
+                {
+                        auto searcher = AhoCorasickBuilder ().match_kind (match_kind).build (patterns);
+                        EXPECT_EQ (find_in_calls (searcher, input, budget), for_each_match (searcher, input))
+                                                << match_kind;
+                }
+}
+
+TEST (BudgetedTest, UnlimitedBudgetSearchesAtOnce)
+{
+        auto searcher = AhoCorasickBuilder ().build (PatternSet{"", "ab"});
+        SearchCursor cursor;
+        auto matches = searcher.find_budgeted ("xab", cursor, SearchBudget{});
+        EXPECT_TRUE (cursor.done ());
+        EXPECT_EQ (cursor.offset (), 3u);
+        EXPECT_EQ (std::vector<Match> (matches.begin (), matches.end ()), for_each_match (searcher, "xab"));
+        // a done cursor finds nothing
+        EXPECT_TRUE (searcher.find_budgeted ("xab", cursor, SearchBudget{}).empty ());
+
+        SearchCursor empty;
+        matches = searcher.find_budgeted ("", empty, SearchBudget{});
+        EXPECT_TRUE (empty.done ());
+        EXPECT_EQ (std::vector<Match> (matches.begin (), matches.end ()), (std::vector<Match>{{0, 0, 0}}));
+}
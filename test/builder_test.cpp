@@ -0,0 +1,105 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+
+#include "reference.h"
+
+TEST (PatternSetTest, StoresPatternsOfAnyRange)
+{
+        std::vector<std::string> strings{"he", "", "hers"};
+        const char *c_strings[] = {"he", "", "hers"};
+        std::vector<std::string_view> views (strings.begin (), strings.end ());
+        for (const PatternSet &patterns : {PatternSet (strings), PatternSet (c_strings), PatternSet (views)})
+                {
+                        ASSERT_EQ (patterns.size (), 3u);
+                        EXPECT_EQ (patterns[0], "he");
+                        EXPECT_EQ (patterns[1], "");
+                        EXPECT_EQ (patterns[2], "hers");
+                        EXPECT_EQ (patterns.total_len (), 6u);
+                        EXPECT_EQ (std::vector<std::string> (patterns.begin (), patterns.end ()), strings);
+                        EXPECT_FALSE (patterns.has_groups ());
+                }
+        PatternSet grouped;
+        grouped.add ("a");
+        grouped.add ("b", 3);
+        EXPECT_TRUE (grouped.has_groups ());
+        EXPECT_EQ (grouped.group (0), 0);
+        EXPECT_EQ (grouped.group (1), 3);
+}
+
+TEST (BuilderTest, StoresOptionsInConfig)
+{
+        auto builder = AhoCorasickBuilder ().match_kind (MatchKind::LEFTMOST_LONGEST).ascii_case_insensitive (true)
+            .automaton_type (AutomatonType::CONTIGUOUS_NFA).memory_budget (1000).prefilter (false).byte_classes (false)
+            .dfa_state_limit (10).memory_limit (2000).build_threads (3);
+        const BuildConfig &config = builder.config ();
+        EXPECT_EQ (config.match_kind, MatchKind::LEFTMOST_LONGEST);
+        EXPECT_TRUE (config.ascii_case_insensitive);
+        EXPECT_EQ (config.automaton_type, AutomatonType::CONTIGUOUS_NFA);
+        EXPECT_EQ (config.memory_budget, 1000u);
+        EXPECT_FALSE (config.prefilter);
+        EXPECT_FALSE (config.byte_classes);
+        EXPECT_EQ (config.dfa_state_limit, 10u);
+        EXPECT_EQ (config.memory_limit, 2000u);
+        EXPECT_EQ (config.build_threads, 3u);
+}
+
+TEST (BuilderTest, MemoryLimitFailsTheBuild)
+{
+        std::mt19937 rng (28);
+        PatternSet patterns (reference::random_patterns (rng, 1000, 10, "abcdefghijklmnopqrstuvwxyz"));
+        for (AutomatonType type : {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::AUTO})
+                {
+                        EXPECT_THROW (AhoCorasickBuilder ().automaton_type (type).memory_limit (4096).build (patterns),
+                                      std::length_error) << type;
+                        EXPECT_NO_THROW (AhoCorasickBuilder ().automaton_type (type).memory_limit (64 << 20)
+                                             .build (patterns)) << type;
+                }
+        // the engines check the limit while building as well, not only the estimate of Dynamic
+        BuildConfig config;
+        config.memory_limit = 4096;
+        EXPECT_THROW (automaton::NFA (patterns, config), std::length_error);
+        EXPECT_THROW (automaton::ContiguousNFA (patterns, config), std::length_error);
+}
+
+TEST (BuilderTest, PrefilterAndByteClassesDoNotChangeMatches)
+{
+        std::mt19937 rng (280);
+        for (int round = 0; round < 40; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        // few start bytes within a larger alphabet, so that the prefilter is enabled
+                        size_t count = 1 + rng () % 10;
+                        PatternSet patterns (reference::random_patterns (rng, count, round < 20 ? 4 : 12, "xyz"));
+                        std::string input = reference::random_string (rng, 2000, "abcdefghijklmnopqrstuvwxyz");
+                        auto expected = reference::find_all (patterns, input, match_kind);
+                        for (int options = 0; options < 4; ++options)
+                                {
+                                        auto searcher = AhoCorasickBuilder ().match_kind (match_kind)
+                                            .automaton_type (AutomatonType::CONTIGUOUS_NFA).prefilter (options & 1)
+                                            .byte_classes (options & 2).build (patterns);
+                                        EXPECT_EQ (reference::normalized (searcher.find_matches (input), match_kind),
+                                                   expected) << "round " << round << " options " << options;
+                                }
+                }
+}
+
+TEST (PrefilterTest, FindsCandidates)
+{
+        Prefilter prefilter (PatternSet{"foo", "bar"}, false);
+        ASSERT_TRUE (prefilter.enabled ());
+        std::string_view input = "xxxxbxxfoo";
+        EXPECT_EQ (prefilter.find_candidate (input, 0), 4u);
+        EXPECT_EQ (prefilter.find_candidate (input, 5), 7u);
+        EXPECT_EQ (Prefilter (PatternSet{"FOO"}, true).find_candidate ("xxfoo", 0), 2u);
+        EXPECT_EQ (prefilter.find_candidate ("xxxx", 0), 4u);
+        // an empty pattern matches everywhere
+        EXPECT_FALSE (Prefilter (PatternSet{"foo", ""}, false).enabled ());
+}
@@ -0,0 +1,103 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+
+#include "reference.h"
+
+namespace {
+
+std::vector<Match> search (const automaton::ContiguousNFA &nfa, MatchKind match_kind, std::string_view input)
+{
+        std::vector<Match> matches;
+        auto collect = [&matches] (const Match &match)
+        {
+          matches.push_back (match);
+        };
+        detail::for_each_match (nfa, Prefilter (), WordBoundary (), match_kind, input, collect);
+        return reference::normalized (matches, match_kind);
+}
+
+}  // namespace
+
+TEST (ContiguousNFATest, MatchesReference)
+{
+        std::mt19937 rng (26);
+        for (MatchKind match_kind : {MatchKind::STANDARD, MatchKind::LEFTMOST_FIRST, MatchKind::LEFTMOST_LONGEST})
+                {
+                        for (int round = 0; round < 100; ++round)
+                                {
+                                        bool ignore_case = round % 2 == 1;
+                                        size_t count = 1 + rng () % 20;
+                                        PatternSet patterns (reference::random_patterns (rng, count, 6, "abcAB"));
+                                        std::string input = reference::random_string (rng, 300, "abcABx");
+                                        automaton::ContiguousNFA nfa (patterns, match_kind, ignore_case);
+                                        EXPECT_EQ (search (nfa, match_kind, input),
+                                                   reference::find_all (patterns, input, match_kind, ignore_case))
+                                                                << "round " << round;
+                                }
+                }
+}
+
+TEST (ContiguousNFATest, DenseDepthDoesNotChangeMatches)
+{
+        std::mt19937 rng (260);
+        PatternSet patterns (reference::random_patterns (rng, 200, 8, "abcd"));
+        std::string input = reference::random_string (rng, 2000, "abcde");
+        auto expected = reference::find_all (patterns, input, MatchKind::STANDARD);
+        for (size_t dense_depth : {0, 1, 2, 3, 8})
+                {
+                        automaton::ContiguousNFA nfa (patterns, MatchKind::STANDARD, false, dense_depth);
+                        EXPECT_EQ (search (nfa, MatchKind::STANDARD, input), expected) << "dense_depth " << dense_depth;
+                }
+}
+
+TEST (ContiguousNFATest, NonAsciiPatterns)
+{
+        // unlike the NFA, the ContiguousNFA takes any byte
+        PatternSet patterns{"\xc3\xa9t\xc3\xa9", "\xff\xfe", "t\xc3"};
+        std::string input = "un \xc3\xa9t\xc3\xa9 \xff\xfe\xff\xfe";
+        for (bool byte_classes : {true, false})
+                {
+                        BuildConfig config;
+                        config.byte_classes = byte_classes;
+                        automaton::ContiguousNFA nfa (patterns, config);
+                        EXPECT_EQ (search (nfa, MatchKind::STANDARD, input),
+                                   reference::find_all (patterns, input, MatchKind::STANDARD));
+                }
+        EXPECT_THROW (automaton::NFA (patterns, MatchKind::STANDARD, false), std::invalid_argument);
+}
+
+TEST (ContiguousNFATest, SparseStatesTakeLessThanDenseRows)
+{
+        std::mt19937 rng (2600);
+        PatternSet patterns (reference::random_patterns (rng, 5000, 12, "abcdefghijklmnopqrstuvwxyz"));
+        automaton::ContiguousNFA nfa (patterns, MatchKind::STANDARD, false);
+        // a dense row per state takes a word per code point of the alphabet, a sparse state a few words
+        EXPECT_LT (nfa.memory_usage (), nfa.num_states () * 27 * sizeof (uint32_t));
+}
+
+TEST (ContiguousNFATest, StateQueries)
+{
+        PatternSet patterns{"he", "she", "his", "hers"};
+        automaton::ContiguousNFA nfa (patterns, MatchKind::STANDARD, false);
+        auto state = nfa.start_state ();
+        for (char c : std::string_view ("she"))
+                {
+                        state = nfa.next_state (state, c);
+                }
+        ASSERT_TRUE (nfa.is_match (state));
+        auto matches = nfa.matches (state);
+        EXPECT_EQ (std::vector<PatternID> (matches.begin (), matches.end ()), (std::vector<PatternID>{1, 0}));
+        EXPECT_EQ (nfa.pattern_len (1), 3u);
+        EXPECT_FALSE (nfa.is_dead (state));
+        // a standard search never dies
+        EXPECT_FALSE (nfa.is_dead (nfa.next_state (state, 'x')));
+        EXPECT_TRUE (nfa.is_dead (nfa.next_state_anchored (nfa.start_state (), 'x')));
+}
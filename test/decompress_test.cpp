@@ -0,0 +1,258 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+#include <ac/utils/decompress.h>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(AC_WITH_ZLIB)
+#include <zlib.h>
+#endif
+#if defined(AC_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+#include "reference.h"
+
+namespace {
+
+/// A file in the temporary directory, removed on destruction
+class TempFile {
+ public:
+  explicit TempFile (std::string_view content)
+          : _path (std::filesystem::temp_directory_path ()
+                   / ("ac_decompress_test_" + std::to_string (reinterpret_cast<uintptr_t>(this))))
+  {
+          std::ofstream file (_path, std::ios::binary);
+          file.write (content.data (), static_cast<std::streamsize>(content.size ()));
+  }
+
+  TempFile (const TempFile &) = delete;
+  TempFile &operator= (const TempFile &) = delete;
+
+  ~TempFile ()
+  {
+          std::error_code error;
+          std::filesystem::remove (_path, error);
+  }
+
+  [[nodiscard]]
+  const std::filesystem::path &path () const
+  {
+          return _path;
+  }
+
+ private:
+  std::filesystem::path _path;
+};
+
+/// Read all chunks of reader, checking that none is empty or larger than buffer_size
+std::string read_all (DecompressingReader &reader, size_t buffer_size)
+{
+        std::string result;
+        while (auto chunk = reader.next ())
+                {
+                        EXPECT_FALSE (chunk->empty ());
+                        EXPECT_LE (chunk->size (), buffer_size);
+                        result.append (*chunk);
+                }
+        return result;
+}
+
+#if defined(AC_WITH_ZLIB)
+/// Compress data into a single gzip member
+std::string gzip (std::string_view data, int level = Z_DEFAULT_COMPRESSION)
+{
+        z_stream stream{};
+        // 15 + 16: maximum window size, gzip header
+        EXPECT_EQ (deflateInit2 (&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY), Z_OK);
+        std::string result (deflateBound (&stream, data.size ()) + 32, '\0');
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data ()));
+        stream.avail_in = static_cast<uInt>(data.size ());
+        stream.next_out = reinterpret_cast<Bytef *>(result.data ());
+        stream.avail_out = static_cast<uInt>(result.size ());
+        EXPECT_EQ (deflate (&stream, Z_FINISH), Z_STREAM_END);
+        result.resize (stream.total_out);
+        deflateEnd (&stream);
+        return result;
+}
+#endif
+
+#if defined(AC_WITH_ZSTD)
+/// Compress data into a single zstd frame
+std::string zstd (std::string_view data)
+{
+        std::string result (ZSTD_compressBound (data.size ()), '\0');
+        size_t size = ZSTD_compress (result.data (), result.size (), data.data (), data.size (), 3);
+        EXPECT_FALSE (ZSTD_isError (size));
+        result.resize (size);
+        return result;
+}
+#endif
+
+/// Check that content compressed as compressed is read and searched like content, for several buffer sizes
+void expect_decompressed (std::string_view compressed, const std::string &content, Compression compression)
+{
+        std::mt19937 rng (45);
+        PatternSet patterns (reference::random_patterns (rng, 20, 5, "abc"));
+        auto searcher = AhoCorasickBuilder ().build (patterns);
+        TempFile file (compressed);
+        for (size_t buffer_size : {997, 1 << 16, 1 << 20})
+                {
+                        DecompressingReader reader (file.path (), buffer_size, 2);
+                        EXPECT_EQ (reader.compression (), compression);
+                        EXPECT_EQ (read_all (reader, buffer_size), content) << buffer_size;
+
+                        DecompressingReader search_reader (file.path (), buffer_size, 3);
+                        std::vector<Match> matches;
+                        for (const auto &match : searcher.find_iter_chunks (search_reader.chunks ()))
+                                {
+                                        matches.push_back (match);
+                                }
+                        EXPECT_EQ (reference::normalized (matches, MatchKind::STANDARD),
+                                   reference::find_all (patterns, content, MatchKind::STANDARD)) << buffer_size;
+                }
+}
+
+/// Check that reading compressed throws, but only after some of the data before the error was read
+void expect_error_after_data (std::string_view compressed, std::string_view content)
+{
+        TempFile file (compressed);
+        DecompressingReader reader (file.path (), 100, 2);
+        std::string read;
+        EXPECT_THROW (while (auto chunk = reader.next ()) { read.append (*chunk); }, std::runtime_error);
+        EXPECT_FALSE (read.empty ());
+        EXPECT_EQ (read, content.substr (0, read.size ()));
+}
+
+}  // namespace
+
+TEST (DecompressTest, DetectsCompression)
+{
+        EXPECT_EQ (detect_compression ("\x1f\x8b\x08\x00"), Compression::GZIP);
+        EXPECT_EQ (detect_compression ("\x28\xb5\x2f\xfd"), Compression::ZSTD);
+        EXPECT_EQ (detect_compression ("\x28\xb5\x2f"), Compression::NONE);
+        EXPECT_EQ (detect_compression ("abcd"), Compression::NONE);
+        EXPECT_EQ (detect_compression (""), Compression::NONE);
+        EXPECT_TRUE (compression_supported (Compression::NONE));
+}
+
+TEST (DecompressTest, ReadsUncompressedFiles)
+{
+        std::mt19937 rng (450);
+        expect_decompressed ("", "", Compression::NONE);
+        expect_decompressed ("a", "a", Compression::NONE);
+        std::string content = reference::random_string (rng, 100000, "abcd\n");
+        expect_decompressed (content, content, Compression::NONE);
+}
+
+TEST (DecompressTest, ThrowsOnMissingFilesAndUnsupportedCompression)
+{
+        EXPECT_THROW (DecompressingReader ("/nonexistent/ac_decompress_test"), std::runtime_error);
+        for (auto [head, compression] : {std::pair ("\x1f\x8b\x08\x00", Compression::GZIP),
+                                         std::pair ("\x28\xb5\x2f\xfd", Compression::ZSTD)})
+                {
+                        if (!compression_supported (compression))
+                                {
+                                        TempFile file (head);
+                                        EXPECT_THROW (DecompressingReader (file.path ()), std::runtime_error);
+                                }
+                }
+}
+
+TEST (DecompressTest, StopsWhenDestroyedEarly)
+{
+        std::mt19937 rng (4500);
+        std::string content = reference::random_string (rng, 100000, "abcd");
+        TempFile file (content);
+        DecompressingReader reader (file.path (), 10, 2);
+        auto chunk = reader.next ();
+        ASSERT_TRUE (chunk.has_value ());
+        EXPECT_EQ (*chunk, content.substr (0, 10));
+        // the destructor must not wait for the remaining buffers to be taken
+}
+
+#if defined(AC_WITH_ZLIB)
+TEST (DecompressTest, ReadsGzipMembers)
+{
+        // more compressed data than is read from the file at once
+        std::mt19937 rng (451);
+        std::string first = reference::random_string (rng, 600000, "abcdefghijklmnopqrstuvwxyz\n");
+        std::string second = reference::random_string (rng, 1000, "abc");
+        expect_decompressed (gzip (first), first, Compression::GZIP);
+        expect_decompressed (gzip (first) + gzip ("") + gzip (second), first + second, Compression::GZIP);
+}
+
+TEST (DecompressTest, IgnoresDataAfterTheLastGzipMember)
+{
+        std::mt19937 rng (4511);
+        std::string content = reference::random_string (rng, 300000, "abcdefghijklmnopqrstuvwxyz\n");
+        std::string compressed = gzip (content);
+        // zero padding to a multiple of the tar record size
+        std::string padded = compressed + std::string (10240 - compressed.size () % 10240, '\0');
+        expect_decompressed (padded, content, Compression::GZIP);
+        expect_decompressed (compressed + gzip (content) + std::string (1000, '\0'), content + content,
+                             Compression::GZIP);
+        expect_decompressed (compressed + "\x1f", content, Compression::GZIP);
+}
+
+TEST (DecompressTest, ReadsGzipMemberStartingAtTheEndOfAnInputBlock)
+{
+        // DecompressingReader reads 2^18 compressed bytes at once. Stored (level 0) members are a little longer than
+        //  their content, so one whose first magic byte ends the first block is found by trying content sizes.
+        const size_t block_size = size_t{1} << 18;
+        std::mt19937 rng (4512);
+        std::string content = reference::random_string (rng, block_size, "abcdefghijklmnopqrstuvwxyz\n");
+        std::string second = reference::random_string (rng, 1000, "abc");
+        for (size_t size = block_size - 100; size < block_size; ++size)
+                {
+                        std::string first = content.substr (0, size);
+                        std::string compressed = gzip (first, 0);
+                        if (compressed.size () == block_size - 1)
+                                {
+                                        expect_decompressed (compressed + gzip (second), first + second,
+                                                             Compression::GZIP);
+                                        return;
+                                }
+                }
+        GTEST_SKIP () << "no stored member of the required size";
+}
+
+TEST (DecompressTest, RethrowsGzipErrorsAfterData)
+{
+        std::mt19937 rng (4510);
+        std::string content = reference::random_string (rng, 300000, "abcdefghijklmnopqrstuvwxyz");
+        std::string compressed = gzip (content);
+        expect_error_after_data (compressed.substr (0, compressed.size () - 100), content);
+        // a valid member followed by garbage
+        expect_error_after_data (compressed + "\x1f\x8b garbage", content);
+}
+#endif
+
+#if defined(AC_WITH_ZSTD)
+TEST (DecompressTest, ReadsZstdFrames)
+{
+        std::mt19937 rng (452);
+        std::string first = reference::random_string (rng, 600000, "abcdefghijklmnopqrstuvwxyz\n");
+        std::string second = reference::random_string (rng, 1000, "abc");
+        expect_decompressed (zstd (first), first, Compression::ZSTD);
+        expect_decompressed (zstd (first) + zstd (second), first + second, Compression::ZSTD);
+}
+
+TEST (DecompressTest, RethrowsZstdErrorsAfterData)
+{
+        std::mt19937 rng (4520);
+        std::string content = reference::random_string (rng, 300000, "abcdefghijklmnopqrstuvwxyz");
+        std::string compressed = zstd (content);
+        expect_error_after_data (compressed.substr (0, compressed.size () - 100), content);
+}
+#endif
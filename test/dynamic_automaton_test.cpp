@@ -0,0 +1,98 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+
+#include "reference.h"
+
+namespace {
+
+void expect_reference_matches (AutomatonType type, MatchKind match_kind, std::mt19937 &rng)
+{
+        for (int round = 0; round < 20; ++round)
+                {
+                        bool ignore_case = round % 2 == 1;
+                        size_t count = 1 + rng () % 30;
+                        PatternSet patterns (reference::random_patterns (rng, count, 5, "abcAB"));
+                        std::string input = reference::random_string (rng, 500, "abcABx");
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type).match_kind (match_kind)
+                            .ascii_case_insensitive (ignore_case).build (patterns);
+                        AutomatonType expected_type = type == AutomatonType::AUTO ? AutomatonType::NFA : type;
+                        EXPECT_EQ (searcher.automaton ().type (), expected_type);
+                        EXPECT_EQ (reference::normalized (searcher.find_matches (input), match_kind),
+                                   reference::find_all (patterns, input, match_kind, ignore_case))
+                                                << type << " round " << round;
+                }
+}
+
+}  // namespace
+
+TEST (DynamicTest, EnginesMatchReference)
+{
+        std::mt19937 rng (27);
+        for (AutomatonType type : {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::LAZY_DFA,
+                                   AutomatonType::AUTO})
+                {
+                        expect_reference_matches (type, MatchKind::STANDARD, rng);
+                        expect_reference_matches (type, MatchKind::LEFTMOST_FIRST, rng);
+                        expect_reference_matches (type, MatchKind::LEFTMOST_LONGEST, rng);
+                }
+}
+
+TEST (DynamicTest, AutoChoosesContiguousNFAForNonAsciiPatterns)
+{
+        auto searcher = AhoCorasickBuilder ().build (PatternSet{"caf\xc3\xa9", "tea"});
+        EXPECT_EQ (searcher.automaton ().type (), AutomatonType::CONTIGUOUS_NFA);
+        auto matches = searcher.find_matches ("un caf\xc3\xa9 ou un tea");
+        EXPECT_EQ (std::vector<Match> (matches.begin (), matches.end ()), (std::vector<Match>{{0, 3, 8}, {1, 15, 18}}));
+}
+
+TEST (DynamicTest, AutoChoosesContiguousNFAOverBudget)
+{
+        std::mt19937 rng (270);
+        PatternSet patterns (reference::random_patterns (rng, 2000, 10, "abcdefghijklmnopqrstuvwxyz"));
+        auto stats = automaton::analyze_patterns (patterns, false);
+        BuildConfig config;
+        config.memory_budget = automaton::estimate_nfa_size (stats, true) - 1;
+        EXPECT_EQ (automaton::select_automaton_type (stats, config), AutomatonType::CONTIGUOUS_NFA);
+        config.memory_budget = automaton::estimate_nfa_size (stats, true);
+        EXPECT_EQ (automaton::select_automaton_type (stats, config), AutomatonType::NFA);
+        auto searcher = AhoCorasickBuilder ().memory_budget (1024).build (patterns);
+        EXPECT_EQ (searcher.automaton ().type (), AutomatonType::CONTIGUOUS_NFA);
+}
+
+TEST (DynamicTest, AutoAccountsForDisabledByteClasses)
+{
+        std::mt19937 rng (440);
+        PatternSet patterns (reference::random_patterns (rng, 2000, 12, "ACGT"));
+        auto stats = automaton::analyze_patterns (patterns, false);
+        size_t limit = 2 * automaton::estimate_nfa_size (stats, true);
+        ASSERT_GT (automaton::estimate_nfa_size (stats, false), limit);
+        auto searcher = AhoCorasickBuilder ().byte_classes (false).memory_limit (limit).build (patterns);
+        EXPECT_EQ (searcher.automaton ().type (), AutomatonType::CONTIGUOUS_NFA);
+        EXPECT_EQ (AhoCorasickBuilder ().memory_limit (limit).build (patterns).automaton ().type (),
+                   AutomatonType::NFA);
+}
+
+TEST (DynamicTest, AnalyzePatterns)
+{
+        PatternSet patterns{"he", "she", "his", "hers", "he"};
+        auto stats = automaton::analyze_patterns (patterns, false);
+        EXPECT_EQ (stats.num_patterns, 5u);
+        EXPECT_EQ (stats.total_len, 14u);
+        EXPECT_EQ (stats.min_len, 2u);
+        EXPECT_EQ (stats.max_len, 4u);
+        // h, he, her, hers, hi, his, s, sh, she
+        EXPECT_EQ (stats.trie_size, 9u);
+        // hers, his, she
+        EXPECT_EQ (stats.trie_leaves, 3u);
+        EXPECT_TRUE (stats.ascii);
+        EXPECT_FALSE (stats.groups);
+        EXPECT_EQ (automaton::analyze_patterns (PatternSet{"HE", "he"}, true).trie_size, 2u);
+}
@@ -0,0 +1,150 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+
+#include "reference.h"
+
+namespace {
+
+/// Split input into chunks of lens[0], lens[1], ... bytes, starting over with lens[0] after the last one
+Generator<std::string_view> split (std::string_view input, std::vector<size_t> lens)
+{
+        size_t offset = 0;
+        for (size_t i = 0; offset < input.size (); ++i)
+                {
+                        size_t len = std::min (lens[i % lens.size ()], input.size () - offset);
+                        co_yield input.substr (offset, len);
+                        offset += len;
+                }
+}
+
+template<typename Matches>
+std::vector<Match> collect (Matches &&matches)
+{
+        std::vector<Match> result;
+        for (const auto &match : matches)
+                {
+                        result.push_back (match);
+                }
+        return result;
+}
+
+PatternSet random_grouped_patterns (std::mt19937 &rng, size_t count, size_t max_len, std::string_view alphabet)
+{
+        PatternSet patterns;
+        for (const auto &pattern : reference::random_patterns (rng, count, max_len, alphabet))
+                {
+                        patterns.add (pattern, rng () % 3);
+                }
+        return patterns;
+}
+
+}  // namespace
+
+TEST (FindIterTest, MatchesForEachMatch)
+{
+        std::mt19937 rng (32);
+        for (int round = 0; round < 90; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        GroupMask groups = round % 2 == 0 ? ALL_GROUPS : GroupMask{1} << (rng () % 3);
+                        bool whole_words = round % 3 == 0;
+                        PatternSet patterns = random_grouped_patterns (rng, 1 + rng () % 15, 4, "ab");
+                        std::string input = reference::random_string (rng, 300, "ab ");
+                        auto searcher = AhoCorasickBuilder ().match_kind (match_kind).whole_words (whole_words)
+                            .build (patterns);
+                        EXPECT_EQ (collect (searcher.find_iter (input)), collect (searcher.find_matches (input)))
+                                                << "round " << round;
+                        std::vector<Match> in_groups;
+                        searcher.for_each_match (input, [&in_groups] (const Match &match)
+                        {
+                          in_groups.push_back (match);
+                        }, groups);
+                        EXPECT_EQ (collect (searcher.find_iter (input, groups)), in_groups) << "round " << round;
+                }
+}
+
+TEST (FindIterTest, StopsEarly)
+{
+        auto searcher = AhoCorasickBuilder ().build (PatternSet{"a"});
+        std::string input (1000, 'a');
+        size_t count = 0;
+        for (const auto &match : searcher.find_iter (input))
+                {
+                        EXPECT_EQ (match.start, count);
+                        if (++count == 3)
+                                {
+                                        break;
+                                }
+                }
+        EXPECT_EQ (count, 3u);
+}
+
+TEST (FindIterTest, EmptyPatternsAndInputs)
+{
+        auto searcher = AhoCorasickBuilder ().build (PatternSet{"", "a"});
+        EXPECT_EQ (collect (searcher.find_iter ("")), (std::vector<Match>{{0, 0, 0}}));
+        std::vector<Match> expected{{0, 0, 0}, {1, 0, 1}, {0, 1, 1}};
+        EXPECT_EQ (reference::normalized (collect (searcher.find_iter ("a")), MatchKind::STANDARD), expected);
+        EXPECT_EQ (reference::normalized (collect (searcher.find_iter_chunks (split ("a", {1}))), MatchKind::STANDARD),
+                   expected);
+}
+
+TEST (FindIterTest, ChunksMatchWholeInput)
+{
+        std::mt19937 rng (320);
+        for (int round = 0; round < 150; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        GroupMask groups = round % 2 == 0 ? ALL_GROUPS : GroupMask{1} << (rng () % 3);
+                        PatternSet patterns = random_grouped_patterns (rng, 1 + rng () % 15, 7, "abc");
+                        std::string input = reference::random_string (rng, 400, "abcd");
+                        std::vector<size_t> lens;
+                        for (int i = 0; i < 5; ++i)
+                                {
+                                        lens.push_back (1 + rng () % 9);
+                                }
+                        auto searcher = AhoCorasickBuilder ().match_kind (match_kind).build (patterns);
+                        EXPECT_EQ (collect (searcher.find_iter_chunks (split (input, lens), groups)),
+                                   collect (searcher.find_iter (input, groups))) << "round " << round;
+                        EXPECT_EQ (reference::normalized (collect (searcher.find_iter (input)), match_kind),
+                                   reference::find_all (patterns, input, match_kind)) << "round " << round;
+                }
+}
+
+TEST (FindIterTest, ChunksRejectWholeWords)
+{
+        auto searcher = AhoCorasickBuilder ().whole_words (true).build (PatternSet{"a"});
+        EXPECT_THROW (searcher.find_iter_chunks (split ("a a", {1})), std::invalid_argument);
+}
+
+TEST (FindIterTest, ChunksWithShiftedWindow)
+{
+        // patterns of at least Prefilter::MIN_WINDOW bytes, so that the prefilter shifts a window over the chunks
+        std::mt19937 rng (3200);
+        std::vector<std::string> words;
+        for (int i = 0; i < 20; ++i)
+                {
+                        words.push_back (reference::random_string (rng, 8 + rng () % 4, "abcdefghijklmnop"));
+                }
+        std::string input = reference::random_string (rng, 5000, "abcdefghijklmnop");
+        for (int i = 0; i < 50; ++i)
+                {
+                        input.insert (rng () % input.size (), words[rng () % words.size ()]);
+                }
+        for (auto match_kind : {MatchKind::STANDARD, MatchKind::LEFTMOST_FIRST, MatchKind::LEFTMOST_LONGEST})
+                {
+                        auto searcher = AhoCorasickBuilder ().match_kind (match_kind).build (words);
+                        auto expected = reference::find_all (words, input, match_kind);
+                        EXPECT_FALSE (expected.empty ());
+                        auto matches = collect (searcher.find_iter_chunks (split (input, {3, 17, 5})));
+                        EXPECT_EQ (reference::normalized (matches, match_kind), expected);
+                }
+}
@@ -0,0 +1,86 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+
+#include "reference.h"
+
+namespace {
+
+const AutomatonType TYPES[] = {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::LAZY_DFA};
+
+}  // namespace
+
+TEST (ForEachMatchTest, MatchesReference)
+{
+        std::mt19937 rng (36);
+        for (int round = 0; round < 90; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        AutomatonType type = TYPES[round / 3 % 3];
+                        PatternSet patterns (reference::random_patterns (rng, 1 + rng () % 20, 5, "abc"));
+                        std::string input = reference::random_string (rng, 400, "abcd");
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type).match_kind (match_kind)
+                            .build (patterns);
+                        std::vector<Match> matches;
+                        searcher.for_each_match (input, [&matches] (const Match &match)
+                        {
+                          matches.push_back (match);
+                        });
+                        EXPECT_EQ (reference::normalized (matches, match_kind),
+                                   reference::find_all (patterns, input, match_kind)) << type << " round " << round;
+                        auto all = searcher.find_matches (input);
+                        EXPECT_EQ (matches, std::vector<Match> (all.begin (), all.end ()))
+                                                << type << " round " << round;
+                }
+}
+
+TEST (ForEachMatchTest, StopsWhenCallbackReturnsFalse)
+{
+        std::mt19937 rng (360);
+        for (int round = 0; round < 120; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        AutomatonType type = TYPES[round / 3 % 3];
+                        bool whole_words = round % 4 == 1;
+                        size_t long_pattern_threshold = round % 4 == 3 ? 3 : 0;
+                        PatternSet patterns (reference::random_patterns (rng, 1 + rng () % 20, 5, "ab"));
+                        std::string input = reference::random_string (rng, 300, "ab ");
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type).match_kind (match_kind)
+                            .whole_words (whole_words).long_pattern_threshold (long_pattern_threshold)
+                            .build (patterns);
+                        auto all = searcher.find_matches (input);
+                        size_t limit = rng () % (all.size () + 2);
+                        std::vector<Match> matches;
+                        size_t calls = 0;
+                        searcher.for_each_match (input, [&] (const Match &match)
+                        {
+                          ++calls;
+                          matches.push_back (match);
+                          return matches.size () < limit;
+                        });
+                        size_t expected = std::min (std::max<size_t> (limit, 1), all.size ());
+                        EXPECT_EQ (calls, expected) << type << " round " << round;
+                        EXPECT_EQ (matches, std::vector<Match> (all.begin (), all.begin () + expected))
+                                                << type << " round " << round;
+                }
+}
+
+TEST (ForEachMatchTest, StopsAtTheStartState)
+{
+        // the matches of empty patterns are reported before the first byte is read
+        auto searcher = AhoCorasickBuilder ().build (PatternSet{"", "a"});
+        size_t calls = 0;
+        searcher.for_each_match ("aaa", [&calls] (const Match &match)
+        {
+          ++calls;
+          return false;
+        });
+        EXPECT_EQ (calls, 1u);
+}
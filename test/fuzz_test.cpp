@@ -0,0 +1,160 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+
+#include <cstdlib>
+#include <sstream>
+
+#include "reference.h"
+
+/*
+ * Differential fuzzing: random patterns, inputs and options are searched by every search method and compared with the
+ *  brute-force reference. The number of rounds and the seed can be set by the environment variables AC_FUZZ_ROUNDS and
+ *  AC_FUZZ_SEED, e.g. to fuzz for longer than the test suite does. A failing round prints its options and seed.
+ */
+
+namespace {
+
+size_t from_environment (const char *name, size_t fallback)
+{
+        const char *value = std::getenv (name);
+        return value != nullptr ? std::strtoull (value, nullptr, 10) : fallback;
+}
+
+/// Options of a round, drawn at random
+struct Round {
+  BuildConfig config;
+  GroupMask groups{ALL_GROUPS};
+  PatternSet patterns;
+  std::string input;
+
+  explicit Round (std::mt19937 &rng)
+  {
+          const AutomatonType types[] = {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::LAZY_DFA,
+                                         AutomatonType::AUTO};
+          config.automaton_type = types[rng () % 4];
+          config.match_kind = static_cast<MatchKind> (rng () % 3);
+          config.ascii_case_insensitive = rng () % 2 == 0;
+          config.byte_classes = rng () % 4 != 0;
+          config.prefilter = rng () % 2 == 0;
+          config.whole_words = rng () % 4 == 0;
+          config.word_chars = config.whole_words && rng () % 2 == 0 ? "ab" : "";
+          config.long_pattern_threshold = rng () % 4 == 0 ? 1 + rng () % 4 : 0;
+          config.dfa_cache_size = rng () % 4 == 0 ? 0 : config.dfa_cache_size;
+          // the NFA only supports ASCII patterns
+          const bool ascii = config.automaton_type == AutomatonType::NFA || rng () % 2 == 0;
+          const std::string alphabets[] = {"ab", "abc", "abAB", "abcdefgh", ascii ? "aB1 -" : "a\x80\xff B"};
+          const std::string &alphabet = alphabets[rng () % 5];
+          const bool grouped = rng () % 3 == 0;
+          for (const auto &pattern : reference::random_patterns (rng, 1 + rng () % 25, 1 + rng () % 10, alphabet))
+                  {
+                          patterns.add (pattern, grouped ? rng () % 3 : 0);
+                  }
+          if (rng () % 8 == 0)
+                  {
+                          patterns.add ("", grouped ? rng () % 3 : 0);
+                  }
+          if (grouped && rng () % 2 == 0)
+                  {
+                          groups = GroupMask{1} << (rng () % 3);
+                  }
+          // a few inputs longer than the segments of interleaved searches
+          const size_t len = rng () % 10 == 0 ? 9000 + rng () % 2000 : rng () % 400;
+          input = reference::random_string (rng, len, alphabet + "xA \n\x80");
+  }
+
+  [[nodiscard]]
+  std::string describe () const
+  {
+          std::ostringstream out;
+          out << "type " << config.automaton_type << ", kind " << config.match_kind << ", icase "
+              << config.ascii_case_insensitive << ", byte classes " << config.byte_classes << ", prefilter "
+              << config.prefilter << ", whole words " << config.whole_words << " (" << config.word_chars
+              << "), long threshold " << config.long_pattern_threshold << ", dfa cache " << config.dfa_cache_size
+              << ", groups " << groups << ", " << patterns.size () << " patterns, input of " << input.size ()
+              << " bytes";
+          return out.str ();
+  }
+};
+
+AhoCorasick<automaton::Dynamic> build (const BuildConfig &config, const PatternSet &patterns)
+{
+        return AhoCorasickBuilder ().automaton_type (config.automaton_type).match_kind (config.match_kind)
+            .ascii_case_insensitive (config.ascii_case_insensitive).byte_classes (config.byte_classes)
+            .prefilter (config.prefilter).whole_words (config.whole_words).word_chars (config.word_chars)
+            .long_pattern_threshold (config.long_pattern_threshold).dfa_cache_size (config.dfa_cache_size)
+            .build (patterns);
+}
+
+}  // namespace
+
+TEST (FuzzTest, SearchesMatchReference)
+{
+        const size_t seed = from_environment ("AC_FUZZ_SEED", 2026);
+        const size_t num_rounds = from_environment ("AC_FUZZ_ROUNDS", 2000);
+        std::mt19937 rng (seed);
+        for (size_t round = 0; round < num_rounds; ++round)
+                {
+                        Round r (rng);
+                        const auto &config = r.config;
+                        SCOPED_TRACE ("seed " + std::to_string (seed) + " round " + std::to_string (round) + ": "
+                                      + r.describe ());
+                        auto searcher = build (config, r.patterns);
+                        WordBoundary words = config.whole_words ? WordBoundary (config.word_chars) : WordBoundary ();
+                        auto expected = reference::find_all (r.patterns, r.input, config.match_kind,
+                                                             config.ascii_case_insensitive, words, r.groups);
+
+                        std::vector<Match> matches;
+                        searcher.for_each_match (r.input, [&matches] (const Match &match)
+                        {
+                          matches.push_back (match);
+                        }, r.groups);
+                        ASSERT_EQ (reference::normalized (matches, config.match_kind), expected);
+
+                        std::vector<Match> iterated;
+                        for (const auto &match : searcher.find_iter (r.input, r.groups))
+                                {
+                                        iterated.push_back (match);
+                                }
+                        EXPECT_EQ (iterated, matches);
+
+                        std::vector<Match> interleaved;
+                        searcher.for_each_match_interleaved (r.input, [&interleaved] (const Match &match)
+                        {
+                          interleaved.push_back (match);
+                        }, r.groups);
+                        EXPECT_EQ (interleaved, matches);
+
+                        std::vector<size_t> counts (r.patterns.size (), 0);
+                        for (const auto &match : expected)
+                                {
+                                        ++counts[match.pattern];
+                                }
+                        EXPECT_EQ (searcher.match_histogram (r.input, 2, r.groups), counts);
+
+                        SearchBudget budget;
+                        budget.max_bytes = rng () % 100;
+                        SearchCursor cursor;
+                        std::vector<Match> budgeted;
+                        for (size_t calls = 0; !cursor.done () && calls <= r.input.size () + 1; ++calls)
+                                {
+                                        auto found = searcher.find_budgeted (r.input, cursor, budget, r.groups);
+                                        budgeted.insert (budgeted.end (), found.begin (), found.end ());
+                                }
+                        EXPECT_TRUE (cursor.done ());
+                        EXPECT_EQ (budgeted, matches);
+
+                        ResultCache cache;
+                        for (int i = 0; i < 2; ++i)
+                                {
+                                        EXPECT_EQ (searcher.find_cached (r.input, cache, r.groups), matches);
+                                }
+                }
+}
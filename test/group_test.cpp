@@ -0,0 +1,127 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+
+#include "reference.h"
+
+namespace {
+
+template<typename automaton_type>
+void expect_pruned_to_groups (const automaton_type &automaton)
+{
+        // "abcd" of group 1 and "bc" of group 0
+        auto state = automaton.start_state ();
+        for (char c : std::string_view ("ab"))
+                {
+                        state = automaton.next_state (state, c);
+                }
+        EXPECT_EQ (automaton.reachable_groups (state), GroupMask{1} << 1);
+        EXPECT_EQ (automaton.prune (state, ALL_GROUPS), state);
+        EXPECT_EQ (automaton.prune (state, GroupMask{1} << 1), state);
+        auto pruned = automaton.prune (state, GroupMask{1});
+        EXPECT_NE ((automaton.reachable_groups (pruned) & GroupMask{1}), 0u);
+        // no match of group 0 is missed by continuing in the pruned state
+        auto next = automaton.next_state (pruned, 'c');
+        EXPECT_TRUE (automaton.is_match (next));
+        EXPECT_EQ (automaton.match_groups (next), GroupMask{1});
+}
+
+}  // namespace
+
+TEST (GroupTest, MatchesReference)
+{
+        std::mt19937 rng (37);
+        const AutomatonType types[] = {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::LAZY_DFA};
+        for (int round = 0; round < 180; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        AutomatonType type = types[round / 3 % 3];
+                        bool ignore_case = round % 2 == 1;
+                        PatternSet patterns;
+                        for (const auto &pattern : reference::random_patterns (rng, 1 + rng () % 20, 5, "abAB"))
+                                {
+                                        patterns.add (pattern, rng () % 4);
+                                }
+                        // bits of groups without patterns and empty masks as well
+                        GroupMask groups = round % 20 == 0 ? 0 : rng () % 64;
+                        std::string input = reference::random_string (rng, 400, "abABc");
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type).match_kind (match_kind)
+                            .ascii_case_insensitive (ignore_case).build (patterns);
+                        std::vector<Match> matches;
+                        searcher.for_each_match (input, [&matches] (const Match &match)
+                        {
+                          matches.push_back (match);
+                        }, groups);
+                        EXPECT_EQ (reference::normalized (matches, match_kind),
+                                   reference::find_all (patterns, input, match_kind, ignore_case, WordBoundary (),
+                                                        groups)) << type << " round " << round;
+                }
+}
+
+TEST (GroupTest, PrunesStatesOfOtherGroups)
+{
+        PatternSet patterns;
+        patterns.add ("abcd", 1);
+        patterns.add ("bc", 0);
+        expect_pruned_to_groups (automaton::NFA (patterns, MatchKind::STANDARD, false));
+        expect_pruned_to_groups (automaton::ContiguousNFA (patterns, MatchKind::STANDARD, false));
+        expect_pruned_to_groups (automaton::LazyDFA<automaton::NFA> (patterns, MatchKind::STANDARD, false));
+}
+
+TEST (GroupTest, LeftmostMatchesOfOtherGroupsAreDropped)
+{
+        // group masks filter the matches of the whole dictionary, they do not uncover the matches these overlap
+        PatternSet patterns;
+        patterns.add ("abcd", 1);
+        patterns.add ("cd", 0);
+        patterns.add ("ab", 0);
+        patterns.add ("AB", 2);
+        auto searcher = AhoCorasickBuilder ().match_kind (MatchKind::LEFTMOST_FIRST).ascii_case_insensitive (true)
+            .build (patterns);
+        std::vector<Match> matches;
+        auto collect = [&matches] (const Match &match)
+        {
+          matches.push_back (match);
+        };
+        searcher.for_each_match ("abcd", collect, GroupMask{1});
+        EXPECT_TRUE (matches.empty ());
+        // a pattern of groups that equals the matched one is reported instead
+        searcher.for_each_match ("ABxabcd", collect, GroupMask{1} << 2);
+        EXPECT_EQ (matches, (std::vector<Match>{{3, 0, 2}}));
+}
+
+TEST (GroupTest, EqualPatternOfGroupsIsReportedAfterAShadowingPrefix)
+{
+        // "" and "a" shadow "Abc", but "abc" is matched before them, so "Abc" is reported in its place
+        PatternSet patterns;
+        patterns.add ("abc", 1);
+        patterns.add ("", 1);
+        patterns.add ("b", 0);
+        patterns.add ("a", 1);
+        patterns.add ("Abc", 0);
+        for (AutomatonType type : {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::LAZY_DFA})
+                {
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type)
+                            .match_kind (MatchKind::LEFTMOST_FIRST).ascii_case_insensitive (true).build (patterns);
+                        std::vector<Match> matches;
+                        searcher.for_each_match ("xabc", [&matches] (const Match &match)
+                        {
+                          matches.push_back (match);
+                        }, GroupMask{1});
+                        EXPECT_EQ (matches, (std::vector<Match>{{4, 1, 4}})) << type;
+                }
+}
+
+TEST (GroupTest, RejectsGroupsOutOfRange)
+{
+        PatternSet patterns;
+        patterns.add ("a", MAX_GROUPS - 1);
+        EXPECT_THROW (patterns.add ("b", MAX_GROUPS), std::invalid_argument);
+}
@@ -0,0 +1,105 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+
+#include "reference.h"
+
+namespace {
+
+std::vector<size_t> histogram (const std::vector<Match> &matches, size_t num_patterns)
+{
+        std::vector<size_t> counts (num_patterns, 0);
+        for (const auto &match : matches)
+                {
+                        ++counts[match.pattern];
+                }
+        return counts;
+}
+
+}  // namespace
+
+TEST (HistogramTest, CountsMatchReference)
+{
+        std::mt19937 rng (41);
+        for (int round = 0; round < 90; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        bool whole_words = round % 4 == 1;
+                        GroupMask groups = round % 2 == 0 ? ALL_GROUPS : GroupMask{1} << 1;
+                        PatternSet patterns;
+                        for (const auto &pattern : reference::random_patterns (rng, 1 + rng () % 20, 4, "ab"))
+                                {
+                                        patterns.add (pattern, rng () % 2);
+                                }
+                        std::string input = reference::random_string (rng, 500, "ab ");
+                        auto searcher = AhoCorasickBuilder ().match_kind (match_kind).whole_words (whole_words)
+                            .build (patterns);
+                        WordBoundary words = whole_words ? WordBoundary ("") : WordBoundary ();
+                        auto expected = histogram (reference::find_all (patterns, input, match_kind, false, words,
+                                                                        groups), patterns.size ());
+                        EXPECT_EQ (searcher.match_histogram (input, 1, groups), expected) << "round " << round;
+                        // counts are accumulated
+                        std::vector<size_t> counts (patterns.size (), 1);
+                        searcher.count_matches (input, counts, groups);
+                        for (auto &count : counts)
+                                {
+                                        --count;
+                                }
+                        EXPECT_EQ (counts, expected) << "round " << round;
+                }
+}
+
+TEST (HistogramTest, SegmentsAddUp)
+{
+        std::mt19937 rng (410);
+        for (int round = 0; round < 20; ++round)
+                {
+                        bool whole_words = round % 2 == 1;
+                        PatternSet patterns (reference::random_patterns (rng, 1 + rng () % 20, 6, "ab"));
+                        patterns.add ("");
+                        std::string input = reference::random_string (rng, 300, "ab ");
+                        auto searcher = AhoCorasickBuilder ().whole_words (whole_words).build (patterns);
+                        std::vector<size_t> expected (patterns.size (), 0);
+                        searcher.count_matches (input, expected);
+                        std::vector<size_t> counts (patterns.size (), 0);
+                        size_t begin = 0;
+                        while (begin < input.size ())
+                                {
+                                        size_t end = std::min (input.size (), begin + 1 + rng () % 40);
+                                        searcher.count_segment_matches (input, begin, end, counts);
+                                        begin = end;
+                                }
+                        EXPECT_EQ (counts, expected) << "round " << round;
+                }
+}
+
+TEST (HistogramTest, ParallelHistogramEqualsSequential)
+{
+        std::mt19937 rng (4100);
+        PatternSet patterns (reference::random_patterns (rng, 500, 8, "abcd"));
+        const size_t segment_len = AhoCorasick<automaton::Dynamic>::MIN_PARALLEL_SEGMENT_LEN;
+        std::string input = reference::random_string (rng, 3 * segment_len, "abcde");
+        for (AutomatonType type : {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA})
+                {
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type).build (patterns);
+                        auto expected = searcher.match_histogram (input, 1);
+                        EXPECT_EQ (searcher.match_histogram (input, 4), expected) << type;
+                        EXPECT_EQ (searcher.match_histogram (input, 0), expected) << type;
+                }
+}
+
+TEST (HistogramTest, RejectsTooFewCounters)
+{
+        auto searcher = AhoCorasickBuilder ().build (PatternSet{"a", "b"});
+        std::vector<size_t> counts (1, 0);
+        EXPECT_THROW (searcher.count_matches ("ab", counts), std::invalid_argument);
+        auto leftmost = AhoCorasickBuilder ().match_kind (MatchKind::LEFTMOST_FIRST).build (PatternSet{"a"});
+        EXPECT_THROW (leftmost.count_segment_matches ("a", 0, 1, counts), std::invalid_argument);
+}
@@ -0,0 +1,96 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+
+#include "reference.h"
+
+namespace {
+
+template<typename Searcher>
+std::vector<Match> search (const Searcher &searcher, std::string_view input, GroupMask groups = ALL_GROUPS)
+{
+        std::vector<Match> matches;
+        searcher.for_each_match (input, [&matches] (const Match &match)
+        {
+          matches.push_back (match);
+        }, groups);
+        return matches;
+}
+
+template<size_t num_cursors, typename Searcher>
+std::vector<Match> search_interleaved (const Searcher &searcher, std::string_view input, GroupMask groups = ALL_GROUPS)
+{
+        std::vector<Match> matches;
+        searcher.template for_each_match_interleaved<num_cursors> (input, [&matches] (const Match &match)
+        {
+          matches.push_back (match);
+        }, groups);
+        return matches;
+}
+
+}  // namespace
+
+TEST (InterleavedTest, MatchesForEachMatch)
+{
+        std::mt19937 rng (40);
+        const AutomatonType types[] = {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::LAZY_DFA};
+        for (int round = 0; round < 36; ++round)
+                {
+                        auto match_kind = round % 4 == 3 ? MatchKind::LEFTMOST_FIRST : MatchKind::STANDARD;
+                        AutomatonType type = types[round % 3];
+                        bool whole_words = round % 5 == 1;
+                        size_t long_pattern_threshold = round % 6 == 2 ? 4 : 0;
+                        GroupMask groups = round % 2 == 0 ? ALL_GROUPS : GroupMask{1};
+                        PatternSet patterns;
+                        for (const auto &pattern : reference::random_patterns (rng, 1 + rng () % 40, 9, "abc"))
+                                {
+                                        patterns.add (pattern, rng () % 2);
+                                }
+                        // from too short to be split to several segments per cursor
+                        std::string input = reference::random_string (rng, rng () % (20 * detail::MIN_SEGMENT_LEN),
+                                                                      "abc ");
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type).match_kind (match_kind)
+                            .whole_words (whole_words).long_pattern_threshold (long_pattern_threshold)
+                            .build (patterns);
+                        auto expected = search (searcher, input, groups);
+                        EXPECT_EQ (search_interleaved<2> (searcher, input, groups), expected) << "round " << round;
+                        EXPECT_EQ (search_interleaved<4> (searcher, input, groups), expected) << "round " << round;
+                        EXPECT_EQ (search_interleaved<7> (searcher, input, groups), expected) << "round " << round;
+                }
+}
+
+TEST (InterleavedTest, SegmentBordersWithinMatches)
+{
+        // every segment border falls into a match that started in the segment before
+        std::string pattern (100, 'a');
+        std::string input (8 * detail::MIN_SEGMENT_LEN + 13, 'a');
+        auto searcher = AhoCorasickBuilder ().automaton_type (AutomatonType::NFA).build (PatternSet{pattern, "aa"});
+        auto expected = search (searcher, input);
+        EXPECT_EQ (expected.size (), (input.size () - 99) + (input.size () - 1));
+        EXPECT_EQ (search_interleaved<4> (searcher, input), expected);
+        EXPECT_EQ (search_interleaved<8> (searcher, input), expected);
+}
+
+TEST (InterleavedTest, StopsEarly)
+{
+        std::string input (16 * detail::MIN_SEGMENT_LEN, 'a');
+        auto searcher = AhoCorasickBuilder ().automaton_type (AutomatonType::NFA).build (PatternSet{"a"});
+        // stopped in the first segment and in a later one
+        for (size_t limit : {size_t{10}, 10 * detail::MIN_SEGMENT_LEN})
+                {
+                        size_t count = 0;
+                        searcher.for_each_match_interleaved<4> (input, [&count, limit] (const Match &match)
+                        {
+                          EXPECT_EQ (match.start, count);
+                          return ++count < limit;
+                        });
+                        EXPECT_EQ (count, limit);
+                }
+}
@@ -0,0 +1,207 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+#include <ac/replicated_searcher.h>
+
+#include "reference.h"
+
+namespace {
+
+template<typename nfa_type>
+void expect_reference_matches (size_t cache_size, std::mt19937 &rng)
+{
+        for (int round = 0; round < 60; ++round)
+                {
+                        BuildConfig config;
+                        config.match_kind = static_cast<MatchKind> (round % 3);
+                        config.ascii_case_insensitive = round % 2 == 1;
+                        config.byte_classes = round % 4 < 2;
+                        config.dfa_cache_size = cache_size;
+                        size_t count = 1 + rng () % 30;
+                        PatternSet patterns (reference::random_patterns (rng, count, 6, "abcAB"));
+                        std::string input = reference::random_string (rng, 500, "abcABx");
+                        AhoCorasick<automaton::LazyDFA<nfa_type>> searcher (patterns, config);
+                        EXPECT_EQ (reference::normalized (searcher.find_matches (input), config.match_kind),
+                                   reference::find_all (patterns, input, config.match_kind,
+                                                        config.ascii_case_insensitive)) << "round " << round;
+                }
+}
+
+}  // namespace
+
+TEST (LazyDFATest, MatchesReference)
+{
+        std::mt19937 rng (31);
+        expect_reference_matches<automaton::NFA> (BuildConfig ().dfa_cache_size, rng);
+        expect_reference_matches<automaton::ContiguousNFA> (BuildConfig ().dfa_cache_size, rng);
+}
+
+TEST (LazyDFATest, SmallCacheIsClearedAndStillMatchesReference)
+{
+        std::mt19937 rng (310);
+        expect_reference_matches<automaton::NFA> (0, rng);
+        expect_reference_matches<automaton::ContiguousNFA> (0, rng);
+
+        PatternSet patterns (reference::random_patterns (rng, 100, 8, "abcd"));
+        std::string input = reference::random_string (rng, 5000, "abcd");
+        BuildConfig config;
+        config.dfa_cache_size = 0;
+        automaton::LazyDFA<automaton::ContiguousNFA> dfa (patterns, config);
+        auto state = dfa.start_state ();
+        for (char c : input)
+                {
+                        state = dfa.next_state (state, c);
+                }
+        EXPECT_GT (dfa.num_cache_clears (), 0u);
+        EXPECT_LE (dfa.num_cached_states (), 3u);
+}
+
+TEST (LazyDFATest, StateLimitCapsTheCache)
+{
+        std::mt19937 rng (311);
+        PatternSet patterns (reference::random_patterns (rng, 100, 8, "abcd"));
+        std::string input = reference::random_string (rng, 5000, "abcd");
+        auto searcher = AhoCorasickBuilder ().automaton_type (AutomatonType::LAZY_DFA).dfa_state_limit (10)
+            .build (patterns);
+        EXPECT_EQ (reference::normalized (searcher.find_matches (input), MatchKind::STANDARD),
+                   reference::find_all (patterns, input, MatchKind::STANDARD, false));
+
+        BuildConfig config;
+        config.dfa_state_limit = 10;
+        automaton::LazyDFA<automaton::ContiguousNFA> dfa (patterns, config);
+        EXPECT_FALSE (dfa.has_pair_transitions ());
+        auto state = dfa.start_state ();
+        for (char c : input)
+                {
+                        state = dfa.next_state (state, c);
+                        ASSERT_LE (dfa.num_cached_states (), 10u);
+                }
+        EXPECT_GT (dfa.num_cache_clears (), 0u);
+
+        config.dfa_state_limit = automaton::LazyDFA<automaton::ContiguousNFA>::MIN_STATES - 1;
+        EXPECT_THROW ((automaton::LazyDFA<automaton::ContiguousNFA> (patterns, config)), std::length_error);
+        EXPECT_THROW (AhoCorasickBuilder ().automaton_type (AutomatonType::LAZY_DFA).dfa_state_limit (2)
+                          .build (patterns), std::length_error);
+}
+
+TEST (LazyDFATest, CachesVisitedStatesOnly)
+{
+        automaton::LazyDFA<automaton::NFA> dfa (PatternSet{"abc", "xyz"}, MatchKind::STANDARD, false);
+        EXPECT_EQ (dfa.num_cached_states (), 2u);
+        auto state = dfa.start_state ();
+        for (char c : std::string_view ("ab"))
+                {
+                        state = dfa.next_state (state, c);
+                }
+        EXPECT_EQ (dfa.num_cached_states (), 4u);
+        EXPECT_EQ (dfa.next_state (dfa.start_state (), 'a'), dfa.next_state (dfa.start_state (), 'a'));
+        EXPECT_EQ (dfa.num_cached_states (), 4u);
+        EXPECT_EQ (dfa.num_cache_clears (), 0u);
+}
+
+TEST (LazyDFATest, IsNotSearchedByMultipleThreads)
+{
+        std::mt19937 rng (3100);
+        PatternSet patterns (reference::random_patterns (rng, 50, 5, "abcd"));
+        const size_t segment_len = AhoCorasick<automaton::Dynamic>::MIN_PARALLEL_SEGMENT_LEN;
+        std::string input = reference::random_string (rng, 3 * segment_len, "abcde");
+        auto searcher = AhoCorasickBuilder ().automaton_type (AutomatonType::LAZY_DFA).build (patterns);
+        std::vector<size_t> counts (patterns.size (), 0);
+        EXPECT_THROW (searcher.count_segment_matches (input, 0, 100, counts), std::invalid_argument);
+        // counted on the calling thread instead
+        searcher.count_matches (input, counts);
+        EXPECT_EQ (searcher.match_histogram (input, 4), counts);
+
+        BuildConfig config;
+        config.automaton_type = AutomatonType::LAZY_DFA;
+        EXPECT_THROW (ReplicatedSearcher<automaton::Dynamic> (patterns, config, NumaTopology ()),
+                      std::invalid_argument);
+}
+
+TEST (LazyDFATest, PairTransitionsMatchReference)
+{
+        std::mt19937 rng (50);
+        for (int round = 0; round < 120; ++round)
+                {
+                        BuildConfig config;
+                        config.match_kind = MatchKind::STANDARD;
+                        config.ascii_case_insensitive = round % 2 == 1;
+                        config.prefilter = round % 4 < 2;
+                        // short patterns end between the two bytes of a pair
+                        size_t max_len = round % 3 == 0 ? 2 : 8;
+                        PatternSet patterns (reference::random_patterns (rng, 1 + rng () % 30, max_len, "ACGT"));
+                        // odd lengths, so that the last byte is read alone
+                        std::string input = reference::random_string (rng, 301 + rng () % 2, "ACGTacgtN");
+                        auto searcher = AhoCorasickBuilder ().automaton_type (AutomatonType::LAZY_DFA)
+                            .ascii_case_insensitive (config.ascii_case_insensitive).prefilter (config.prefilter)
+                            .build (patterns);
+                        automaton::LazyDFA<automaton::ContiguousNFA> dfa (patterns, config);
+                        EXPECT_TRUE (dfa.has_pair_transitions ()) << "round " << round;
+                        std::vector<Match> matches;
+                        auto collect = [&matches] (const Match &match)
+                        {
+                          matches.push_back (match);
+                        };
+                        detail::for_each_match (dfa, Prefilter (), WordBoundary (), config.match_kind, input, collect);
+                        auto expected = reference::find_all (patterns, input, config.match_kind,
+                                                             config.ascii_case_insensitive);
+                        EXPECT_EQ (reference::normalized (matches, config.match_kind), expected) << "round " << round;
+                        EXPECT_EQ (reference::normalized (searcher.find_matches (input), config.match_kind), expected)
+                                                << "round " << round;
+                        // the same order as reading byte by byte
+                        config.dfa_pair_classes = 0;
+                        AhoCorasick<automaton::LazyDFA<automaton::ContiguousNFA>> single (patterns, config);
+                        EXPECT_FALSE (single.automaton ().has_pair_transitions ());
+                        auto single_matches = single.find_matches (input);
+                        EXPECT_EQ (matches, std::vector<Match> (single_matches.begin (), single_matches.end ()))
+                                                << "round " << round;
+                }
+}
+
+TEST (LazyDFATest, PairTransitionsReadOneByteBeforeMatches)
+{
+        std::mt19937 rng (500);
+        PatternSet patterns (reference::random_patterns (rng, 40, 5, "ACGT"));
+        std::string input = reference::random_string (rng, 2000, "ACGT");
+        automaton::LazyDFA<automaton::ContiguousNFA> pairs (patterns, BuildConfig ());
+        automaton::LazyDFA<automaton::ContiguousNFA> single (patterns, BuildConfig ());
+        ASSERT_TRUE (pairs.has_pair_transitions ());
+        auto state = pairs.start_state ();
+        auto single_state = single.start_state ();
+        for (size_t index = 0; index + 1 < input.size ();)
+                {
+                        size_t read = pairs.next_state_pair (state, input[index], input[index + 1]);
+                        auto first = single.next_state (single_state, input[index]);
+                        // a pair is only read at once if its first byte does not lead to a match state
+                        EXPECT_EQ (read, single.is_match (first) ? 1u : 2u) << index;
+                        single_state = read == 1 ? first : single.next_state (first, input[index + 1]);
+                        EXPECT_EQ (pairs.is_match (state), single.is_match (single_state)) << index;
+                        EXPECT_EQ (pairs.matches (state).size (), single.matches (single_state).size ()) << index;
+                        index += read;
+                }
+        // the cache holds every state with its pairs
+        EXPECT_EQ (pairs.num_cache_clears (), 0u);
+}
+
+TEST (LazyDFATest, PairTransitionsNeedFewClassesAndALargeCache)
+{
+        PatternSet dna{"ACGT", "GATTACA"};
+        BuildConfig config;
+        EXPECT_TRUE (automaton::LazyDFA<automaton::NFA> (dna, config).has_pair_transitions ());
+        // more byte classes than dfa_pair_classes
+        config.dfa_pair_classes = 3;
+        EXPECT_FALSE (automaton::LazyDFA<automaton::NFA> (dna, config).has_pair_transitions ());
+        config.dfa_pair_classes = BuildConfig ().dfa_pair_classes;
+        EXPECT_FALSE (automaton::LazyDFA<automaton::NFA> (PatternSet{"abcdefghijklmnopqrstuvwxyz"}, config)
+                          .has_pair_transitions ());
+        // a cache that cannot hold a pair row for every state
+        config.dfa_cache_size = 0;
+        EXPECT_FALSE (automaton::LazyDFA<automaton::NFA> (dna, config).has_pair_transitions ());
+}
@@ -0,0 +1,150 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+#include <ac/utils/lines.h>
+
+#include <algorithm>
+
+#include "reference.h"
+
+namespace {
+
+/// Get the line containing the start of match
+LineMatch line_of (std::string_view input, const Match &match)
+{
+        size_t line_start = input.rfind ('\n', match.start == 0 ? std::string_view::npos : match.start - 1);
+        line_start = line_start == std::string_view::npos || match.start == 0 ? 0 : line_start + 1;
+        size_t line_end = std::min (input.find ('\n', match.start), input.size ());
+        size_t line_number = 1 + std::count (input.begin (), input.begin () + line_start, '\n');
+        return LineMatch{match.pattern, line_number, line_start, line_end};
+}
+
+/// Get the matches of find_lines with first_match_per_line by searching the rest of input after every match
+std::vector<LineMatch> first_matches_per_line (const PatternSet &patterns, std::string_view input,
+                                               MatchKind match_kind)
+{
+        std::vector<LineMatch> result;
+        size_t at = 0;
+        while (at <= input.size ())
+                {
+                        auto matches = reference::find_all (patterns, input.substr (at), match_kind);
+                        if (matches.empty ())
+                                {
+                                        break;
+                                }
+                        Match match = matches.front ();
+                        result.push_back (line_of (input, Match{match.pattern, at + match.start, at + match.end}));
+                        at = result.back ().line_end + 1;
+                }
+        return result;
+}
+
+std::vector<LineMatch> collect (Generator<LineMatch> matches)
+{
+        std::vector<LineMatch> result;
+        for (const auto &match : matches)
+                {
+                        result.push_back (match);
+                }
+        return result;
+}
+
+}  // namespace
+
+TEST (LinesTest, CountNewlines)
+{
+        std::mt19937 rng (34);
+        for (size_t len = 0; len < 200; ++len)
+                {
+                        std::string input = reference::random_string (rng, len, "ab\n");
+                        // unaligned starts as well
+                        for (size_t offset = 0; offset < std::min<size_t> (len, 3); ++offset)
+                                {
+                                        std::string_view view = std::string_view (input).substr (offset);
+                                        auto expected = std::count (view.begin (), view.end (), '\n');
+                                        EXPECT_EQ (count_newlines (view), size_t (expected));
+                                }
+                }
+}
+
+TEST (LinesTest, LocatesLinesInAnyOrder)
+{
+        std::string input = "first\n\nthird line\nlast";
+        LineLocator lines (input);
+        for (size_t pos : {19, 0, 6, 7, 22, 5, 12, 23})
+                {
+                        lines.locate (pos);
+                        LineMatch expected = line_of (input, Match{0, pos, pos});
+                        EXPECT_EQ (lines.line_number (), expected.line_number) << pos;
+                        EXPECT_EQ (lines.line_start (), expected.line_start) << pos;
+                        EXPECT_EQ (lines.line_end (), expected.line_end) << pos;
+                }
+}
+
+TEST (LinesTest, ReportsTheLineOfEveryMatch)
+{
+        std::mt19937 rng (340);
+        for (int round = 0; round < 90; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        bool whole_words = round % 2 == 1;
+                        PatternSet patterns (reference::random_patterns (rng, 1 + rng () % 10, 4, "abc"));
+                        std::string input = reference::random_string (rng, 400, "abc \n\n");
+                        auto searcher = AhoCorasickBuilder ().match_kind (match_kind).whole_words (whole_words)
+                            .build (patterns);
+                        std::vector<LineMatch> expected;
+                        for (const auto &match : searcher.find_matches (input))
+                                {
+                                        expected.push_back (line_of (input, match));
+                                }
+                        EXPECT_EQ (collect (searcher.find_lines (input)), expected) << "round " << round;
+                }
+}
+
+TEST (LinesTest, FirstMatchPerLine)
+{
+        std::mt19937 rng (3400);
+        for (int round = 0; round < 90; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        PatternSet patterns (reference::random_patterns (rng, 1 + rng () % 10, 4, "abc"));
+                        std::string input = reference::random_string (rng, 400, "abcd\n");
+                        auto searcher = AhoCorasickBuilder ().match_kind (match_kind).build (patterns);
+                        auto matches = collect (searcher.find_lines (input, true));
+                        if (match_kind == MatchKind::STANDARD)
+                                {
+                                        // the first match found within a line is the first one ending there
+                                        std::vector<LineMatch> expected;
+                                        for (const auto &match : searcher.find_matches (input))
+                                                {
+                                                        if (expected.empty ()
+                                                            || match.start > expected.back ().line_end)
+                                                                {
+                                                                        expected.push_back (line_of (input, match));
+                                                                }
+                                                }
+                                        EXPECT_EQ (matches, expected) << "round " << round;
+                                        continue;
+                                }
+                        EXPECT_EQ (matches, first_matches_per_line (patterns, input, match_kind)) << "round " << round;
+                }
+}
+
+TEST (LinesTest, EmptyPatternMatchesEveryLineOnce)
+{
+        for (auto match_kind : {MatchKind::STANDARD, MatchKind::LEFTMOST_FIRST, MatchKind::LEFTMOST_LONGEST})
+                {
+                        // "b" is preferred over "" only if the longest match is
+                        PatternID last = match_kind == MatchKind::LEFTMOST_LONGEST ? 1 : 0;
+                        std::vector<LineMatch> expected{{0, 1, 0, 1}, {0, 2, 2, 2}, {last, 3, 3, 4}};
+                        auto searcher = AhoCorasickBuilder ().match_kind (match_kind).build (PatternSet{"", "b"});
+                        EXPECT_EQ (collect (searcher.find_lines ("a\n\nb", true)), expected) << match_kind;
+                }
+}
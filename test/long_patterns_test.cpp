@@ -0,0 +1,211 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+#include <ac/utils/long_patterns.h>
+
+#include <algorithm>
+
+#include "reference.h"
+
+namespace {
+
+const AutomatonType TYPES[] = {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::LAZY_DFA};
+
+template<typename Searcher>
+std::vector<Match> for_each_match (const Searcher &searcher, std::string_view input, GroupMask groups = ALL_GROUPS)
+{
+        std::vector<Match> matches;
+        searcher.for_each_match (input, [&matches] (const Match &match)
+        {
+          matches.push_back (match);
+        }, groups);
+        return matches;
+}
+
+bool ends_in_order (const std::vector<Match> &matches)
+{
+        return std::is_sorted (matches.begin (), matches.end (), [] (const Match &a, const Match &b)
+        {
+          return a.end < b.end;
+        });
+}
+
+}  // namespace
+
+TEST (LongPatternsTest, MatchesReference)
+{
+        // few chars, so that most anchor matches are not confirmed
+        std::mt19937 rng (49);
+        for (int round = 0; round < 180; ++round)
+                {
+                        AutomatonType type = TYPES[round % 3];
+                        bool ignore_case = round % 2 == 1;
+                        size_t threshold = 1 + rng () % 6;
+                        GroupMask groups = round % 4 == 3 ? GroupMask{1} << (rng () % 2) : ALL_GROUPS;
+                        PatternSet patterns;
+                        for (const auto &pattern : reference::random_patterns (rng, 1 + rng () % 20, 14, "abA"))
+                                {
+                                        patterns.add (pattern, rng () % 2);
+                                }
+                        std::string input = reference::random_string (rng, 500, "abAB");
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type).ascii_case_insensitive (ignore_case)
+                            .long_pattern_threshold (threshold).build (patterns);
+                        auto matches = for_each_match (searcher, input, groups);
+                        EXPECT_TRUE (ends_in_order (matches)) << type << " round " << round;
+                        EXPECT_EQ (reference::normalized (matches, MatchKind::STANDARD),
+                                   reference::find_all (patterns, input, MatchKind::STANDARD, ignore_case,
+                                                        WordBoundary (), groups)) << type << " round " << round;
+                        std::vector<Match> iterated;
+                        for (const auto &match : searcher.find_iter (input, groups))
+                                {
+                                        iterated.push_back (match);
+                                }
+                        EXPECT_EQ (iterated, matches) << type << " round " << round;
+                }
+}
+
+TEST (LongPatternsTest, CountsMatchForEachMatch)
+{
+        std::mt19937 rng (490);
+        const size_t segment_len = AhoCorasick<automaton::Dynamic>::MIN_PARALLEL_SEGMENT_LEN;
+        for (int round = 0; round < 3; ++round)
+                {
+                        PatternSet patterns (reference::random_patterns (rng, 30, 40, "ab"));
+                        // long patterns that span the segment borders
+                        std::string input = reference::random_string (rng, 2 * segment_len + 100, "ab");
+                        auto searcher = AhoCorasickBuilder ().long_pattern_threshold (8).build (patterns);
+                        // counted without long patterns, which MatchesReference compares with the reference
+                        std::vector<size_t> expected (patterns.size (), 0);
+                        AhoCorasickBuilder ().build (patterns).count_matches (input, expected);
+                        EXPECT_EQ (searcher.match_histogram (input, 1), expected) << "round " << round;
+                        EXPECT_EQ (searcher.match_histogram (input, 4), expected) << "round " << round;
+                        SearchBudget budget;
+                        budget.max_bytes = 1000;
+                        SearchCursor cursor;
+                        std::vector<Match> budgeted;
+                        while (!cursor.done ())
+                                {
+                                        auto found = searcher.find_budgeted (input, cursor, budget);
+                                        budgeted.insert (budgeted.end (), found.begin (), found.end ());
+                                }
+                        EXPECT_EQ (budgeted, for_each_match (searcher, input)) << "round " << round;
+                }
+}
+
+TEST (LongPatternsTest, VariantsSharingAnAnchor)
+{
+        PatternSet patterns{"abcdefgh1", "abcdefgh2", "abcdefgh", "abcdefgh12", "abc", "ABCDEFGH1"};
+        std::string input = "xabcdefgh12 abcdefgh2 abcdefgh abcdefg ABCDEFGH1";
+        for (bool ignore_case : {false, true})
+                {
+                        auto searcher = AhoCorasickBuilder ().ascii_case_insensitive (ignore_case)
+                            .long_pattern_threshold (3).build (patterns);
+                        auto matches = for_each_match (searcher, input);
+                        EXPECT_TRUE (ends_in_order (matches));
+                        EXPECT_EQ (reference::normalized (matches, MatchKind::STANDARD),
+                                   reference::find_all (patterns, input, MatchKind::STANDARD, ignore_case));
+                }
+}
+
+TEST (LongPatternsTest, AnchorsKeepIdsAndGroups)
+{
+        PatternSet patterns;
+        patterns.add ("abcdef", 1);
+        patterns.add ("ab", 2);
+        patterns.add ("xyz", 3);
+        LongPatterns long_patterns (patterns, 2, false);
+        EXPECT_FALSE (long_patterns.empty ());
+        EXPECT_EQ (long_patterns.threshold (), 2u);
+        EXPECT_TRUE (long_patterns.is_long (0));
+        EXPECT_FALSE (long_patterns.is_long (1));
+        EXPECT_TRUE (long_patterns.is_long (2));
+        PatternSet anchors = long_patterns.anchors (patterns);
+        ASSERT_EQ (anchors.size (), 3u);
+        EXPECT_EQ (anchors[0], "ab");
+        EXPECT_EQ (anchors[1], "ab");
+        EXPECT_EQ (anchors[2], "xy");
+        for (PatternID id = 0; id < 3; ++id)
+                {
+                        EXPECT_EQ (anchors.group (id), patterns.group (id));
+                }
+        EXPECT_TRUE (LongPatterns (patterns, 0, false).empty ());
+        EXPECT_TRUE (LongPatterns (patterns, 6, false).empty ());
+}
+
+TEST (LongPatternsTest, ConfirmsAgainstTheInput)
+{
+        PatternSet patterns{"abcdef", "abcdeg", "ABCDEF"};
+        LongPatterns exact (patterns, 3, false);
+        LongPatterns folded (patterns, 3, true);
+        std::string_view input = "xabcdefabcdeAbCdEf";
+        EXPECT_TRUE (exact.confirm (input, 1, patterns[0]));
+        EXPECT_FALSE (exact.confirm (input, 1, patterns[1]));
+        EXPECT_FALSE (exact.confirm (input, 1, patterns[2]));
+        // too close to the end of the input
+        EXPECT_FALSE (exact.confirm (input, 7, patterns[0]));
+        EXPECT_FALSE (exact.confirm (input, 12, patterns[0]));
+        EXPECT_TRUE (folded.confirm (input, 12, patterns[0]));
+        EXPECT_TRUE (folded.confirm (input, 12, patterns[2]));
+        EXPECT_FALSE (folded.confirm (input, 12, patterns[1]));
+}
+
+TEST (LongPatternsTest, ShrinkTheAutomaton)
+{
+        std::mt19937 rng (4900);
+        PatternSet patterns (reference::random_patterns (rng, 20, 2000, "abcdefgh"));
+        BuildConfig config;
+        AhoCorasick<automaton::NFA> full (patterns, config);
+        config.long_pattern_threshold = 16;
+        AhoCorasick<automaton::NFA> anchored (patterns, config);
+        EXPECT_LE (anchored.automaton ().num_states (), size_t{2 + 20 * 16});
+        EXPECT_LT (anchored.automaton ().num_states (), full.automaton ().num_states ());
+        std::string input = reference::random_string (rng, 5000, "abcdefgh");
+        for (int i = 0; i < 10; ++i)
+                {
+                        input.insert (rng () % input.size (), patterns[rng () % patterns.size ()]);
+                }
+        EXPECT_EQ (for_each_match (anchored, input), for_each_match (full, input));
+}
+
+TEST (LongPatternsTest, ThresholdOnlyAppliesToStandardSearches)
+{
+        std::mt19937 rng (49000);
+        for (int round = 0; round < 30; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        bool whole_words = round % 2 == 1;
+                        PatternSet patterns (reference::random_patterns (rng, 1 + rng () % 10, 10, "ab"));
+                        std::string input = reference::random_string (rng, 300, "ab ");
+                        auto searcher = AhoCorasickBuilder ().match_kind (match_kind).whole_words (whole_words)
+                            .long_pattern_threshold (2).build (patterns);
+                        auto plain = AhoCorasickBuilder ().match_kind (match_kind).whole_words (whole_words)
+                            .build (patterns);
+                        if (match_kind == MatchKind::STANDARD && !whole_words)
+                                {
+                                        // matches ending at the same position may be reported in another order
+                                        EXPECT_EQ (reference::normalized (for_each_match (searcher, input), match_kind),
+                                                   reference::normalized (for_each_match (plain, input), match_kind))
+                                                                << "round " << round;
+                                        continue;
+                                }
+                        EXPECT_EQ (for_each_match (searcher, input), for_each_match (plain, input))
+                                                << "round " << round;
+                        // no pattern is long, so the anchored searches are supported
+                        EXPECT_NO_THROW (static_cast<void> (searcher.find_anchored (input)));
+                }
+}
+
+TEST (LongPatternsTest, RejectsSearchesWithoutConfirmation)
+{
+        auto searcher = AhoCorasickBuilder ().long_pattern_threshold (4).build (PatternSet{"abcdefgh"});
+        EXPECT_THROW (static_cast<void> (searcher.find_lines ("abcdefgh")), std::invalid_argument);
+        EXPECT_THROW (static_cast<void> (searcher.find_iter_chunks (Generator<std::string_view> ())),
+                      std::invalid_argument);
+}
@@ -0,0 +1,14 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+int main (int argc, char **argv)
+{
+        testing::InitGoogleTest (&argc, argv);
+        return RUN_ALL_TESTS ();
+}
@@ -0,0 +1,123 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+#include <ac/utils/memory.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "reference.h"
+
+namespace {
+
+/// Resource passing every allocation to new_delete_resource (), counting the allocated bytes
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  size_t allocated{0};
+  size_t outstanding{0};
+  size_t num_allocations{0};
+
+ private:
+  void *do_allocate (size_t bytes, size_t alignment) override
+  {
+          allocated += bytes;
+          outstanding += bytes;
+          ++num_allocations;
+          return std::pmr::new_delete_resource ()->allocate (bytes, alignment);
+  }
+
+  void do_deallocate (void *p, size_t bytes, size_t alignment) override
+  {
+          outstanding -= bytes;
+          std::pmr::new_delete_resource ()->deallocate (p, bytes, alignment);
+  }
+
+  [[nodiscard]]
+  bool do_is_equal (const std::pmr::memory_resource &other) const noexcept override
+  {
+          return this == &other;
+  }
+};
+
+std::vector<Match> collect (const std::pmr::vector<Match> &matches)
+{
+        return std::vector<Match> (matches.begin (), matches.end ());
+}
+
+}  // namespace
+
+TEST (MemoryTest, EnginesAllocateFromResource)
+{
+        std::mt19937 rng (39);
+        PatternSet patterns (reference::random_patterns (rng, 200, 8, "abcd"));
+        std::string input = reference::random_string (rng, 2000, "abcd");
+        for (AutomatonType type : {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::LAZY_DFA})
+                {
+                        CountingResource resource;
+                        {
+                                auto searcher = AhoCorasickBuilder ().automaton_type (type).memory_resource (&resource)
+                                    .build (patterns);
+                                EXPECT_GT (resource.allocated, 0u) << type;
+                                EXPECT_EQ (reference::normalized (searcher.find_matches (input), MatchKind::STANDARD),
+                                           reference::find_all (patterns, input, MatchKind::STANDARD)) << type;
+                        }
+                        // everything is returned to the resource, e.g. an arena could be released afterwards
+                        EXPECT_EQ (resource.outstanding, 0u) << type;
+                }
+}
+
+TEST (MemoryTest, FindMatchesAllocatesFromResource)
+{
+        auto searcher = AhoCorasickBuilder ().build (PatternSet{"he", "she", "hers"});
+        std::byte buffer[1024];
+        std::pmr::monotonic_buffer_resource arena (buffer, sizeof (buffer), std::pmr::null_memory_resource ());
+        auto matches = searcher.find_matches ("ushers", &arena);
+        EXPECT_EQ (matches.get_allocator ().resource (), &arena);
+        EXPECT_EQ (reference::normalized (matches, MatchKind::STANDARD),
+                   (std::vector<Match>{{1, 1, 4}, {0, 2, 4}, {2, 2, 6}}));
+}
+
+TEST (MemoryTest, HugePageResource)
+{
+        CountingResource upstream;
+        HugePageResource resource (&upstream);
+        EXPECT_EQ (resource.upstream_resource (), &upstream);
+        // small allocations are passed on
+        void *small = resource.allocate (64, 8);
+        EXPECT_EQ (upstream.num_allocations, 1u);
+        resource.deallocate (small, 64, 8);
+        EXPECT_EQ (upstream.outstanding, 0u);
+
+        size_t size = HugePageResource::MIN_SIZE + 1;
+        void *large = resource.allocate (size, 64);
+        std::memset (large, 1, size);
+#if defined(__linux__)
+        EXPECT_EQ (upstream.num_allocations, 1u);
+        EXPECT_EQ (reinterpret_cast<uintptr_t> (large) % HugePageResource::HUGE_PAGE_SIZE, 0u);
+#endif
+        resource.deallocate (large, size, 64);
+        EXPECT_EQ (upstream.outstanding, 0u);
+        EXPECT_TRUE (resource.is_equal (HugePageResource (&upstream)));
+        EXPECT_FALSE (resource.is_equal (upstream));
+}
+
+TEST (MemoryTest, HugePagesMatchReference)
+{
+        std::mt19937 rng (390);
+        PatternSet patterns (reference::random_patterns (rng, 3000, 10, "abcdefgh"));
+        std::string input = reference::random_string (rng, 3000, "abcdefgh");
+        for (AutomatonType type : {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::LAZY_DFA})
+                {
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type).huge_pages (true)
+                            .match_kind (MatchKind::LEFTMOST_LONGEST).build (patterns);
+                        EXPECT_EQ (collect (searcher.find_matches (input)),
+                                   reference::find_all (patterns, input, MatchKind::LEFTMOST_LONGEST)) << type;
+                }
+}
@@ -0,0 +1,148 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+
+#include <algorithm>
+
+#include "reference.h"
+
+namespace {
+
+std::vector<Match> search (const PatternSet &patterns, MatchKind match_kind, bool ignore_case, std::string_view input)
+{
+        BuildConfig config;
+        config.match_kind = match_kind;
+        config.ascii_case_insensitive = ignore_case;
+        AhoCorasick<automaton::NFA> searcher (patterns, config);
+        return reference::normalized (searcher.find_matches (input), match_kind);
+}
+
+}  // namespace
+
+TEST (NFATest, MatchesReference)
+{
+        std::mt19937 rng (30);
+        for (int round = 0; round < 150; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        bool ignore_case = round % 2 == 1;
+                        size_t count = 1 + rng () % 20;
+                        PatternSet patterns (reference::random_patterns (rng, count, 6, "abcAB"));
+                        std::string input = reference::random_string (rng, 300, "abcABx");
+                        EXPECT_EQ (search (patterns, match_kind, ignore_case, input),
+                                   reference::find_all (patterns, input, match_kind, ignore_case)) << "round " << round;
+                }
+}
+
+TEST (NFATest, PatternOrderDoesNotMatter)
+{
+        // the trie is built from the sorted patterns, so the input order must only determine the pattern IDs
+        std::mt19937 rng (300);
+        std::vector<std::string> words = reference::random_patterns (rng, 300, 7, "abcd");
+        std::string input = reference::random_string (rng, 3000, "abcd");
+        std::vector<std::string> sorted = words;
+        std::sort (sorted.begin (), sorted.end ());
+        std::vector<std::string> reversed (sorted.rbegin (), sorted.rend ());
+        for (const auto &patterns : {words, sorted, reversed})
+                {
+                        for (auto match_kind : {MatchKind::STANDARD, MatchKind::LEFTMOST_FIRST,
+                                                MatchKind::LEFTMOST_LONGEST})
+                                {
+                                        EXPECT_EQ (search (patterns, match_kind, false, input),
+                                                   reference::find_all (patterns, input, match_kind));
+                                }
+                        EXPECT_EQ (automaton::NFA (patterns, MatchKind::STANDARD, false).num_states (),
+                                   automaton::NFA (words, MatchKind::STANDARD, false).num_states ());
+                }
+}
+
+TEST (NFATest, DuplicateAndEmptyPatterns)
+{
+        PatternSet patterns{"ab", "", "ab", "AB", "b"};
+        for (auto match_kind : {MatchKind::STANDARD, MatchKind::LEFTMOST_FIRST, MatchKind::LEFTMOST_LONGEST})
+                {
+                        for (bool ignore_case : {false, true})
+                                {
+                                        EXPECT_EQ (search (patterns, match_kind, ignore_case, "xabAbb"),
+                                                   reference::find_all (patterns, "xabAbb", match_kind, ignore_case));
+                                }
+                }
+}
+
+TEST (NFATest, SharedPrefixesShareStates)
+{
+        // start, dead, a, ab, abc, abd, b
+        automaton::NFA nfa (PatternSet{"abc", "abd", "ab", "b"}, MatchKind::STANDARD, false);
+        EXPECT_EQ (nfa.num_states (), 7u);
+}
+
+TEST (NFATest, RejectsNonAsciiPatterns)
+{
+        EXPECT_THROW (automaton::NFA (PatternSet{"a\x80"}, MatchKind::STANDARD, false), std::invalid_argument);
+}
+
+TEST (NFATest, LeavesShareARow)
+{
+        // rows: the one of all leaves (abc, abd, b), start, dead, a, ab
+        for (bool byte_classes : {true, false})
+                {
+                        BuildConfig config;
+                        config.byte_classes = byte_classes;
+                        automaton::NFA nfa (PatternSet{"abc", "abd", "ab", "b"}, config);
+                        EXPECT_EQ (nfa.num_rows (), 5u);
+                        // a column per pattern char and one shared by all other chars
+                        EXPECT_EQ (nfa.num_columns (), byte_classes ? 5u : 128u);
+                }
+}
+
+TEST (NFATest, CasesShareAColumn)
+{
+        BuildConfig config;
+        config.ascii_case_insensitive = true;
+        EXPECT_EQ (automaton::NFA (PatternSet{"ab", "AB", "aB"}, config).num_columns (), 3u);
+        config.ascii_case_insensitive = false;
+        EXPECT_EQ (automaton::NFA (PatternSet{"ab", "AB", "aB"}, config).num_columns (), 5u);
+}
+
+TEST (NFATest, RowsMatchPatternStats)
+{
+        std::mt19937 rng (44);
+        for (int round = 0; round < 60; ++round)
+                {
+                        bool ignore_case = round % 2 == 1;
+                        PatternSet patterns (reference::random_patterns (rng, 1 + rng () % 100, 8, "abcAB"));
+                        BuildConfig config;
+                        config.ascii_case_insensitive = ignore_case;
+                        automaton::NFA nfa (patterns, config);
+                        auto stats = automaton::analyze_patterns (patterns, ignore_case);
+                        EXPECT_EQ (nfa.num_states (), stats.trie_size + 2) << "round " << round;
+                        EXPECT_EQ (nfa.num_rows (), 3 + stats.trie_size - stats.trie_leaves) << "round " << round;
+                        EXPECT_EQ (nfa.num_columns (), stats.alphabet_size) << "round " << round;
+                }
+}
+
+TEST (NFATest, ByteClassesMatchReference)
+{
+        std::mt19937 rng (440);
+        for (int round = 0; round < 120; ++round)
+                {
+                        BuildConfig config;
+                        config.match_kind = static_cast<MatchKind> (round % 3);
+                        config.ascii_case_insensitive = round % 2 == 1;
+                        config.byte_classes = round % 4 < 2;
+                        PatternSet patterns (reference::random_patterns (rng, 1 + rng () % 20, 6, "abcAB"));
+                        // chars outside of the patterns, including non-ASCII ones, share a column
+                        std::string input = reference::random_string (rng, 300, "abcABxz\x80\xff");
+                        AhoCorasick<automaton::NFA> searcher (patterns, config);
+                        EXPECT_EQ (reference::normalized (searcher.find_matches (input), config.match_kind),
+                                   reference::find_all (patterns, input, config.match_kind,
+                                                        config.ascii_case_insensitive)) << "round " << round;
+                }
+}
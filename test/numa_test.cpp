@@ -0,0 +1,121 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/replicated_searcher.h>
+#include <ac/utils/numa.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "reference.h"
+
+TEST (NumaTest, ParsesDescriptions)
+{
+        auto topology = NumaTopology::parse ("0-2,8; 4-5 ;0");
+        EXPECT_TRUE (topology.fake ());
+        ASSERT_EQ (topology.num_nodes (), 3u);
+        EXPECT_EQ (topology.cpus (0), (std::vector<size_t>{0, 1, 2, 8}));
+        EXPECT_EQ (topology.cpus (1), (std::vector<size_t>{4, 5}));
+        EXPECT_EQ (topology.cpus (2), (std::vector<size_t>{0}));
+        for (std::string_view description : {"", "a", "1-0", "0,", "0-", "0--1", "0 1"})
+                {
+                        EXPECT_THROW (static_cast<void>(NumaTopology::parse (description)), std::invalid_argument)
+                                                << description;
+                }
+        EXPECT_FALSE (NumaTopology ().fake ());
+        EXPECT_EQ (NumaTopology ().num_nodes (), 1u);
+}
+
+TEST (NumaTest, FakeTopologyInterleavesMemory)
+{
+        auto topology = NumaTopology::parse ("0;0;0");
+        for (size_t block = 0; block < 10; ++block)
+                {
+                        auto address = reinterpret_cast<const void *>(block * NumaTopology::FAKE_INTERLEAVE + 5);
+                        EXPECT_EQ (topology.node_of (address), block % 3);
+                }
+}
+
+TEST (NumaTest, BindingsArePerTopology)
+{
+        auto topology = NumaTopology::parse ("0;0");
+        auto other = NumaTopology::parse ("0;0");
+        std::thread ([&] ()
+        {
+          topology.bind_thread (1);
+          EXPECT_EQ (topology.current_node (), 1u);
+          EXPECT_EQ (NumaTopology (topology).current_node (), 1u);
+          // other has not bound this thread and finds CPU 0 on its first node
+          EXPECT_EQ (other.current_node (), 0u);
+          other.bind_thread (0);
+          topology.bind_thread (1);
+          EXPECT_EQ (other.current_node (), 0u);
+          EXPECT_EQ (topology.current_node (), 1u);
+        }).join ();
+        // the calling thread was not bound
+        EXPECT_EQ (topology.current_node (), 0u);
+}
+
+TEST (NumaTest, RunsOnEveryNode)
+{
+        auto topology = NumaTopology::parse ("0;0;0");
+        std::mutex mutex;
+        std::vector<std::pair<size_t, size_t>> calls;
+        run_on_nodes (topology, 2, [&] (size_t node, size_t thread)
+        {
+          EXPECT_EQ (topology.current_node (), node);
+          std::lock_guard lock (mutex);
+          calls.emplace_back (node, thread);
+        });
+        std::sort (calls.begin (), calls.end ());
+        std::vector<std::pair<size_t, size_t>> expected{{0, 0}, {0, 1}, {1, 2}, {1, 3}, {2, 4}, {2, 5}};
+        EXPECT_EQ (calls, expected);
+}
+
+TEST (NumaTest, RethrowsAfterAllThreadsFinished)
+{
+        auto topology = NumaTopology::parse ("0;0");
+        std::atomic<size_t> finished{0};
+        EXPECT_THROW (run_on_nodes (topology, 3, [&] (size_t, size_t thread)
+        {
+          ++finished;
+          if (thread % 2 == 1)
+            {
+              throw std::runtime_error ("thread " + std::to_string (thread));
+            }
+        }), std::runtime_error);
+        EXPECT_EQ (finished, 6u);
+}
+
+TEST (NumaTest, ReplicasMatchReference)
+{
+        std::mt19937 rng (43);
+        PatternSet patterns (reference::random_patterns (rng, 30, 5, "abcd"));
+        const size_t segment_len = AhoCorasick<automaton::ContiguousNFA>::MIN_PARALLEL_SEGMENT_LEN;
+        std::string input = reference::random_string (rng, 5 * segment_len + 17, "abcde");
+        for (auto match_kind : {MatchKind::STANDARD, MatchKind::LEFTMOST_FIRST})
+                {
+                        BuildConfig config;
+                        config.match_kind = match_kind;
+                        ReplicatedSearcher<automaton::ContiguousNFA> searcher (patterns, config,
+                                                                               NumaTopology::parse ("0;0"));
+                        ASSERT_EQ (searcher.topology ().num_nodes (), 2u);
+                        EXPECT_NE (&searcher.replica (0), &searcher.replica (1));
+                        std::vector<size_t> expected (patterns.size (), 0);
+                        for (const auto &match : reference::find_all (patterns, input, match_kind))
+                                {
+                                        ++expected[match.pattern];
+                                }
+                        EXPECT_EQ (searcher.match_histogram (input, 4), expected) << match_kind;
+                        EXPECT_EQ (searcher.local ().match_histogram (input, 1), expected) << match_kind;
+                }
+}
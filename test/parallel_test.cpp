@@ -0,0 +1,85 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+#include <ac/utils/parallel.h>
+
+#include <atomic>
+
+#include "reference.h"
+
+TEST (ParallelTest, ParallelForRunsEveryTaskOnce)
+{
+        for (size_t num_threads : {1, 3, 8})
+                {
+                        std::vector<std::atomic<int>> runs (100);
+                        std::atomic<bool> valid_thread{true};
+                        parallel_for (num_threads, runs.size (), [&] (size_t task, size_t thread)
+                        {
+                          runs[task]++;
+                          if (thread >= num_threads)
+                                  {
+                                          valid_thread = false;
+                                  }
+                        });
+                        for (auto &count : runs)
+                                {
+                                        EXPECT_EQ (count, 1);
+                                }
+                        EXPECT_TRUE (valid_thread);
+                }
+        EXPECT_GE (resolve_num_threads (0), 1u);
+        EXPECT_EQ (resolve_num_threads (5), 5u);
+}
+
+TEST (ParallelTest, ParallelBuildMatchesReference)
+{
+        std::mt19937 rng (29);
+        for (int round = 0; round < 30; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        bool ignore_case = round % 2 == 1;
+                        size_t count = 1 + rng () % 200;
+                        PatternSet patterns (reference::random_patterns (rng, count, 6, "abcdeABCDE"));
+                        std::string input = reference::random_string (rng, 1000, "abcdeABCDEx");
+                        auto expected = reference::find_all (patterns, input, match_kind, ignore_case);
+                        for (size_t num_threads : {1, 4, 0})
+                                {
+                                        auto searcher = AhoCorasickBuilder ().match_kind (match_kind)
+                                            .ascii_case_insensitive (ignore_case).build_threads (num_threads)
+                                            .build<automaton::NFA> (patterns);
+                                        EXPECT_EQ (reference::normalized (searcher.find_matches (input), match_kind),
+                                                   expected) << "round " << round << " threads " << num_threads;
+                                }
+                }
+}
+
+TEST (ParallelTest, ParallelBuildIsDeterministic)
+{
+        // large enough for the failure transitions of a level to be split into chunks
+        std::mt19937 rng (290);
+        PatternSet patterns (reference::random_patterns (rng, 20000, 8, "abcdefghijklmnop"));
+        std::string input = reference::random_string (rng, 20000, "abcdefghijklmnop");
+        BuildConfig config;
+        auto serial = AhoCorasick<automaton::NFA> (patterns, config).find_matches (input);
+        config.build_threads = 8;
+        auto parallel = AhoCorasick<automaton::NFA> (patterns, config).find_matches (input);
+        EXPECT_EQ (std::vector<Match> (parallel.begin (), parallel.end ()),
+                   std::vector<Match> (serial.begin (), serial.end ()));
+}
+
+TEST (ParallelTest, ParallelBuildHonorsMemoryLimit)
+{
+        std::mt19937 rng (2900);
+        PatternSet patterns (reference::random_patterns (rng, 5000, 10, "abcdefghijklmnopqrstuvwxyz"));
+        BuildConfig config;
+        config.build_threads = 4;
+        config.memory_limit = 1 << 16;
+        EXPECT_THROW (automaton::NFA (patterns, config), std::length_error);
+}
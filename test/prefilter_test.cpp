@@ -0,0 +1,119 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+#include <ac/utils/prefilter.h>
+
+#include <set>
+
+#include "reference.h"
+
+namespace {
+
+const std::string_view ALPHABET = "abcdefghijklmnopqrstuvwxyz";
+
+/// Get count random words of min_len to max_len bytes and an input of len bytes that contains them num_insertions times
+std::pair<std::vector<std::string>, std::string> random_text (std::mt19937 &rng, size_t count, size_t min_len,
+                                                              size_t max_len, size_t len, size_t num_insertions)
+{
+        std::vector<std::string> words;
+        for (size_t i = 0; i < count; ++i)
+                {
+                        words.push_back (reference::random_string (rng, min_len + rng () % (max_len - min_len + 1),
+                                                                   ALPHABET));
+                }
+        std::string input = reference::random_string (rng, len, ALPHABET);
+        for (size_t i = 0; i < num_insertions; ++i)
+                {
+                        input.insert (rng () % input.size (), words[rng () % words.size ()]);
+                }
+        return {words, input};
+}
+
+}  // namespace
+
+TEST (PrefilterTest, ShiftsWindowsForLongPatterns)
+{
+        std::mt19937 rng (42);
+        auto [words, input] = random_text (rng, 20, 12, 20, 100, 0);
+        Prefilter prefilter (words, false);
+        ASSERT_TRUE (prefilter.enabled ());
+        size_t min_len = std::min_element (words.begin (), words.end (), [] (const auto &a, const auto &b)
+        {
+          return a.size () < b.size ();
+        })->size ();
+        EXPECT_EQ (prefilter.window (), min_len);
+        // too short for a window
+        EXPECT_EQ (Prefilter (PatternSet{"abcdefg", "hijklmnop"}, false).window (), 0u);
+        // the window is at most MAX_WINDOW bytes long
+        std::vector<std::string> long_words{reference::random_string (rng, 2 * Prefilter::MAX_WINDOW, ALPHABET)};
+        EXPECT_EQ (Prefilter (long_words, false).window (), Prefilter::MAX_WINDOW);
+}
+
+TEST (PrefilterTest, WindowNeverSkipsAMatch)
+{
+        std::mt19937 rng (420);
+        for (int round = 0; round < 40; ++round)
+                {
+                        bool ignore_case = round % 2 == 1;
+                        auto [words, input] = random_text (rng, 1 + rng () % 30, 8, 16, 3000, 40);
+                        if (ignore_case)
+                                {
+                                        for (auto &c : input)
+                                                {
+                                                        c = rng () % 2 == 0 ? static_cast<char> (std::toupper (c)) : c;
+                                                }
+                                }
+                        Prefilter prefilter (words, ignore_case);
+                        if (!prefilter.enabled ())
+                                {
+                                        continue;
+                                }
+                        std::set<size_t> candidates;
+                        for (size_t at = 0; at < input.size (); at = *candidates.rbegin () + 1)
+                                {
+                                        candidates.insert (prefilter.find_candidate (input, at));
+                                }
+                        for (const auto &match : reference::standard_matches (words, input, ignore_case))
+                                {
+                                        EXPECT_TRUE (candidates.contains (match.start))
+                                                                << "round " << round << " start " << match.start;
+                                }
+                        // a skipping prefilter does not look at most positions
+                        EXPECT_LT (candidates.size (), input.size () / 2) << "round " << round;
+                }
+}
+
+TEST (PrefilterTest, WindowBeyondInputIsCandidate)
+{
+        Prefilter prefilter (PatternSet{"abcdefghij", "klmnopqrst"}, false);
+        ASSERT_EQ (prefilter.window (), 10u);
+        // the input might continue with "cdefghij"
+        EXPECT_EQ (prefilter.find_candidate ("zzzzzzzzzzzzzzzzzzab", 0), 18u);
+        EXPECT_EQ (prefilter.find_candidate ("zzzzzzzzzzzzzzzzzzabcdefghij", 0), 18u);
+}
+
+TEST (PrefilterTest, SearchesWithWindowsMatchReference)
+{
+        std::mt19937 rng (4200);
+        const AutomatonType types[] = {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::LAZY_DFA};
+        for (int round = 0; round < 36; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        AutomatonType type = types[round / 3 % 3];
+                        bool ignore_case = round % 2 == 1;
+                        auto [words, input] = random_text (rng, 1 + rng () % 30, 8, 14, 5000, 60);
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type).match_kind (match_kind)
+                            .ascii_case_insensitive (ignore_case).build (words);
+                        auto expected = reference::find_all (words, input, match_kind, ignore_case);
+                        EXPECT_FALSE (expected.empty ());
+                        EXPECT_EQ (reference::normalized (searcher.find_matches (input), match_kind), expected)
+                                                << type << " round " << round;
+                }
+}
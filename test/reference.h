@@ -0,0 +1,214 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#ifndef _TEST_REFERENCE_H_
+#define _TEST_REFERENCE_H_
+
+#include <ac/search.h>
+#include <ac/utils/pattern_set.h>
+#include <ac/utils/word_boundary.h>
+
+#include <algorithm>
+#include <cctype>
+#include <optional>
+#include <ostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+/**
+ * Brute force implementations of the match semantics the searchers are tested against, and random inputs for them.
+ */
+namespace reference {
+
+/// Tell whether pattern occurs in input at pos
+inline bool equal_at (std::string_view input, size_t pos, std::string_view pattern, bool ignore_case)
+{
+        if (pos > input.size () || input.size () - pos < pattern.size ())
+                {
+                        return false;
+                }
+        for (size_t i = 0; i < pattern.size (); ++i)
+                {
+                        auto a = static_cast<unsigned char>(input[pos + i]);
+                        auto b = static_cast<unsigned char>(pattern[i]);
+                        if (ignore_case ? std::tolower (a) != std::tolower (b) : a != b)
+                                {
+                                        return false;
+                                }
+                }
+        return true;
+}
+
+inline bool in_groups (const PatternSet &patterns, PatternID id, GroupMask groups)
+{
+        return ((groups >> patterns.group (id)) & 1) != 0;
+}
+
+/**
+ * @brief Copy matches into a vector. The engines report the MatchKind::STANDARD matches ending at the same position in
+ *  the order they store them in, so these are ordered by their starts and pattern IDs to compare them.
+ */
+template<typename Matches>
+std::vector<Match> normalized (const Matches &matches, MatchKind match_kind)
+{
+        std::vector<Match> result (matches.begin (), matches.end ());
+        if (match_kind == MatchKind::STANDARD)
+                {
+                        std::sort (result.begin (), result.end (), [] (const Match &a, const Match &b)
+                        {
+                          return std::tie (a.end, a.start, a.pattern) < std::tie (b.end, b.start, b.pattern);
+                        });
+                }
+        return result;
+}
+
+/**
+ * @brief Get the matches of patterns of groups that are whole words (if words is enabled), ordered by their ends,
+ *  starts and pattern IDs: the result of a MatchKind::STANDARD search.
+ */
+inline std::vector<Match> standard_matches (const PatternSet &patterns, std::string_view input, bool ignore_case,
+                                            const WordBoundary &words = WordBoundary (),
+                                            GroupMask groups = ALL_GROUPS)
+{
+        std::vector<Match> matches;
+        for (size_t end = 0; end <= input.size (); ++end)
+                {
+                        for (PatternID id = 0; id < patterns.size (); ++id)
+                                {
+                                        size_t len = patterns[id].size ();
+                                        if (len > end)
+                                                {
+                                                        continue;
+                                                }
+                                        size_t start = end - len;
+                                        if (in_groups (patterns, id, groups) && words.allows (input, start, end)
+                                            && equal_at (input, start, patterns[id], ignore_case))
+                                                {
+                                                        matches.push_back (Match{id, start, end});
+                                                }
+                                }
+                }
+        return normalized (matches, MatchKind::STANDARD);
+}
+
+/**
+ * @brief Get the match preferred by match_kind among the (whole-word) matches starting at start: the one of the
+ *  lowest pattern ID for MatchKind::LEFTMOST_FIRST, the longest one for MatchKind::LEFTMOST_LONGEST.
+ */
+inline std::optional<Match> preferred_at (const PatternSet &patterns, std::string_view input, size_t start,
+                                          MatchKind match_kind, bool ignore_case, const WordBoundary &words)
+{
+        std::optional<Match> best;
+        for (PatternID id = 0; id < patterns.size (); ++id)
+                {
+                        Match match{id, start, start + patterns[id].size ()};
+                        if (!equal_at (input, start, patterns[id], ignore_case)
+                            || !words.allows (input, match.start, match.end))
+                                {
+                                        continue;
+                                }
+                        if (!best || (match_kind == MatchKind::LEFTMOST_LONGEST && match.end > best->end))
+                                {
+                                        best = match;
+                                }
+                }
+        return best;
+}
+
+/**
+ * @brief Get the non-overlapping leftmost matches of a leftmost match kind. The matches of patterns that are not in
+ *  groups are replaced by the lowest pattern of groups that equals them (up to the ASCII case) or dropped.
+ */
+inline std::vector<Match> leftmost_matches (const PatternSet &patterns, std::string_view input, MatchKind match_kind,
+                                            bool ignore_case, const WordBoundary &words = WordBoundary (),
+                                            GroupMask groups = ALL_GROUPS)
+{
+        std::vector<Match> matches;
+        size_t at = 0;
+        while (at <= input.size ())
+                {
+                        std::optional<Match> found;
+                        for (size_t start = at; start <= input.size () && !found; ++start)
+                                {
+                                        found = preferred_at (patterns, input, start, match_kind, ignore_case, words);
+                                }
+                        if (!found)
+                                {
+                                        break;
+                                }
+                        for (PatternID id = 0; id < patterns.size (); ++id)
+                                {
+                                        if (in_groups (patterns, id, groups)
+                                            && patterns[id].size () == found->end - found->start
+                                            && equal_at (input, found->start, patterns[id], ignore_case))
+                                                {
+                                                        matches.push_back (Match{id, found->start, found->end});
+                                                        break;
+                                                }
+                                }
+                        at = found->end == found->start ? found->end + 1 : found->end;
+                }
+        return matches;
+}
+
+/**
+ * @brief Get the matches a search of input with match_kind reports.
+ */
+inline std::vector<Match> find_all (const PatternSet &patterns, std::string_view input, MatchKind match_kind,
+                                    bool ignore_case = false, const WordBoundary &words = WordBoundary (),
+                                    GroupMask groups = ALL_GROUPS)
+{
+        if (match_kind == MatchKind::STANDARD)
+                {
+                        return standard_matches (patterns, input, ignore_case, words, groups);
+                }
+        return leftmost_matches (patterns, input, match_kind, ignore_case, words, groups);
+}
+
+inline std::string random_string (std::mt19937 &rng, size_t len, std::string_view alphabet)
+{
+        std::string s;
+        for (size_t i = 0; i < len; ++i)
+                {
+                        s.push_back (alphabet[rng () % alphabet.size ()]);
+                }
+        return s;
+}
+
+/**
+ * @brief Get count non-empty patterns of up to max_len chars of alphabet. Small alphabets make patterns share
+ *  prefixes and suffixes and overlap within the input.
+ */
+inline std::vector<std::string> random_patterns (std::mt19937 &rng, size_t count, size_t max_len,
+                                                 std::string_view alphabet)
+{
+        std::vector<std::string> patterns;
+        for (size_t i = 0; i < count; ++i)
+                {
+                        patterns.push_back (random_string (rng, 1 + rng () % max_len, alphabet));
+                }
+        return patterns;
+}
+
+}  // namespace reference
+
+// let GoogleTest print matches
+inline std::ostream &operator<< (std::ostream &os, const Match &match)
+{
+        return os << "(" << match.pattern << ", " << match.start << ", " << match.end << ")";
+}
+
+inline std::ostream &operator<< (std::ostream &os, const LineMatch &match)
+{
+        return os << "(" << match.pattern << ", line " << match.line_number << ", " << match.line_start << ", "
+                  << match.line_end << ")";
+}
+
+#endif //_TEST_REFERENCE_H_
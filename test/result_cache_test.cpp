@@ -0,0 +1,207 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+#include <ac/utils/result_cache.h>
+
+#include <functional>
+#include <thread>
+
+#include "reference.h"
+
+namespace {
+
+template<typename Searcher>
+std::vector<Match> for_each_match (const Searcher &searcher, std::string_view input, GroupMask groups = ALL_GROUPS)
+{
+        std::vector<Match> matches;
+        searcher.for_each_match (input, [&matches] (const Match &match)
+        {
+          matches.push_back (match);
+        }, groups);
+        return matches;
+}
+
+/// Size of an entry of input without matches, measured by inserting it into an empty cache
+size_t entry_bytes (std::string_view input)
+{
+        ResultCache cache (1 << 20, 1);
+        cache.insert (0, ALL_GROUPS, input, {});
+        return cache.stats ().bytes;
+}
+
+}  // namespace
+
+TEST (ResultCacheTest, FindCachedMatchesForEachMatch)
+{
+        std::mt19937 rng (47);
+        PatternSet patterns;
+        for (const auto &pattern : reference::random_patterns (rng, 30, 4, "abc"))
+                {
+                        patterns.add (pattern, rng () % 2);
+                }
+        auto leftmost = AhoCorasickBuilder ().match_kind (MatchKind::LEFTMOST_FIRST).build (patterns);
+        auto standard = AhoCorasickBuilder ().build (patterns);
+        EXPECT_NE (leftmost.id (), standard.id ());
+        std::vector<std::string> inputs;
+        for (int i = 0; i < 20; ++i)
+                {
+                        inputs.push_back (reference::random_string (rng, rng () % 50, "abcd"));
+                }
+        // shared by both searchers, so that their entries for the same inputs are told apart
+        ResultCache cache (1 << 20, 4);
+        for (int i = 0; i < 500; ++i)
+                {
+                        const auto &input = inputs[rng () % inputs.size ()];
+                        GroupMask groups = i % 3 == 0 ? ALL_GROUPS : GroupMask{1} << (i % 2);
+                        const auto &searcher = i % 2 == 0 ? leftmost : standard;
+                        EXPECT_EQ (searcher.find_cached (input, cache, groups),
+                                   for_each_match (searcher, input, groups)) << i;
+                }
+        auto stats = cache.stats ();
+        EXPECT_EQ (stats.hits + stats.misses, 500u);
+        EXPECT_GT (stats.hits, 0u);
+        EXPECT_EQ (stats.misses, stats.entries);
+        EXPECT_EQ (stats.evictions, 0u);
+}
+
+TEST (ResultCacheTest, EvictsLeastRecentlyUsedEntries)
+{
+        const size_t bytes = entry_bytes ("aaaa");
+        ResultCache cache (2 * bytes, 1);
+        cache.insert (0, ALL_GROUPS, "aaaa", {});
+        cache.insert (0, ALL_GROUPS, "bbbb", {});
+        EXPECT_TRUE (cache.lookup (0, ALL_GROUPS, "aaaa").has_value ());
+        // evicts "bbbb", the least recently used one
+        cache.insert (0, ALL_GROUPS, "cccc", {});
+        EXPECT_TRUE (cache.lookup (0, ALL_GROUPS, "aaaa").has_value ());
+        EXPECT_FALSE (cache.lookup (0, ALL_GROUPS, "bbbb").has_value ());
+        EXPECT_TRUE (cache.lookup (0, ALL_GROUPS, "cccc").has_value ());
+        auto stats = cache.stats ();
+        EXPECT_EQ (stats.evictions, 1u);
+        EXPECT_EQ (stats.entries, 2u);
+        EXPECT_EQ (stats.bytes, 2 * bytes);
+
+        // an entry with matches is larger and evicts both
+        std::vector<Match> matches (bytes / sizeof (Match), Match{0, 0, 4});
+        cache.insert (0, ALL_GROUPS, "dddd", matches);
+        EXPECT_EQ (cache.lookup (0, ALL_GROUPS, "dddd"), matches);
+        EXPECT_FALSE (cache.lookup (0, ALL_GROUPS, "aaaa").has_value ());
+        EXPECT_FALSE (cache.lookup (0, ALL_GROUPS, "cccc").has_value ());
+        stats = cache.stats ();
+        EXPECT_EQ (stats.evictions, 3u);
+        EXPECT_EQ (stats.entries, 1u);
+        EXPECT_LE (stats.bytes, 2 * bytes);
+}
+
+TEST (ResultCacheTest, StaysWithinCapacity)
+{
+        std::mt19937 rng (470);
+        auto searcher = AhoCorasickBuilder ().build (PatternSet{"a", "ab", "b"});
+        const size_t capacity = 20 * entry_bytes ("abcabcab");
+        ResultCache cache (capacity, 4, 16);
+        for (int i = 0; i < 2000; ++i)
+                {
+                        std::string input = reference::random_string (rng, 1 + rng () % 16, "abc");
+                        EXPECT_EQ (searcher.find_cached (input, cache), for_each_match (searcher, input)) << i;
+                        EXPECT_LE (cache.stats ().bytes, capacity);
+                }
+        EXPECT_GT (cache.stats ().evictions, 0u);
+}
+
+TEST (ResultCacheTest, SkipsLongInputsAndLargeEntries)
+{
+        ResultCache cache (1 << 20, 1, 3);
+        EXPECT_EQ (cache.max_input_len (), 3u);
+        cache.insert (0, ALL_GROUPS, "abcd", {});
+        EXPECT_FALSE (cache.lookup (0, ALL_GROUPS, "abcd").has_value ());
+        EXPECT_EQ (cache.stats ().skipped, 1u);
+        EXPECT_EQ (cache.stats ().misses, 0u);
+        EXPECT_EQ (cache.stats ().entries, 0u);
+
+        // larger than the share of a shard
+        ResultCache small (entry_bytes ("abc") - 1, 1);
+        small.insert (0, ALL_GROUPS, "abc", {});
+        EXPECT_EQ (small.stats ().entries, 0u);
+        EXPECT_FALSE (small.lookup (0, ALL_GROUPS, "abc").has_value ());
+}
+
+TEST (ResultCacheTest, CollidingKeysAreToldApart)
+{
+        // Craft a key whose hash equals that of (1, ALL_GROUPS, input) by choosing its groups, mixing the searcher and
+        //  the groups into the hash of the input like result_cache.cpp.
+        const std::string_view input = "abc";
+        auto mix = [] (size_t hash, uint64_t value)
+        {
+          return hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+        };
+        const size_t input_hash = std::hash<std::string_view>{} (input);
+        const size_t hash = mix (mix (input_hash, 1), ALL_GROUPS);
+        const size_t other_hash = mix (input_hash, 2);
+        const GroupMask other_groups = (other_hash ^ hash) - 0x9e3779b97f4a7c15ULL - (other_hash << 6)
+                                       - (other_hash >> 2);
+        ASSERT_EQ (mix (other_hash, other_groups), hash);
+
+        ResultCache cache (1 << 20, 1);
+        const std::vector<Match> matches{{0, 0, 3}};
+        const std::vector<Match> other_matches{{1, 1, 2}};
+        cache.insert (1, ALL_GROUPS, input, matches);
+        EXPECT_FALSE (cache.lookup (2, other_groups, input).has_value ());
+        cache.insert (2, other_groups, input, other_matches);
+        EXPECT_EQ (cache.lookup (1, ALL_GROUPS, input), matches);
+        EXPECT_EQ (cache.lookup (2, other_groups, input), other_matches);
+        EXPECT_EQ (cache.stats ().entries, 2u);
+}
+
+TEST (ResultCacheTest, ClearKeepsCounters)
+{
+        ResultCache cache;
+        cache.insert (0, ALL_GROUPS, "a", {});
+        EXPECT_TRUE (cache.lookup (0, ALL_GROUPS, "a").has_value ());
+        cache.clear ();
+        EXPECT_FALSE (cache.lookup (0, ALL_GROUPS, "a").has_value ());
+        auto stats = cache.stats ();
+        EXPECT_EQ (stats.hits, 1u);
+        EXPECT_EQ (stats.misses, 1u);
+        EXPECT_EQ (stats.entries, 0u);
+        EXPECT_EQ (stats.bytes, 0u);
+}
+
+TEST (ResultCacheTest, IsSharedByThreads)
+{
+        std::mt19937 rng (4700);
+        PatternSet patterns (reference::random_patterns (rng, 30, 4, "abc"));
+        auto searcher = AhoCorasickBuilder ().build (patterns);
+        std::vector<std::string> inputs;
+        for (int i = 0; i < 50; ++i)
+                {
+                        inputs.push_back (reference::random_string (rng, rng () % 40, "abcd"));
+                }
+        // small enough to evict while other threads look entries up
+        ResultCache cache (10 * entry_bytes (inputs[0]), 2);
+        std::vector<std::thread> threads;
+        for (unsigned seed = 0; seed < 4; ++seed)
+                {
+                        threads.emplace_back ([&, seed] ()
+                        {
+                          std::mt19937 thread_rng (seed);
+                          for (int i = 0; i < 1000; ++i)
+                            {
+                              const auto &input = inputs[thread_rng () % inputs.size ()];
+                              EXPECT_EQ (searcher.find_cached (input, cache), for_each_match (searcher, input));
+                            }
+                        });
+                }
+        for (auto &thread : threads)
+                {
+                        thread.join ();
+                }
+        auto stats = cache.stats ();
+        EXPECT_EQ (stats.hits + stats.misses, 4000u);
+}
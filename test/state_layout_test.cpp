@@ -0,0 +1,149 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+#include <ac/utils/state_layout.h>
+
+#include <cstring>
+#include <sstream>
+
+#include "reference.h"
+
+namespace {
+
+/// Get the layout of the states visited by searching samples of input
+StateLayout profile (const PatternSet &patterns, const BuildConfig &config, std::string_view input)
+{
+        automaton::ContiguousNFA nfa (patterns, config);
+        std::vector<std::string_view> samples{input.substr (0, input.size () / 2), input.substr (input.size () / 3)};
+        return nfa.profile (samples);
+}
+
+std::string saved (const StateLayout &layout)
+{
+        std::stringstream stream;
+        layout.save (stream);
+        return stream.str ();
+}
+
+StateLayout load (const std::string &bytes)
+{
+        std::stringstream stream (bytes);
+        return StateLayout::load (stream);
+}
+
+}  // namespace
+
+TEST (StateLayoutTest, ProfiledLayoutMatchesReference)
+{
+        std::mt19937 rng (48);
+        for (int round = 0; round < 90; ++round)
+                {
+                        BuildConfig config;
+                        config.match_kind = static_cast<MatchKind> (round % 3);
+                        config.ascii_case_insensitive = round % 2 == 1;
+                        config.byte_classes = round % 4 < 2;
+                        PatternSet patterns (reference::random_patterns (rng, 1 + rng () % 40, 6, "abcAB"));
+                        std::string input = reference::random_string (rng, 500, "abcABx");
+                        StateLayout layout = profile (patterns, config, input);
+                        EXPECT_EQ (layout.fingerprint (), StateLayout::fingerprint (patterns, config));
+                        config.state_layout = &layout;
+                        automaton::ContiguousNFA nfa (patterns, config);
+                        EXPECT_EQ (nfa.layout ().order (), layout.order ());
+                        // profiling again refers to the states by their breadth first index as well
+                        EXPECT_EQ (nfa.profile (std::vector<std::string_view>{input}).num_states (),
+                                   layout.num_states ());
+                        AhoCorasick<automaton::ContiguousNFA> searcher (patterns, config);
+                        EXPECT_EQ (reference::normalized (searcher.find_matches (input), config.match_kind),
+                                   reference::find_all (patterns, input, config.match_kind,
+                                                        config.ascii_case_insensitive)) << "round " << round;
+                }
+}
+
+TEST (StateLayoutTest, SavedLayoutIsLoaded)
+{
+        std::mt19937 rng (480);
+        PatternSet patterns (reference::random_patterns (rng, 50, 6, "abcd"));
+        std::string input = reference::random_string (rng, 1000, "abcde");
+        StateLayout layout = profile (patterns, BuildConfig (), input);
+        StateLayout loaded = load (saved (layout));
+        EXPECT_EQ (loaded.order (), layout.order ());
+        EXPECT_EQ (loaded.fingerprint (), layout.fingerprint ());
+        auto searcher = AhoCorasickBuilder ().automaton_type (AutomatonType::CONTIGUOUS_NFA).state_layout (&loaded)
+            .build (patterns);
+        EXPECT_EQ (reference::normalized (searcher.find_matches (input), MatchKind::STANDARD),
+                   reference::find_all (patterns, input, MatchKind::STANDARD));
+
+        EXPECT_TRUE (load (saved (StateLayout ())).empty ());
+}
+
+TEST (StateLayoutTest, LoadRejectsBadInput)
+{
+        const std::string bytes = saved (StateLayout ({2, 0, 1}, 42));
+        // magic (8 bytes) | fingerprint (8 bytes) | number of states (8 bytes) | order (4 bytes each)
+        ASSERT_EQ (bytes.size (), 36u);
+        std::vector<std::string> bad{"", bytes.substr (0, 7), bytes.substr (0, 20), bytes.substr (0, 24),
+                                     bytes.substr (0, 35)};
+        std::string magic = bytes;
+        magic[0] = 'X';
+        bad.push_back (magic);
+        // a layout of the previous format, without a fingerprint
+        std::string old = bytes;
+        old[7] = '1';
+        bad.push_back (old);
+        for (uint32_t state : {uint32_t{0}, uint32_t{3}, uint32_t{0xFFFFFFFF}})
+                {
+                        // a duplicate or a state out of range
+                        std::string order = bytes;
+                        std::memcpy (order.data () + 24, &state, sizeof (state));
+                        bad.push_back (order);
+                }
+        // more states than the stream holds
+        std::string size = bytes;
+        uint64_t num_states = uint64_t{1} << 40;
+        std::memcpy (size.data () + 16, &num_states, sizeof (num_states));
+        bad.push_back (size);
+        for (size_t i = 0; i < bad.size (); ++i)
+                {
+                        EXPECT_THROW (load (bad[i]), std::runtime_error) << i;
+                }
+        EXPECT_EQ (load (bytes).order (), (std::vector<uint32_t>{2, 0, 1}));
+}
+
+TEST (StateLayoutTest, RejectsLayoutsOfOtherPatternsOrOptions)
+{
+        // both tries have the same shape, so that the layout is a permutation of the states of either
+        PatternSet patterns{"ab", "ac", "b"};
+        std::string input = "abacbx";
+        StateLayout layout = profile (patterns, BuildConfig (), input);
+        BuildConfig config;
+        config.state_layout = &layout;
+        EXPECT_NO_THROW (automaton::ContiguousNFA (patterns, config));
+        EXPECT_THROW (automaton::ContiguousNFA (PatternSet{"xy", "xz", "y"}, config), std::invalid_argument);
+        EXPECT_THROW (automaton::ContiguousNFA (PatternSet{"ac", "ab", "b"}, config), std::invalid_argument);
+        for (int option = 0; option < 4; ++option)
+                {
+                        BuildConfig other = config;
+                        other.match_kind = option == 0 ? MatchKind::LEFTMOST_LONGEST : other.match_kind;
+                        other.ascii_case_insensitive = option == 1;
+                        other.byte_classes = option != 2;
+                        other.whole_words = option == 3;
+                        EXPECT_THROW (automaton::ContiguousNFA (patterns, other), std::invalid_argument) << option;
+                }
+
+        // the right fingerprint, but not a permutation of the states
+        std::vector<uint32_t> order = layout.order ();
+        order.push_back (static_cast<uint32_t> (order.size ()));
+        StateLayout too_large (order, layout.fingerprint ());
+        EXPECT_FALSE (too_large.valid_for (layout.fingerprint (), layout.num_states ()));
+        config.state_layout = &too_large;
+        EXPECT_THROW (automaton::ContiguousNFA (patterns, config), std::invalid_argument);
+        EXPECT_TRUE (layout.valid_for (layout.fingerprint (), layout.num_states ()));
+        EXPECT_FALSE (layout.valid_for (layout.fingerprint () + 1, layout.num_states ()));
+}
@@ -0,0 +1,125 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/utils/thread_pool.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+/// submit a binary tree of tasks of the given depth from within the pool
+void submit_tree (WorkStealingPool &pool, size_t depth, std::atomic<size_t> &runs)
+{
+        pool.submit ([&pool, depth, &runs] (size_t)
+        {
+          runs++;
+          if (depth > 0)
+                  {
+                          submit_tree (pool, depth - 1, runs);
+                          submit_tree (pool, depth - 1, runs);
+                  }
+        });
+}
+
+}  // namespace
+
+TEST (ThreadPoolTest, WaitsForTasksSubmittedByTasks)
+{
+        for (size_t num_threads : {1, 4})
+                {
+                        WorkStealingPool pool (num_threads);
+                        EXPECT_EQ (pool.num_threads (), num_threads);
+                        std::atomic<size_t> runs{0};
+                        submit_tree (pool, 9, runs);
+                        pool.wait ();
+                        EXPECT_EQ (runs, (size_t{1} << 10) - 1);
+                }
+}
+
+TEST (ThreadPoolTest, IdleWorkersStealTasks)
+{
+        WorkStealingPool pool (2);
+        constexpr size_t num_children = 20;
+        std::atomic<size_t> done{0};
+        std::atomic<size_t> stolen{0};
+        std::atomic<bool> all_done{false};
+        pool.submit ([&] (size_t parent)
+        {
+          // the children are put into the queue of this worker, which is busy until they are done, so only the other
+          //  worker can run them
+          for (size_t i = 0; i < num_children; ++i)
+                  {
+                          pool.submit ([&, parent] (size_t worker)
+                          {
+                            stolen += worker != parent;
+                            done++;
+                          });
+                  }
+          auto deadline = std::chrono::steady_clock::now () + std::chrono::seconds (10);
+          while (done < num_children && std::chrono::steady_clock::now () < deadline)
+                  {
+                          std::this_thread::yield ();
+                  }
+          all_done = done == num_children;
+        });
+        pool.wait ();
+        EXPECT_TRUE (all_done);
+        EXPECT_EQ (stolen, num_children);
+}
+
+TEST (ThreadPoolTest, WaitRethrowsTheException)
+{
+        WorkStealingPool pool (3);
+        std::atomic<size_t> runs{0};
+        for (size_t i = 0; i < 50; ++i)
+                {
+                        pool.submit ([&runs, i] (size_t)
+                        {
+                          runs++;
+                          if (i == 10)
+                                  {
+                                          throw std::runtime_error ("task failed");
+                                  }
+                        });
+                }
+        EXPECT_THROW (pool.wait (), std::runtime_error);
+        // the remaining tasks were run nevertheless and the exception is only rethrown once
+        EXPECT_EQ (runs, 50u);
+        pool.submit ([&runs] (size_t)
+        {
+          runs++;
+        });
+        EXPECT_NO_THROW (pool.wait ());
+        EXPECT_EQ (runs, 51u);
+}
+
+TEST (ThreadPoolTest, DestructorRunsQueuedTasks)
+{
+        std::atomic<size_t> runs{0};
+        {
+                WorkStealingPool pool (1);
+                pool.submit ([&runs] (size_t)
+                {
+                  // keep the worker busy, so that the other tasks are still queued when the pool is destroyed
+                  std::this_thread::sleep_for (std::chrono::milliseconds (50));
+                  runs++;
+                });
+                for (size_t i = 0; i < 100; ++i)
+                        {
+                                pool.submit ([&runs] (size_t)
+                                {
+                                  runs++;
+                                });
+                        }
+        }
+        EXPECT_EQ (runs, 101u);
+}
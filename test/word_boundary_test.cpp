@@ -0,0 +1,79 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of lfreist/aho-cohasic.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ac/ahocorasick.h>
+
+#include "reference.h"
+
+namespace {
+
+const AutomatonType TYPES[] = {AutomatonType::NFA, AutomatonType::CONTIGUOUS_NFA, AutomatonType::LAZY_DFA};
+
+std::vector<Match> collect (const std::pmr::vector<Match> &matches)
+{
+        return std::vector<Match> (matches.begin (), matches.end ());
+}
+
+}  // namespace
+
+TEST (WordBoundaryTest, MatchesReference)
+{
+        std::mt19937 rng (38);
+        for (int round = 0; round < 180; ++round)
+                {
+                        auto match_kind = static_cast<MatchKind> (round % 3);
+                        AutomatonType type = TYPES[round / 3 % 3];
+                        bool ignore_case = round % 2 == 1;
+                        // short words of few chars, so that patterns often are prefixes of each other
+                        PatternSet patterns (reference::random_patterns (rng, 1 + rng () % 15, 4, "abA"));
+                        std::string input = reference::random_string (rng, 400, "abA  -");
+                        WordBoundary words ("abAB");
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type).match_kind (match_kind)
+                            .ascii_case_insensitive (ignore_case).whole_words (true).word_chars ("abAB")
+                            .build (patterns);
+                        EXPECT_EQ (reference::normalized (searcher.find_matches (input), match_kind),
+                                   reference::find_all (patterns, input, match_kind, ignore_case, words))
+                                                << type << " round " << round;
+                }
+}
+
+TEST (WordBoundaryTest, LeftmostFirstFallsBackToShadowedWords)
+{
+        // "hat" is no whole word in "hats", but it is added before "hats" and shadows it without whole words
+        for (AutomatonType type : TYPES)
+                {
+                        auto searcher = AhoCorasickBuilder ().automaton_type (type)
+                            .match_kind (MatchKind::LEFTMOST_FIRST).whole_words (true)
+                            .build (PatternSet{"hat", "hats"});
+                        EXPECT_EQ (collect (searcher.find_matches ("hats are nice")), (std::vector<Match>{{1, 0, 4}}))
+                                                << type;
+                        EXPECT_EQ (collect (searcher.find_matches ("a hat")), (std::vector<Match>{{0, 2, 5}})) << type;
+                        EXPECT_EQ (searcher.find_anchored ("hats"), (Match{1, 0, 4})) << type;
+                }
+}
+
+TEST (WordBoundaryTest, LeftmostFirstPrefersTheFirstWholeWord)
+{
+        // all three are whole words at 0, the first one added is reported although it is not the longest
+        auto searcher = AhoCorasickBuilder ().match_kind (MatchKind::LEFTMOST_FIRST).whole_words (true)
+            .word_chars ("ab").build (PatternSet{"ab", "a", "ab-b", "ab-"});
+        EXPECT_EQ (collect (searcher.find_matches ("ab-b a")), (std::vector<Match>{{0, 0, 2}, {1, 5, 6}}));
+        EXPECT_EQ (searcher.find_anchored ("ab-b"), (Match{0, 0, 2}));
+        EXPECT_EQ (searcher.longest_prefix ("ab-b"), (Match{2, 0, 4}));
+}
+
+TEST (WordBoundaryTest, NoMatchWithinWords)
+{
+        auto searcher = AhoCorasickBuilder ().whole_words (true).build (PatternSet{"hat"});
+        EXPECT_TRUE (searcher.find_matches ("that hatter chat").empty ());
+        EXPECT_EQ (collect (searcher.find_matches ("that hat, (hat)")), (std::vector<Match>{{0, 5, 8}, {0, 11, 14}}));
+        // custom word chars: '-' joins words, letters do not
+        auto hyphens = AhoCorasickBuilder ().whole_words (true).word_chars ("-").build (PatternSet{"hat"});
+        EXPECT_EQ (collect (hyphens.find_matches ("that -hat")), (std::vector<Match>{{0, 1, 4}}));
+}